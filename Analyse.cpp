@@ -23,20 +23,38 @@
 #include <ctype.h>
 #include <pthread.h>
 #include <zlib.h>
-#include <unordered_map>
-#include <set>
-#include <string>
 #include <sys/stat.h>
+#include <limits.h>
+#include <atomic>
+#include <new>
 #include "eval.h"
-
-#if defined(_M_X64) || defined(__amd64__)
-#define CONVERSION (unsigned long)
-#else
-#define CONVERSION (unsigned int)
-#endif
+#include "dictionary.h"
+#include "reader.h"
+#include "pipeline.h"
+#include "scheduler.h"
+#include "cache.h"
+#include "store.h"
+#include "stats.h"
+#include "tensor.h"
+#include "bootstrap.h"
+#include "frontier.h"
+#include "pool.h"
+#include "discover.h"
+#include "gzindex.h"
+#include "inflate.h"
+#include "prefetch.h"
+#include "archive.h"
+#include "field.h"
 
 #define BUFFER_SIZE 256  /* Grosseur des tampons */
-#define BOOTSTRAP 10000  /* Nombre d'échantillons bootstrap */
+#define BATCH_SIZE 4096  /* Individus par bloc lors du parsing (défaut) */
+#define SUM_ROWS 16384   /* Individus par total partiel (voir parse_csv) */
+#define CACHE_LINE 64    /* Taille d'une ligne de cache (octets) */
+
+/* Ce qu'un fichier doit produire pour chaque colonne de parse_csv */
+#define SLOT_EVAL    1   /* Évaluée (résultat ou dépendance) */
+#define SLOT_PUBLISH 2   /* Totaux copiés dans les tableaux de résultats */
+#define BOOTSTRAP 10000  /* Nombre d'échantillons bootstrap (défaut) */
 #define SLEEP_TIME 5     /* Taux de rafraichissement du thread affichant la
 			  * progression (en secondes) */
 #define get_CI(std, nb_iters) (1.96 * std) / sqrt (nb_iters) /* Intervalle
@@ -55,12 +73,104 @@ enum {BOOLEAN, ACCUMUL, DISCRETE, CUSTOM_BOOLEAN, LOC_CALC, GLOB_CALC};
 enum {AND, OR, EQ, NE, GT, GE, LT, LE};
 
 /*
- * Sauvegarder la valeur d'une variable pour l'individu en cours.
+ * Résultats possibles d'une comparaison, sous forme de bits: un prédicat
+ * garde le masque des résultats qui le rendent vrai. (UNORD: NaN ou
+ * valeurs discrètes différentes)
+ */
+enum {LT_BIT = 1, EQ_BIT = 2, GT_BIT = 4, UNORD_BIT = 8};
+
+/*
+ * Façons de lire la valeur comparée par un prédicat.
+ */
+enum {NUM_CMP, ID_CMP};
+
+/*
+ * Une comparaison d'une expression booléenne, entièrement résolue lors de
+ * la lecture de la configuration.
+ */
+struct predicate
+{
+  int       slot;     /* Rang de la colonne de la variable */
+  int       kind;     /* NUM_CMP ou ID_CMP */
+  int       mask;     /* Résultats qui rendent la comparaison vraie */
+  int       link;     /* AND ou OR avec le résultat précédent */
+  double    constant; /* Constante déjà convertie */
+  unsigned int id;    /* Identifiant de la constante (ID_CMP) */
+};
+
+/*
+ * Nombre d'individus par valeur d'une variable discrète, indexé par
+ * l'identifiant de la valeur dans le dictionnaire de la variable.
+ */
+struct discrete_counts
+{
+  unsigned int *counts;
+  unsigned int size;
+};
+
+/*
+ * Mode --streaming: statistiques du nombre d'individus par valeur d'une
+ * variable discrète, indexées comme discrete_counts. Seuls les comptes
+ * non nuls y sont ajoutés; les itérations sans la valeur comptent pour
+ * des zéros, ajoutés lors de l'affichage.
+ */
+struct discrete_stats
+{
+  welford      *stats;
+  unsigned int size;
+};
+
+/*
+ * Mode --streaming: les accumulateurs d'un thread (ou d'un scénario
+ * complet, une fois ceux des threads fusionnés). Par scénario: une
+ * colonne par variable accumulatrice, variable booléenne, calcul local
+ * ou conditionnel, expression booléenne et calcul global, dans cet ordre;
+ * une entrée par variable discrète; la première itération où chaque
+ * calcul global a une erreur de champ (-1 sinon).
+ */
+struct stream_part
+{
+  welford      *stats;
+  discrete_stats *discrete;
+  int          *calcs_errors;
+};
+
+/*
+ * Nombre de fichiers traités par un thread, seul sur sa ligne de cache:
+ * les threads ne se nuisent pas en le mettant à jour.
+ */
+struct alignas(CACHE_LINE) progress_counter
+{
+  std::atomic<int> files;
+};
+
+/*
+ * Un gros fichier découpé en tranches aux points de son index d'accès
+ * (gzindex.h), chacune parsée par sa propre tâche. Une tranche couvre des
+ * blocs entiers de SUM_ROWS individus: les totaux de chaque bloc sont
+ * gardés à part, puis additionnés dans l'ordre des blocs par la dernière
+ * tâche à terminer, comme le fait la lecture d'un fichier entier. Le
+ * résultat ne dépend ni du découpage, ni de l'ordre des tâches, ni du
+ * nombre de threads.
  */
-union last_value
+struct file_chunks
 {
-  char      *string_value;
-  double    num_value;
+  gzindex      index;
+  int          count;
+  int          *points;     /* Point où commence la lecture de chaque
+			     * tranche */
+  int          *ends;       /* Point où elle s'arrête */
+  int          *rows;       /* Premier individu de chaque tranche, puis
+			     * la population */
+  std::atomic<int> left;    /* Tranches pas encore terminées */
+
+  /* Les totaux de chaque bloc (variables et calculs), puis les comptes
+   * de chaque tranche (booléens, variables discrètes), à la suite */
+  double       *acc_sums;
+  double       *loc_sums;
+  unsigned int *bool_sums;
+  unsigned int *c_bool_sums;
+  discrete_counts *counts;
 };
 
 /*
@@ -69,7 +179,7 @@ union last_value
 struct pBar_args
 {
   FILE      *progress_file;
-  int       *progress;
+  progress_counter *progress;
   int       total_iters;
   int       threads_count;
 };
@@ -89,51 +199,143 @@ struct pBar_args
 struct thread_args
 {
   /* Expressions booléennes (custom bool) */
-  char         ***data_comp_list;
-  int          **comp_op_list;
-  int          **bool_op_list;
-
-  int          **c_bool_vars_ranks;
+  predicate    **c_bool_preds;
   int          *c_bool_vars_count;
-  unsigned int *c_bool_results;
+  tensor       c_bool_results;
   int          c_bool_count;
 
   /* Calculs locaux et conditionnels */
   char         **loc_list;
+  eval_program *loc_progs;
   int          **loc_vars_ranks;
   int          *loc_vars_count;
-  double       *loc_results;
+  tensor       loc_results;
   int          loc_count; /* loc = loc sans cond. */
 
   int          *cond_vars_rank;
   int          total_loc_count; /* total loc = loc + cond. */
 
   /* Variables booléennes */
-  unsigned int *bool_results;
+  tensor       bool_results;
   int          bool_vars_count;
 
   /* Variables accumulatrices */
-  double       *acc_results;
+  tensor       acc_results;
   int          acc_vars_count;
 
   /* Variables discrètes */
-  unordered_map<string, unsigned int> *discrete_results;
+  discrete_counts *discrete_results;
+  dictionary   *dictionaries;
   int          *vars_types;
   int          discrete_vars_count;
 
-  /* Info sur le scénario à analyser */
-  char         *name;
+  /* Les fichiers à analyser */
+  char         **scenarios_list;
   char         *path;
-  int          num_scen;
-  int          lower_lim;
-  int          upper_lim;
+  scheduler    *tasks;
+  int          worker_id;
+
+  /* Colonnes à produire: tout pour un nouveau fichier, seulement ce qui
+   * manque au fichier binaire pour un fichier déjà parsé */
+  const int    *cached_files;
+  const unsigned char *full_slots;
+  const unsigned char *missing_slots;
+
+  /* Magasins de colonnes (store.h), lus à la place des fichiers texte
+   * lorsqu'ils sont à jour */
+  char         *store_path;
+  const cache_stamp *stamps;
+
+  /* Index d'accès des fichiers texte (gzindex.h), construits pendant la
+   * lecture s'ils ne sont pas à jour, et les fichiers découpés en
+   * tranches (par rang de fichier, NULL: fichier entier) */
+  char         *index_path;
+  file_chunks  **chunked;
+
+  /* Mode --streaming: accumulateurs propres au thread (NULL: totaux
+   * copiés dans les tableaux de résultats), et les calculs globaux qui y
+   * sont évalués fichier par fichier */
+  stream_part  *stream;
+  eval_program *calcs_progs;
+  int          **calcs_relative_ranks;
+  int          **calcs_vars_types;
+  int          calcs_count;
 
   /* Info générale */
-  int          iters_count;
+  const int    *first_files; /* Premier fichier de chaque scénario */
   int          vars_count;
   int          pop;
-  int          *progress;
-  int          progress_id;
+  int          batch_size;
+  pipeline     *inflaters; /* NULL: chaque thread décompresse lui-même */
+  size_t       whole_limit; /* Fichiers décompressés d'un coup */
+  prefetcher   *prefetch;  /* Lecture anticipée (NULL: aucune) */
+  int          readahead;  /* Fichiers lus d'avance par thread */
+  progress_counter *progress;
+};
+
+/*
+ * Les arguments des threads qui transcodent les fichiers (--transcode).
+ */
+struct transcode_args
+{
+  char         **scenarios_list;
+  char         *path;
+  char         *store_path;
+  const cache_stamp *stamps;
+  const unsigned char *bits; /* Variables booléennes */
+  int          vars_count;
+  const int    *first_files;
+  scheduler    *tasks;
+  int          worker_id;
+  size_t       whole_limit; /* Fichiers décompressés d'un coup */
+};
+
+/*
+ * Les options de la ligne de commande (--x=y), communes à tous les
+ * projets.
+ */
+struct analyse_options
+{
+  int           batch_size;
+  int           inflaters_count;
+  int           transcode;
+  int           streaming;
+  long          draws;
+  unsigned long seed;
+  int           threads;  /* Threads de parsing (0: selon la machine) */
+  int           inflate;  /* Moteur de décompression (inflate.h) */
+  size_t        whole_limit; /* Texte maximal d'un fichier décompressé
+			      * d'un coup, selon 'inflate' */
+  int           readahead;   /* Fichiers lus d'avance par thread (0:
+			      * aucun) */
+  int           prefetchers; /* Threads de lecture anticipée (0: un par
+			      * fichier lu d'avance) */
+};
+
+/*
+ * Un projet à analyser: ses arguments (les mêmes que ceux du programme
+ * pour un seul projet), le fichier qui reçoit ses résultats et les
+ * threads de parsing, partagés par tous les projets.
+ */
+struct project_args
+{
+  int           argc;
+  char          **argv;
+  FILE          *out;
+  const analyse_options *options;
+  pool          *workers;
+  int           failed;     /* Erreur dans 'out' (--projects) */
+};
+
+/*
+ * Mode --projects: les projets, pris à tour de rôle par quelques
+ * threads.
+ */
+struct batch_args
+{
+  project_args  *projects;
+  int           projects_count;
+  std::atomic<int> next;
 };
 
 /*
@@ -144,6 +346,7 @@ struct conf_args
   /* Expressions booléennes */
   char        ***data_comp_list;
   char        **bool_labels;
+  predicate   **bool_preds;
   int         **bool_vars_ranks;
   int         **comp_op_list;
   int         **bool_op_list;
@@ -153,6 +356,7 @@ struct conf_args
   /* Calculs globaux */
   char        **calcs_list;
   char        **calcs_labels;
+  eval_program *calcs_progs;
   int         **calcs_relative_ranks;
   int         **calcs_vars_types;
   int         calcs_count;
@@ -160,6 +364,7 @@ struct conf_args
   /* Calculs locaux et conditionnels */
   char        **loc_list;
   char        **loc_labels;
+  eval_program *loc_progs;
   int         **loc_vars_ranks;
   int         *loc_vars_count;
   int         *cond_vars_rank;
@@ -177,6 +382,8 @@ struct conf_args
   /* Variables à ne pas afficher */
   int         *no_show;
 
+  /* Dictionnaires des variables discrètes */
+  dictionary  *dictionaries;
   int         discrete_vars_count;
 };
 
@@ -190,9 +397,10 @@ struct print_func_args
   char         **vars_list;
   int          *vars_types;
 
-  unsigned int *bool_results;
-  double       *acc_results;
-  unordered_map<string, unsigned int> *discrete_results;
+  tensor       bool_results;
+  tensor       acc_results;
+  discrete_counts *discrete_results;
+  dictionary   *dictionaries;
   int          acc_vars_count;
   int          discrete_vars_count;
   int          bool_vars_count;
@@ -200,6 +408,7 @@ struct print_func_args
   /* Calculs globaux */
   char         **calcs_list;
   char         **calcs_labels;
+  eval_program *calcs_progs;
   int          **calcs_relative_ranks;
   int          **calcs_vars_types;
   int          calcs_count;
@@ -207,19 +416,24 @@ struct print_func_args
   /* Calculs locaux et conditionnels */
   char         **loc_list;
   char         **loc_labels;
-  double       *loc_results;
+  tensor       loc_results;
   int          *cond_vars_rank;
   int          loc_count;
   int          total_loc_count;
 
   /* Expressions booléennes */
   char         **c_bool_labels;
-  unsigned int *c_bool_results;
+  tensor       c_bool_results;
   int          c_bool_count;
 
   /* Ce que l'on ne veut pas afficher */
   int          *no_show;
 
+  /* Mode --streaming: les accumulateurs de chaque thread (NULL: les
+   * tableaux de résultats) */
+  stream_part  *stream_parts;
+  int          parts_count;
+
   /* ICER */
   double       *cmp_means;
   double       *cmp_stds;
@@ -237,35 +451,211 @@ struct print_func_args
   int          iters_count;
   int          vars_count;
   int          pop;
+  FILE         *out;  /* Résultats du projet */
 };
 
-void  parse_configuration    (FILE * pConf, conf_args * to_fill,
+int   parse_configuration    (FILE * pConf, conf_args * to_fill,
 			      int *vars_types, char **vars_list,
-			      int vars_count);
+			      int vars_count, FILE *out);
 
-int   find_var_rank          (char *var, int vars_count, char **vars_list);
+int   find_var_rank          (char *var, int vars_count, char **vars_list,
+			      FILE *out);
 
-void  find_var_type_and_rank (char *var, int vars_count, char **vars_list,
+int   find_var_type_and_rank (char *var, int vars_count, char **vars_list,
 			      int *vars_types, int calcs_count,
 			      char **calcs_labels, int loc_count,
 			      char **loc_labels, int bool_count,
-			      char **bool_labels, int *type, int *rank);
+			      char **bool_labels, int *type, int *rank,
+			      FILE *out);
+
+int   check_delim_exist      (char delim, FILE *out);
+
+char  *summary_next          (reader *rd, FILE *out);
 
-void  check_delim_exist      (char delim);
+void  lower_predicate        (predicate *pred, int var_type, int slot,
+			      int comp_op, char *constant,
+			      dictionary *dict);
+
+void  test_predicate         (const predicate *pred, const double *values,
+			      const unsigned int *ids, int rows,
+			      unsigned char *state);
+
+void  grow_counts            (discrete_counts *counts, unsigned int id);
+
+void  grow_stats             (discrete_stats *stats, unsigned int id);
+
+void  load_counts            (discrete_counts *counts, const char *saved,
+			      const unsigned int *ids_map);
+
+void  column_keys            (const conf_args *conf, char **vars_list,
+			      const int *vars_types, int vars_count,
+			      uint64_t *keys);
+
+int   open_store             (const thread_args *args, const char *path,
+			      int file, const unsigned char *slots,
+			      store *st, const char ***keys, double **nums,
+			      unsigned int **ids_map);
+
+file_chunks *chunk_file      (const char *index_file,
+			      const char *store_file,
+			      const cache_stamp *stamp, int pop,
+			      const thread_args *args);
+
+int   merge_chunk            (const thread_args *args, file_chunks *chunks,
+			      int chunk, double *acc_sums,
+			      unsigned int *bool_sums, double *loc_sums,
+			      unsigned int *c_bool_sums,
+			      discrete_counts *counts);
+
+void  free_chunks            (file_chunks *chunks, int discrete_vars_count);
+
+void  close_block            (const thread_args *args, file_chunks *chunks,
+			      int block, double *acc_sums, double *loc_sums,
+			      double *acc_total, double *loc_total);
+
+void  prefetch_task          (const thread_args *args, const task *ahead);
 
 void  *parse_csv             (void *ptr);
 
+void  stream_file            (const thread_args *args, int scen, int iter,
+			      const double *acc_sums,
+			      const unsigned int *bool_sums,
+			      const double *loc_sums,
+			      const unsigned int *c_bool_sums,
+			      discrete_counts *counts);
+
+void  transcode_files        (char **scenarios_list, int scenarios_count,
+			      const int *first_files, char *path,
+			      char *store_path, const cache_stamp *stamps,
+			      const int *vars_types, int vars_count,
+			      int max_threads, size_t whole_limit);
+
+void  *transcode_worker      (void *ptr);
+
 void  *display_progress      (void *ptr);
 
+void  *cache_aligned_alloc   (size_t size);
+
 void  print_results          (print_func_args *args);
 
-int   sort_func              (const void *elem1, const void *elem2);
+int   analyse_project       (project_args *project);
+
+void  *batch_worker          (void *ptr);
 
 int main (int argc, char **argv)
 {
+  /* Les options (--x=y) précèdent les autres arguments. (--help est
+   * laissé au script de lancement) */
+  analyse_options options;
+  char *projects_list = NULL;
+  int  opt_count      = 0;
+
+  options.batch_size      = BATCH_SIZE;
+  options.inflaters_count = 0;
+  options.transcode       = 0;
+  options.streaming       = 0;
+  options.draws           = BOOTSTRAP;
+  options.seed            = time(NULL);
+  options.threads         = 0;
+  options.inflate         = INFLATE_AUTO;
+  options.readahead       = 0;
+  options.prefetchers     = 0;
+
+  while (opt_count + 1 < argc && ! strncmp (argv[opt_count + 1], "--", 2)
+	 && strcmp (argv[opt_count + 1], "--help"))
+    {
+      char *option = argv[++opt_count];
+
+      if (! strncmp (option, "--batch=", 8))
+	{
+	  options.batch_size = atoi (option + 8);
+	  if (options.batch_size < 1)
+	    {
+	      printf("Taille de bloc invalide: %s\n", option);
+	      exit(1);
+	    }
+	}
+      else if (! strncmp (option, "--inflaters=", 12))
+	{
+	  options.inflaters_count = atoi (option + 12);
+	  if (options.inflaters_count < 0)
+	    {
+	      printf("Nombre d'inflaters invalide: %s\n", option);
+	      exit(1);
+	    }
+	}
+      else if (! strcmp (option, "--transcode"))
+	options.transcode = 1;
+      else if (! strcmp (option, "--streaming"))
+	options.streaming = 1;
+      else if (! strncmp (option, "--bootstrap=", 12))
+	{
+	  options.draws = atol (option + 12);
+	  if (options.draws < 1)
+	    {
+	      printf("Nombre d'échantillons bootstrap invalide: %s\n",
+		     option);
+	      exit(1);
+	    }
+	}
+      else if (! strncmp (option, "--seed=", 7))
+	options.seed = strtoul (option + 7, NULL, 10);
+      else if (! strncmp (option, "--projects=", 11))
+	projects_list = option + 11;
+      else if (! strncmp (option, "--inflate=", 10))
+	{
+	  if (! strcmp (option + 10, "auto"))
+	    options.inflate = INFLATE_AUTO;
+	  else if (! strcmp (option + 10, "stream"))
+	    options.inflate = INFLATE_STREAM;
+	  else if (! strcmp (option + 10, "whole"))
+	    options.inflate = INFLATE_WHOLE;
+	  else
+	    {
+	      printf("Moteur de décompression invalide: %s\n", option);
+	      exit(1);
+	    }
+	}
+      else if (! strncmp (option, "--readahead=", 12))
+	{
+	  options.readahead = atoi (option + 12);
+	  if (options.readahead < 0)
+	    {
+	      printf("Nombre de fichiers à lire d'avance invalide: %s\n",
+		     option);
+	      exit(1);
+	    }
+	}
+      else if (! strncmp (option, "--prefetchers=", 14))
+	{
+	  options.prefetchers = atoi (option + 14);
+	  if (options.prefetchers < 1)
+	    {
+	      printf("Nombre de prefetchers invalide: %s\n", option);
+	      exit(1);
+	    }
+	}
+      else if (! strncmp (option, "--threads=", 10))
+	{
+	  options.threads = atoi (option + 10);
+	  if (options.threads < 1)
+	    {
+	      printf("Nombre de threads invalide: %s\n", option);
+	      exit(1);
+	    }
+	}
+      else
+	{
+	  printf("Option inconnue: %s\n", option);
+	  exit(1);
+	}
+    }
+
   /* On appelle le script de lancement qui réappelle le programme avec
-   * le bon nombre d'arguments */
-  if (argc < 5)
+   * le bon nombre d'arguments (le nombre d'itérations peut être "auto":
+   * les scénarios et leurs itérations sont alors trouvés ici) */
+  if (projects_list == NULL && argc - opt_count < 5
+      && (argc - opt_count != 4 || strcmp (argv[opt_count + 3], "auto")))
     {
       char cmd [1024] = "lancer_analyse.sh";
       for (int i = 1; i < argc; i++)
@@ -277,60 +667,314 @@ int main (int argc, char **argv)
       exit (system (cmd));
     }
 
-  /* Erreurs possibles.. */
-  else if (argc == 5)
+  argc -= opt_count;
+  argv += opt_count;
+
+  pool workers;
+  project_args project;
+
+  /* Les threads de parsing: --threads, sinon le nombre donné en ligne
+   * de commande, sinon les processeurs disponibles */
+  if (! options.threads)
     {
-      puts("Aucun scénario à analyser.");
-      exit(1);
+      if (projects_list != NULL ? argc == 3 : argc >= 5)
+	options.threads = atoi (argv[projects_list != NULL ? 2 : 4]);
+      if (options.threads < 1)
+	options.threads = discover_threads ();
+    }
+
+  /* Les fichiers sont lus en même temps par les threads de parsing, ou
+   * par les inflaters (--inflaters) */
+  options.whole_limit = inflate_limit
+    (options.inflate, options.inflaters_count ? options.inflaters_count
+     : options.threads);
+
+  /* Plusieurs projets (balayage univarié): fichier-config et nombre de
+   * threads (facultatif), les projets étant dans la liste */
+  if (projects_list != NULL)
+    {
+      if (argc != 2 && argc != 3)
+	{
+	  puts("Usage: Analyse --projects=liste fichier-config \
+[nb-threads]");
+	  exit(1);
+	}
+
+      FILE *pList = fopen (projects_list, "r");
+      if (pList == NULL)
+	{
+	  printf("Liste de projets inexistante: %s\n", projects_list);
+	  exit(1);
+	}
+
+      /* Une ligne par projet: répertoire, fichier de résultats, puis
+       * (facultatif) nombre d'itérations et scénarios */
+      batch_args batch;
+      char   *line = NULL, *token, *dump;
+      size_t line_size = 0;
+      int    capacity = 8, p, c;
+
+      batch.projects = (project_args*) malloc (sizeof(project_args)
+					       * capacity);
+      batch.projects_count = 0;
+      batch.next = 0;
+
+      char threads_arg [16];
+      snprintf (threads_arg, 16, "%d", options.threads);
+
+      while (getline (&line, &line_size, pList) > 0)
+	{
+	  if (batch.projects_count == capacity)
+	    {
+	      capacity *= 2;
+	      batch.projects = (project_args*) realloc
+		(batch.projects, sizeof(project_args) * capacity);
+	    }
+	  project_args *current = batch.projects + batch.projects_count;
+
+	  /* Les arguments qu'aurait reçus le programme pour ce projet */
+	  current->argv = (char**) malloc (sizeof(char*)
+					   * (strlen (line) + 5));
+	  current->argc = 0;
+	  current->argv[current->argc++] = argv[0];
+
+	  char *path = strtok_r (line, " \t\r\n", &dump);
+	  char *results = strtok_r (NULL, " \t\r\n", &dump);
+	  if (path == NULL)
+	    {
+	      free (current->argv);
+	      continue;
+	    }
+	  current->argv[current->argc++] = strdup (path);
+	  current->argv[current->argc++] = argv[1];
+
+	  for (c = 0; (token = strtok_r (NULL, " \t\r\n", &dump)) != NULL;
+	       ++c)
+	    {
+	      current->argv[current->argc++] = strdup (token);
+	      if (! c)
+		current->argv[current->argc++] = threads_arg;
+	    }
+
+	  if (results == NULL || c == 1)
+	    {
+	      printf("Projet incomplet dans la liste: %s\n", path);
+	      exit(1);
+	    }
+
+	  current->out = fopen (results, "a");
+	  if (current->out == NULL)
+	    {
+	      printf("Incapable d'écrire le fichier: %s\n", results);
+	      exit(1);
+	    }
+	  current->options = &options;
+	  current->workers = &workers;
+	  current->failed  = 0;
+	  batch.projects_count++;
+	}
+      free (line);
+      fclose (pList);
+
+      /* Autant de projets en cours que de threads de parsing: leurs
+       * fichiers sont parsés par les mêmes threads */
+      int threads_count = options.threads;
+      if (threads_count > batch.projects_count)
+	threads_count = batch.projects_count;
+
+      pthread_t *threads_array = (pthread_t*) malloc
+	(sizeof(pthread_t) * (threads_count + 1));
+
+      pool_start (&workers, options.threads);
+      for (p = 0; p < threads_count; ++p)
+	pthread_create (threads_array + p, NULL, batch_worker,
+			(void*) &batch);
+      for (p = 0; p < threads_count; ++p)
+	pthread_join (threads_array[p], NULL);
+      pool_stop (&workers);
+
+      /* Les projets en erreur: leur message est dans leurs résultats */
+      int failed = 0;
+      for (p = 0; p < batch.projects_count; ++p)
+	{
+	  fclose (batch.projects[p].out);
+	  if (batch.projects[p].failed)
+	    {
+	      fprintf(stderr, "Analyse impossible du projet: %s\n",
+		      batch.projects[p].argv[1]);
+	      failed = 1;
+	    }
+	}
+      free (threads_array);
+      return failed;
     }
 
-  int iters_count = atoi(argv[3]);
-  if (!iters_count)
+  project.argc    = argc;
+  project.argv    = argv;
+  project.out     = stdout;
+  project.options = &options;
+  project.workers = &workers;
+
+  pool_start (&workers, options.threads);
+  int failed = analyse_project (&project);
+  pool_stop (&workers);
+
+  return failed;
+}
+
+/*
+ * Mode --projects: analyse les projets de la liste, un à la fois, tant
+ * qu'il en reste. Une ligne par projet terminé (sortie standard) permet
+ * au script de lancement d'afficher ses résultats sans attendre les
+ * autres.
+ */
+void *batch_worker (void *ptr)
+{
+  batch_args *batch = (batch_args*) ptr;
+  project_args *project;
+  int p;
+
+  while ((p = batch->next.fetch_add (1)) < batch->projects_count)
     {
-      puts("Aucune simulation pour le(s) scénario(s).");
-      exit(1);
+      project = batch->projects + p;
+      project->failed = analyse_project (project);
+      fflush (project->out);
+
+      printf("%s: %s\n", project->failed ? "Projet en erreur"
+	     : "Projet terminé", project->argv[1]);
+      fflush (stdout);
     }
 
-  /* Recevoir les scénarios. */
-  int scenarios_count = argc - 5;
+  return NULL;
+}
 
-  /* Shallow copy des arguments en ligne de cmd */
-  char **scenarios_list = (char**) malloc (sizeof(char*) * scenarios_count);
-  for (int i = 0; i < scenarios_count; ++i)
+/*
+ * Analyse un projet: ses arguments sont ceux du programme (répertoire,
+ * fichier-config, nombre d'itérations, nombre de threads, scénarios).
+ * Sans nombre d'itérations ou avec "auto", les scénarios et leurs
+ * itérations sont trouvés dans Results/. Une erreur du projet (données
+ * ou configuration) est écrite dans ses résultats ('out'): retourne
+ * alors 1, sans interrompre les autres projets (--projects).
+ */
+int analyse_project (project_args *project)
+{
+  int  argc = project->argc;
+  char **argv = project->argv;
+  FILE *out = project->out;
+
+  int batch_size      = project->options->batch_size;
+  int inflaters_count = project->options->inflaters_count;
+  int transcode       = project->options->transcode;
+  int streaming       = project->options->streaming;
+  long draws          = project->options->draws;
+  unsigned long seed  = project->options->seed;
+  int threads_count   = project->options->threads;
+  size_t whole_limit  = project->options->whole_limit;
+  int readahead       = project->options->readahead;
+  int prefetchers     = project->options->prefetchers;
+
+  /* Les scénarios et le nombre d'itérations de chacun */
+  char file_path  [BUFFER_SIZE];
+  char **scenarios_list;
+  int  *scen_iters;
+  int  scenarios_count;
+
+  /* Les scénarios archivés (Results/S.tar) sont montés à la place de
+   * leur répertoire, avec leur index dans Analyse/Archives/ (créé avec
+   * le premier index) */
+  char archives_path [BUFFER_SIZE];
+  snprintf (archives_path, BUFFER_SIZE, "%sAnalyse/Archives/", argv[1]);
+  snprintf (file_path, BUFFER_SIZE, "%s/Results/", argv[1]);
+
+  if (argc > 3 && strcmp (argv[3], "auto"))
+    {
+      /* Erreurs possibles.. */
+      if (argc <= 5)
+	{
+	  fprintf(out, "Aucun scénario à analyser.\n");
+	  return 1;
+	}
+
+      int iters_count = atoi(argv[3]);
+      if (!iters_count)
+	{
+	  fprintf(out, "Aucune simulation pour le(s) scénario(s).\n");
+	  return 1;
+	}
+
+      /* Recevoir les scénarios. */
+      scenarios_count = argc - 5;
+
+      /* Shallow copy des arguments en ligne de cmd */
+      char scen_path [BUFFER_SIZE];
+      struct stat scen_stat;
+      scenarios_list = (char**) malloc (sizeof(char*) * scenarios_count);
+      scen_iters     = (int*) malloc (sizeof(int) * scenarios_count);
+      for (int i = 0; i < scenarios_count; ++i)
+	{
+	  scenarios_list[i] = argv[5+i];
+	  scen_iters[i]     = iters_count;
+
+	  /* Une archive, si le scénario n'a pas de répertoire */
+	  snprintf (scen_path, BUFFER_SIZE, "%s%s", file_path, argv[5+i]);
+	  if (stat (scen_path, &scen_stat))
+	    archive_mount (file_path, argv[5+i], archives_path);
+	}
+    }
+  else
     {
-      scenarios_list[i] = argv[5+i];
+      /* Trouvés dans Results/, en parallèle */
+      scenarios_count = discover_scenarios (file_path, archives_path,
+					    project->workers->workers_count,
+					    &scenarios_list, &scen_iters);
+      if (!scenarios_count)
+	{
+	  fprintf(out, "Aucun scénario à analyser.\n");
+	  return 1;
+	}
+
+      for (int i = 0; i < scenarios_count; ++i)
+	if (!scen_iters[i])
+	  {
+	    fprintf(out, "Aucune simulation pour le scénario: %s\n",
+		    scenarios_list[i]);
+	    return 1;
+	  }
     }
 
+  /* Le rang du premier fichier de chaque scénario: le nombre
+   * d'itérations peut varier d'un scénario à l'autre */
+  int *first_files = (int*) malloc (sizeof(int) * (scenarios_count + 1));
+  first_files[0] = 0;
+  for (int i = 0; i < scenarios_count; ++i)
+    first_files[i + 1] = first_files[i] + scen_iters[i];
+
   /* Ouvrir un fichier Output.gz pour extraire certaines infos. */
-  char file_path  [BUFFER_SIZE];
   strcpy (file_path, argv[1]);
   strcat (file_path, "/Results/");
   strcat (file_path, scenarios_list[0]);
   strcat (file_path, "/0_Output.gz");
 
-  gzFile pFile = gzopen (file_path, "rb");
-  if (pFile == Z_NULL)
+  reader pFile;
+  if (! reader_open (&pFile, file_path, READER_BLOCK, whole_limit))
     {
-      printf("Mauvais chemin ou fichier inexistant: %s\n", file_path);
-      exit(1);
+      fprintf(out, "Mauvais chemin ou fichier inexistant: %s\n", file_path);
+      return 1;
     }
 
-  /* Pour comparaison plus tard avec fichier binaire */
-  struct stat modif_time_buff;
-
-  stat (file_path, &modif_time_buff);
-  time_t last_modif_Gz = modif_time_buff.st_mtime;
+  char *row;
+  size_t row_length;
 
-  char line [BUFFER_SIZE];
-
-  gzgets (pFile, line, BUFFER_SIZE);
-  gzgets (pFile, line, BUFFER_SIZE);
+  /* L'en-tête, puis le premier individu */
+  reader_next (&pFile, &row_length);
+  row = reader_next (&pFile, &row_length);
 
   int  vars_count = 0;
-  char *pch       = line;
+  char *pch       = row != NULL ? row : (char*) "";
+  char *dump; /* Pour rendre strtok thread-safe (--projects) */
 
   /* Compter le nombre de variables */
-  while (*pch != '\n')
+  while (*pch)
     {
       if (*pch == ',')
 	vars_count++;
@@ -339,8 +983,9 @@ int main (int argc, char **argv)
 
   if (!vars_count)
     {
-      printf("Aucune variable détectée dans le fichier: %s\n", file_path);
-      exit(1);
+      fprintf(out, "Aucune variable détectée dans le fichier: %s\n",
+	      file_path);
+      return 1;
     }
 
   int *vars_types = (int*) malloc (sizeof(int) * vars_count);
@@ -349,11 +994,11 @@ int main (int argc, char **argv)
   /* Les types sont trouvés automatiquement. Le type accumulateur
    * peut être changé en type discret par le fichier de conf.
    */
-  strtok (line,",");
+  strtok_r (row,",", &dump);
   for (int i = 0; i < vars_count; ++i)
     {
-      pch = strtok (NULL, ",");
-      if ( strncmp(pch, "true", 4) && strncmp(pch, "false", 5) )
+      pch = strtok_r (NULL, ",", &dump);
+      if ( ! is_true (pch) && ! is_false (pch) )
 	vars_types[i] = ACCUMUL ;
       else
 	{
@@ -362,17 +1007,16 @@ int main (int argc, char **argv)
 	}
     }
 
-  gzclose (pFile);
+  reader_close (&pFile);
 
   /* Ouvrir un fichier Summary.gz pour extraire certaines infos */
   strcpy(file_path+strlen(argv[1])+9+strlen(scenarios_list[0]),
 	 "/0_Summary.gz");
 
-  pFile = gzopen(file_path, "rb");
-  if (pFile == Z_NULL)
+  if (! reader_open (&pFile, file_path, READER_BLOCK, whole_limit))
     {
-      printf("Mauvais chemin ou fichier inexistant: %s\n", file_path);
-      exit(1);
+      fprintf(out, "Mauvais chemin ou fichier inexistant: %s\n", file_path);
+      return 1;
     }
 
   char **vars_list = (char**) malloc (sizeof(char*) * vars_count);
@@ -383,46 +1027,52 @@ int main (int argc, char **argv)
   /* La population: additionner les sous-populations. Les variables
    * doivent être les mêmes dans toutes les sous-populations: ceci est
    * est vérifié.  */
-  while (gzgets(pFile, line, BUFFER_SIZE) != Z_NULL)
+  while ((row = reader_next (&pFile, &row_length)) != NULL)
     {
-      pch = strstr(line, "size=\"");
+      pch = strstr(row, "size=\"");
       if (pch != NULL)
 	{
-	  pop += atoi(strtok(pch+6, "\""));
+	  pop += atoi(strtok_r (pch+6, "\"", &dump));
 	  check_nb_vars = 0;
 
 	  /* Vrai seulement s'il s'agit d'une sous-population */
 	  if (done_names_vars)
 	    {
-	      gzgets(pFile, line, BUFFER_SIZE);
+	      row = summary_next (&pFile, out);
 
-	      while ( strstr (line, "</SubPopulation>") == NULL )
+	      while (row != NULL && strstr (row, "</SubPopulation>") == NULL)
 		{
-		  strtok (line, "\"");
-		  pch = strtok (NULL, "\"");
+		  strtok_r (row, "\"", &dump);
+		  pch = strtok_r (NULL, "\"", &dump);
 
 		  if ( strcmp (vars_list[check_nb_vars++], pch) )
 		    {
-		      printf ("La variable '%s' diffère de la population \
+		      fprintf(out, "La variable '%s' diffère de la population \
 principale. Impossible d'effectuer l'analyse.", pch);
-		      exit(1);
+		      return 1;
 		    }
 
 		  if (check_nb_vars > vars_count)
 		    {
-		      puts("Trop de variables dans une des \
-sous-populations.");
-		      exit(1);
+		      fprintf(out, "Trop de variables dans une des \
+sous-populations.\n");
+		      return 1;
 		    }
 
-		  gzgets(pFile, line, BUFFER_SIZE);
+		  row = summary_next (&pFile, out);
+		}
+
+	      if (row == NULL)
+		{
+		  reader_close (&pFile);
+		  return 1;
 		}
 
 	      if (check_nb_vars != vars_count)
 		{
-		  puts("Pas assez de variables dans une des \
-sous-populations.");
-		  exit(1);
+		  fprintf(out, "Pas assez de variables dans une des \
+sous-populations.\n");
+		  return 1;
 		}
 	    }
 	  else
@@ -431,10 +1081,15 @@ sous-populations.");
 	       * en mémoire. */
 	      for (int i = 0; i < vars_count; i++)
 		{
-		  gzgets(pFile, line, BUFFER_SIZE);
+		  row = summary_next (&pFile, out);
+		  if (row == NULL)
+		    {
+		      reader_close (&pFile);
+		      return 1;
+		    }
 
-		  strtok (line, "\"");
-		  pch = strtok (NULL, "\"");
+		  strtok_r (row, "\"", &dump);
+		  pch = strtok_r (NULL, "\"", &dump);
 		  vars_list[i] = (char*) malloc (strlen(pch)+1);
 		  strcpy (vars_list[i], pch);
 		}
@@ -443,12 +1098,13 @@ sous-populations.");
 	}
     }
 
-  gzclose (pFile);
+  reader_close (&pFile);
 
   if (!pop)
     {
-      printf("Aucune population détectée dans le fichier: %s\n", file_path);
-      exit(1);
+      fprintf(out, "Aucune population détectée dans le fichier: %s\n",
+	      file_path);
+      return 1;
     }
 
   /* Configuration de l'usager */
@@ -457,9 +1113,11 @@ sous-populations.");
 
   if (pConf != NULL)
     {
-      parse_configuration (pConf, &current_conf, vars_types, vars_list,
-			   vars_count);
+      int failed = parse_configuration (pConf, &current_conf, vars_types,
+					vars_list, vars_count, out);
       fclose (pConf);
+      if (failed)
+	return 1;
     }
   else
     {
@@ -467,6 +1125,7 @@ sous-populations.");
        * normalement un template vide si aucun fichier de configuration
        * n'est présent, qui pourra quand même être ouvert et analyser. */
       current_conf.discrete_vars_count = 0;
+      current_conf.dictionaries        = NULL;
       current_conf.calcs_count         = 0;
       current_conf.loc_count           = 0;
       current_conf.total_loc_count     = 0;
@@ -489,339 +1148,498 @@ sous-populations.");
   int acc_vars_count = vars_count - current_conf.discrete_vars_count
     - bool_vars_count;
 
-  /* Alloué sur le monceau pour ne pas risquer de faire exploser la pile
-   * dans les  grosses simulations (plusieurs scénarios, plusieurs
-   * variables, etc.)
-   */
-  double *acc_results = (double*) malloc (sizeof(double) * scenarios_count
-					  * acc_vars_count * iters_count);
-
-  unsigned int *bool_results = (unsigned int*) malloc (sizeof(unsigned int)
-     * bool_vars_count * scenarios_count * iters_count);
+  /* Le nom du fichier binaire: nom du fichier de configuration avec son
+   * extension remplacée par '.aux' */
+  char bin_path [BUFFER_SIZE];
+  strcpy (bin_path, argv[1]);
+  strcat (bin_path, "Analyse/");
 
-  unordered_map <string, unsigned int> *discrete_vars =
-    new unordered_map <string, unsigned int>
-    [scenarios_count * iters_count * current_conf.discrete_vars_count];
+  /* (sans modifier argv[2]: il sert à tous les projets avec
+   * --projects) */
+  pch = strrchr (argv[2], '/');
+  strcat (bin_path, pch != NULL ? pch : argv[2]);
 
-  double *loc_results = (double*) malloc (sizeof(double) * scenarios_count
-     * current_conf.total_loc_count * iters_count);
+  pch = strrchr (strrchr (bin_path, '/'), '.');
+  if (pch != NULL)
+    *pch = NUL;
 
-  unsigned int *c_bool_results = (unsigned int*)
-    malloc (sizeof(unsigned int) * current_conf.bool_count
-	    * scenarios_count * iters_count);
+  strcat (bin_path, ".aux");
 
-  /* Pour le passage d'arguments à la fonction qui affiche les résultats */
-  print_func_args *print_args = (print_func_args*) malloc
-    (sizeof(print_func_args) * scenarios_count);
+  int i, v;
 
-  print_args[0].vars_list            = vars_list;
-  print_args[0].vars_types           = vars_types;
-  print_args[0].name                 = scenarios_list[0];
+  /* Empreinte de chaque fichier de résultats: un fichier déjà parsé dont
+   * l'empreinte n'a pas changé est repris du fichier binaire. Les tailles
+   * servent aussi à ordonner le parsing. */
+  strcpy (file_path, argv[1]);
+  strcat (file_path, "/Results/");
 
-  print_args[0].calcs_list           = current_conf.calcs_list;
-  print_args[0].calcs_labels         = current_conf.calcs_labels;
-  print_args[0].calcs_relative_ranks = current_conf.calcs_relative_ranks;
-  print_args[0].calcs_vars_types     = current_conf.calcs_vars_types;
+  int files_count = first_files[scenarios_count];
+  cache_stamp *stamps = (cache_stamp*) malloc (sizeof(cache_stamp)
+					       * files_count);
+  char task_path [BUFFER_SIZE];
+  archive_member member;
 
-  print_args[0].bool_results         = bool_results;
-  print_args[0].acc_results          = acc_results;
-  print_args[0].discrete_results     = discrete_vars;
+  /* Un membre d'archive a l'empreinte de son en-tête tar (taille, date)
+   * et l'inode de l'archive */
+  for (i = 0; i < scenarios_count; ++i)
+    for (v = 0; v < scen_iters[i]; ++v)
+      {
+	/* Fichier inexistant: l'erreur est signalée lors du parsing */
+	snprintf (task_path, BUFFER_SIZE, "%s%s/%d_Output.gz", file_path,
+		  scenarios_list[i], v);
+	if (archive_find (task_path, &member))
+	  stamps[first_files[i] + v] = member.stamp;
+	else
+	  cache_stamp_file (stamps + first_files[i] + v, task_path);
+      }
+
+  /* Les magasins de colonnes: un répertoire par scénario */
+  char store_path [BUFFER_SIZE];
+  strcpy (store_path, argv[1]);
+  strcat (store_path, "Analyse/Colonnes/");
+
+  /* Les index d'accès des fichiers texte: un répertoire par scénario */
+  char index_path [BUFFER_SIZE];
+  strcpy (index_path, argv[1]);
+  strcat (index_path, "Analyse/Index/");
+
+  if (transcode)
+    transcode_files (scenarios_list, scenarios_count, first_files,
+		     file_path, store_path, stamps, vars_types, vars_count,
+		     threads_count, whole_limit);
+
+  /* Vérifier si on a déjà fait le parsing avec les mêmes options. Si oui,
+   * reprendre les fichiers qui n'ont pas changé et les colonnes dont la
+   * définition n'a pas changé: seul le reste est parsé.
+   */
+  int loc_count    = current_conf.total_loc_count;
+  int c_bool_count = current_conf.bool_count;
+  int dvars_count  = current_conf.discrete_vars_count;
+  int slots_count  = vars_count + loc_count + c_bool_count;
+  int g, j, k, c;
+
+  /* La clé de chaque colonne de parse_csv, puis la colonne de chaque
+   * groupe: variables accumulatrices, booléennes, calculs locaux et
+   * conditionnels, expressions booléennes, variables discrètes */
+  uint64_t *slot_keys = (uint64_t*) malloc (sizeof(uint64_t)
+					    * (slots_count + 1));
+  column_keys (&current_conf, vars_list, vars_types, vars_count,
+	       slot_keys);
+
+  int groups_count [CACHE_GROUPS] = { acc_vars_count, bool_vars_count,
+				      loc_count, c_bool_count,
+				      dvars_count };
+  int *groups_slots [CACHE_GROUPS];
+  uint64_t *groups_keys [CACHE_GROUPS];
+
+  for (g = 0; g < CACHE_GROUPS; ++g)
+    {
+      groups_slots[g] = (int*) malloc (sizeof(int) * (groups_count[g] + 1));
+      groups_keys[g]  = (uint64_t*) malloc (sizeof(uint64_t)
+					    * (groups_count[g] + 1));
+      groups_count[g] = 0;
+    }
 
-  print_args[0].cmp_means            = cmp_means;
-  print_args[0].cmp_stds             = cmp_stds;
-  print_args[0].ICR_vars_means       = ICR_vars_means;
-  print_args[0].ICR_vars_stds        = ICR_vars_stds;
-  print_args[0].ICR_vars_ranks       = current_conf.ICR_vars_ranks;
-  print_args[0].ICR_vars_types       = current_conf.ICR_vars_types;
-  print_args[0].cmp_rank             = current_conf.ICR_cmp_rank;
-  print_args[0].cmp_type             = current_conf.ICR_cmp_type;
-  print_args[0].calcs_count          = current_conf.calcs_count;
-
-  print_args[0].num_scen             = 0;
-  print_args[0].pop                  = pop;
-  print_args[0].ICR_vars_count       = current_conf.ICR_vars_count;
-  print_args[0].iters_count          = iters_count;
-  print_args[0].vars_count           = vars_count;
-
-  print_args[0].acc_vars_count       = acc_vars_count;
-  print_args[0].discrete_vars_count  = current_conf.discrete_vars_count;
-  print_args[0].bool_vars_count      = bool_vars_count;
-  print_args[0].loc_count            = current_conf.loc_count;
-
-  print_args[0].loc_list             = current_conf.loc_list;
-  print_args[0].loc_labels           = current_conf.loc_labels;
-  print_args[0].loc_results          = loc_results;
-
-  print_args[0].c_bool_count         = current_conf.bool_count;
-  print_args[0].c_bool_labels        = current_conf.bool_labels;
-  print_args[0].c_bool_results       = c_bool_results;
-
-  print_args[0].no_show              = current_conf.no_show;
-
-  print_args[0].total_loc_count      = current_conf.total_loc_count;
-  print_args[0].cond_vars_rank       = current_conf.cond_vars_rank;
-
-  for (int i = 1; i < scenarios_count; i++)
+  for (i = 0; i < vars_count; ++i)
     {
-      print_args[i] = print_args[0]; /* deep copy */
+      g = vars_types[i] == ACCUMUL ? 0 : vars_types[i] == BOOLEAN ? 1 : 4;
+      groups_slots[g][groups_count[g]++] = i;
+    }
+  for (i = 0; i < loc_count; ++i)
+    groups_slots[2][groups_count[2]++] = i < current_conf.loc_count ?
+      vars_count + i : vars_count + c_bool_count + i;
+  for (i = 0; i < c_bool_count; ++i)
+    groups_slots[3][groups_count[3]++] = vars_count
+      + current_conf.loc_count + i;
+
+  for (g = 0; g < CACHE_GROUPS; ++g)
+    for (j = 0; j < groups_count[g]; ++j)
+      groups_keys[g][j] = slot_keys[groups_slots[g][j]];
+
+  /* En mode --streaming, les résultats de chaque fichier ne sont pas
+   * gardés: le fichier binaire n'est ni lu ni écrit */
+  cache_map   cache;
+  cache_index index;
+  int same = streaming ? CACHE_STALE
+    : cache_open (&cache, bin_path, CACHE_LAYOUT_SCEN_ITER_VAR);
+
+  if (same == CACHE_VALID)
+    {
+      if (! cache_index_load (&index, &cache)
+	  || cache_section_size (&cache, CACHE_ACC) != sizeof(double)
+	  * index.files_count * index.columns_count[0]
+	  || cache_section_size (&cache, CACHE_BOOL) != sizeof(unsigned int)
+	  * index.files_count * index.columns_count[1]
+	  || cache_section_size (&cache, CACHE_LOC) != sizeof(double)
+	  * index.files_count * index.columns_count[2]
+	  || cache_section_size (&cache, CACHE_C_BOOL) != sizeof(unsigned int)
+	  * index.files_count * index.columns_count[3])
+	same = CACHE_CORRUPT;
+    }
+  else
+    {
+      index.scenarios_count = 0;
+      index.files_count     = 0;
+      for (g = 0; g < CACHE_GROUPS; ++g)
+	{
+	  index.columns_count[g] = 0;
+	  index.columns[g]       = NULL;
+	}
+    }
 
-      print_args[i].num_scen = i;
-      print_args[i].name     = scenarios_list[i];
+  if (same == CACHE_CORRUPT)
+    {
+      fprintf(out, "Fichier binaire '%s' corrompu. Il est conseillé de le \
+supprimer et de relancer ce programme.\n", bin_path);
+      cache_close (&cache);
+      return 1;
     }
 
-  /* Vérifier si on a déjà fait le parsing avec les mêmes options.
-   * Si oui, charger ces données en mémoire. Sinon, faire le parsing.
-   */
-  int *vars_types_check = (int*) malloc (sizeof(int) * vars_count);
-  int same = 0;
+  /* Rang dans le fichier binaire de chaque colonne, ou -1 si elle doit
+   * être calculée */
+  int *cached_columns [CACHE_GROUPS];
+  int missing  = 0;
+  int in_place = 1;
 
-  /* Le nom du fichier binaire: nom du fichier de configuration avec son
-   * extension remplacée par '.aux' */
-  char bin_path [BUFFER_SIZE];
-  strcpy (bin_path, argv[1]);
-  strcat (bin_path, "Analyse/");
+  unsigned char *full_slots    = (unsigned char*) malloc (slots_count + 1);
+  unsigned char *missing_slots = (unsigned char*) calloc (slots_count + 1,
+							  1);
+  memset (full_slots, SLOT_EVAL | SLOT_PUBLISH, slots_count + 1);
 
-  pch = argv[2];
+  for (g = 0; g < CACHE_GROUPS; ++g)
+    {
+      cached_columns[g] = (int*) malloc (sizeof(int)
+					 * (groups_count[g] + 1));
+      in_place = in_place && index.columns_count[g] == groups_count[g];
 
-  while (*pch)
-    pch++;
+      for (j = 0; j < groups_count[g]; ++j)
+	{
+	  c = cache_index_column (&index, g, groups_keys[g][j]);
+	  cached_columns[g][j] = c;
+	  in_place = in_place && c == j;
 
-  while (*pch != '/' && *pch != '.' && pch != argv[2])
-    pch--;
+	  if (c < 0)
+	    {
+	      missing_slots[groups_slots[g][j]] = SLOT_EVAL | SLOT_PUBLISH;
+	      missing = 1;
+	    }
+	}
+    }
 
-  if (*pch == '.')
-    *pch = NUL;
+  /* Les colonnes manquantes doivent être évaluées, et aussi celles dont
+   * elles dépendent (jusqu'à ce que rien ne change) */
+  int changed = missing;
+  while (changed)
+    {
+      changed = 0;
+      for (i = 0; i < slots_count; ++i)
+	{
+	  if (! missing_slots[i] || i < vars_count)
+	    continue;
 
-  while (*pch != '/' && pch != argv[2])
-    pch--;
+	  int *deps, deps_count, cond_slot = -1;
 
-  strcat (bin_path, pch);
-  strcat (bin_path, ".aux");
+	  if (i >= vars_count + current_conf.loc_count
+	      && i < vars_count + current_conf.loc_count + c_bool_count)
+	    {
+	      /* Expression booléenne */
+	      k = i - vars_count - current_conf.loc_count;
+	      for (v = 0; v < current_conf.bool_vars_count[k]; ++v)
+		if (! missing_slots[current_conf.bool_preds[k][v].slot])
+		  {
+		    missing_slots[current_conf.bool_preds[k][v].slot]
+		      = SLOT_EVAL;
+		    changed = 1;
+		  }
+	      continue;
+	    }
 
-  FILE * pBin = fopen ( bin_path , "rb");
+	  /* Calcul local ou conditionnel */
+	  k = i < vars_count + current_conf.loc_count ? i - vars_count
+	    : i - vars_count - c_bool_count;
+	  deps       = current_conf.loc_vars_ranks[k];
+	  deps_count = current_conf.loc_vars_count[k];
+	  if (k >= current_conf.loc_count)
+	    cond_slot = current_conf.cond_vars_rank[k - current_conf.loc_count];
 
-  /* Vérifie le nombre de lectures faites sur le fichier .aux */
-  unsigned int read_count ;
-  int keys_read_count = 0 ;
-  int arg_counter     = 0 ;
+	  for (v = 0; v < deps_count; ++v)
+	    if (! missing_slots[deps[v]])
+	      {
+		missing_slots[deps[v]] = SLOT_EVAL;
+		changed = 1;
+	      }
 
-  /* Vérifie qu'il n'y a pas de dépassements de tampon lors de la
-   * vérification de calculs/expressions */
-  int buff_overflow = 0;
-  int finished      = 0; /* remplace des gotos (qui aurait pu être
-			  * laissés et éviteraient des vérif. inutiles) */
-  int i, v;
+	  if (cond_slot >= 0 && ! missing_slots[cond_slot])
+	    {
+	      missing_slots[cond_slot] = SLOT_EVAL;
+	      changed = 1;
+	    }
+	}
+    }
 
-  if (pBin != NULL)
-    {
-      /* Fichier binaire existe: vérification que rien n'a changé. Voir
-       * comment se fait la sérialization plus loins pour comprendre
-       * comment le fichier binaire est décrypté.*/
-      same = 1;
-      read_count = fread (vars_types_check, sizeof(int), vars_count, pBin);
+  /* Rang dans le fichier binaire de chaque fichier, ou -1 s'il doit être
+   * parsé au complet. Si tout est repris, dans le même ordre, les
+   * tenseurs sont utilisés sur place. */
+  int *cached_files = (int*) malloc (sizeof(int) * files_count);
+  char *used_segments = (char*) calloc (index.scenarios_count + 1, 1);
+  int tasks_count   = 0;
+  int segment;
 
-      int it_nb, loc_nb, c_bool_nb;
-      read_count += fread (&it_nb, sizeof(int), 1 , pBin);
-      read_count += fread (&loc_nb, sizeof(int), 1, pBin);
-      read_count += fread (&c_bool_nb, sizeof(int), 1, pBin);
+  in_place = in_place && index.scenarios_count == scenarios_count;
 
-      if (loc_nb != current_conf.total_loc_count ||
-	  c_bool_nb != current_conf.bool_count ||
-          it_nb != iters_count)
-	{
-	  same = 0;
-	  finished = 1;
-	}
+  for (i = 0; i < scenarios_count; ++i)
+    {
+      segment  = cache_index_find (&index, scenarios_list[i]);
+      in_place = in_place && segment == i
+	&& index.iters_count[i] == scen_iters[i];
+      if (segment >= 0)
+	used_segments[segment] = 1;
 
-      int str_size;
-      /* Calculs locaux */
-      for (i = 0; i < current_conf.loc_count && !finished; i++)
+      for (v = first_files[i]; v < first_files[i + 1]; ++v)
 	{
-	  read_count += fread (&str_size, sizeof(int), 1, pBin);
-	  if ( str_size > BUFFER_SIZE )
+	  k = v - first_files[i];
+	  if (segment >= 0 && k < index.iters_count[segment]
+	      && ! memcmp (stamps + v,
+			   index.stamps + index.first[segment] + k,
+			   sizeof(cache_stamp)))
+	    cached_files[v] = index.first[segment] + k;
+	  else
 	    {
-	      buff_overflow = finished = 1;
-	      break;
+	      cached_files[v] = -1;
+	      in_place = 0;
 	    }
 
-	  read_count += fread (line, str_size, 1, pBin);
-
-	  if ( strncmp (line, current_conf.loc_list[i], BUFFER_SIZE))
-	    {
-	      same = 0;
-	      finished = 1;
-	      break;
-	    }
+	  /* Parsé au complet, ou seulement pour les colonnes manquantes */
+	  if (cached_files[v] < 0 || missing)
+	    tasks_count++;
 	}
+    }
 
-      /* Calculs conditionnels */
-      int cond_var_rank;
-      for (i = current_conf.loc_count; i < current_conf.total_loc_count
-	     && !finished;
-	   i++)
-	{
-	  read_count += fread (&str_size, sizeof(int), 1, pBin);
-	  if ( str_size > BUFFER_SIZE )
-	    {
-	      buff_overflow = finished = 1;
-	      break;
-	    }
+  /* Les tenseurs de résultats, et ceux du fichier binaire (lignes
+   * accessibles par rang de fichier seulement: segments de tailles
+   * diverses) */
+  tensor acc_results, bool_results, loc_results, c_bool_results;
+  tensor cached_acc, cached_bool, cached_loc, cached_c_bool;
+
+  /* Dans l'ordre des groupes du fichier binaire (sans les variables
+   * discrètes) */
+  tensor *results [CACHE_GROUPS - 1] = { &acc_results, &bool_results,
+					 &loc_results, &c_bool_results };
+  tensor *cached  [CACHE_GROUPS - 1] = { &cached_acc, &cached_bool,
+					 &cached_loc, &cached_c_bool };
+  const int tensors_types [CACHE_GROUPS - 1] = { TENSOR_F64, TENSOR_U32,
+						 TENSOR_F64, TENSOR_U32 };
+  size_t elem_size;
+
+  for (g = 0; g < CACHE_GROUPS - 1; ++g)
+    {
+      tensor_init (cached[g], tensors_types[g], same == CACHE_VALID ?
+		   cache_section_data (&cache, CACHE_ACC + g) : NULL, NULL,
+		   index.columns_count[g]);
+
+      if (in_place)
+	/* Utilisés sur place, sans copie */
+	tensor_init (results[g], tensors_types[g], cached[g]->data,
+		     first_files, groups_count[g]);
+      else if (streaming)
+	/* Accumulés par scénario pendant le parsing */
+	tensor_init (results[g], tensors_types[g], NULL, first_files,
+		     groups_count[g]);
+      else
+	tensor_alloc (results[g], tensors_types[g], files_count,
+		      first_files, groups_count[g]);
+    }
 
-	  read_count += fread (line, str_size, 1, pBin);
-	  read_count += fread (&cond_var_rank, sizeof(int), 1, pBin);
+  /* Les colonnes reprises sont recopiées à leur place */
+  for (i = 0; i < files_count && ! in_place; ++i)
+    {
+      if ((c = cached_files[i]) < 0)
+	continue;
 
-	  if (strncmp(line, current_conf.loc_list[i], BUFFER_SIZE)
-	      || cond_var_rank !=
-	      current_conf.cond_vars_rank[i - current_conf.loc_count])
-	    {
-	      same = 0;
-	      finished = 1;
-	      break;
-	    }
+      for (g = 0; g < CACHE_GROUPS - 1; ++g)
+	{
+	  elem_size = tensor_elem_size (results[g]);
+
+	  for (j = 0; j < groups_count[g]; ++j)
+	    if (cached_columns[g][j] >= 0)
+	      memcpy ((char*) tensor_row (results[g], i) + j * elem_size,
+		      (char*) tensor_row (cached[g], c)
+		      + cached_columns[g][j] * elem_size, elem_size);
 	}
+    }
 
-      int arg_nb;
-      int oper;
-      /* Expressions booléennes  */
-      for (i = 0; i < current_conf.bool_count && !finished; i++)
-	{
-	  read_count += fread (&arg_nb, sizeof(int), 1, pBin);
-	  arg_counter += arg_nb;
+  discrete_counts *discrete_vars = (discrete_counts*) calloc
+    ((streaming ? 0 : files_count * dvars_count) + 1,
+     sizeof(discrete_counts));
 
-	  if ( arg_nb != current_conf.bool_vars_count[i] )
-	    {
-	      same = 0;
-	      finished = 1;
-	      break;
-	    }
+  /* Les identifiants sauvegardés ne correspondent pas forcément à ceux du
+   * dictionnaire courant (constantes des expressions booléennes déjà
+   * ajoutées): table de correspondance, pour chaque variable discrète du
+   * fichier binaire qui est encore utilisée */
+  int cached_dvars = index.columns_count[4];
+  unsigned int **ids_map = (unsigned int**) calloc
+    (cached_dvars + 1, sizeof(unsigned int*));
 
-	  for (v = 0; v < arg_nb && !finished; v++)
-	  {
-	    read_count += fread (&str_size, sizeof(int), 1, pBin);
-	    if ( str_size > BUFFER_SIZE )
-	      {
-		buff_overflow = finished = 1;
-		break;
-	      }
+  /* Position des comptes de chaque fichier du fichier binaire */
+  const char **cached_counts = (const char**) malloc
+    (sizeof(char*) * (index.files_count * cached_dvars + 1));
 
-	    read_count += fread (line, str_size, 1, pBin);
-	    read_count += fread (&oper, sizeof(int), 1, pBin);
+  if (same == CACHE_VALID)
+    {
+      cache_cursor cursor;
+      const char *key;
+      int corrupt = 0;
+      unsigned int keys_count, counts_size;
+      int current_key_size;
+      double num;
 
-	    if ( strncmp (line, current_conf.data_comp_list[i][v],
-			  BUFFER_SIZE)
-		 || oper != current_conf.comp_op_list[i][v] )
-	      {
-		same = 0;
-		finished = 1;
-		break;
-	      }
-	  }
+      unsigned int *ids_count = (unsigned int*) malloc
+	(sizeof(unsigned int) * (cached_dvars + 1));
 
-	  for (v = 0; v < arg_nb - 1 && !finished; v++)
-	    {
-	      read_count += fread(&oper, sizeof(int), 1, pBin);
+      cache_cursor_init (&cursor, &cache, CACHE_KEYS);
 
-	      if (oper != current_conf.bool_op_list[i][v])
+      for (i = 0; i < cached_dvars; ++i)
+	{
+	  /* La variable courante qui reprend cette colonne */
+	  for (j = 0; j < dvars_count && cached_columns[4][j] != i; ++j)
+	    ;
+
+	  keys_count = 0;
+	  corrupt |= ! cache_cursor_read (&cursor, &keys_count,
+					  sizeof(unsigned int));
+	  if (keys_count > cache_section_size (&cache, CACHE_KEYS))
+	    corrupt = 1;
+	  if (corrupt)
+	    keys_count = 0;
+
+	  ids_map[i] = (unsigned int*) malloc (sizeof(unsigned int)
+					       * (keys_count + 1));
+	  ids_count[i] = keys_count;
+
+	  for (v = 0; v < (int) keys_count && !corrupt; ++v)
+	    {
+	      current_key_size = 0;
+	      cache_cursor_read (&cursor, &current_key_size, sizeof(int));
+	      key = current_key_size < 1 ? NULL
+		: cache_cursor_take (&cursor, current_key_size);
+	      if ( key == NULL || key[current_key_size - 1] != NUL )
 		{
-		  same = 0;
-		  finished = 1;
+		  corrupt = 1;
 		  break;
 		}
+
+	      if (j < dvars_count)
+		ids_map[i][v] = dictionary_intern
+		  (current_conf.dictionaries + j, key, current_key_size - 1,
+		   &num);
 	    }
 	}
 
-      /* Variables discrètes (indirectement) */
-      for (i = 0; i < vars_count && !finished; i++)
+      corrupt |= cursor.pos != cursor.end;
+
+      cache_cursor_init (&cursor, &cache, CACHE_COUNTS);
+
+      for (i = 0; i < index.files_count * cached_dvars && !corrupt; ++i)
 	{
-	  if (vars_types_check[i] != vars_types[i])
-	    {
-	      same = 0;
-	      finished = 1;
-	      break;
-	    }
+	  cached_counts[i] = cursor.pos;
+	  counts_size = 0;
+	  cache_cursor_read (&cursor, &counts_size, sizeof(unsigned int));
+
+	  if (counts_size > ids_count[i % cached_dvars]
+	      || ! cache_cursor_take (&cursor, sizeof(unsigned int)
+				      * counts_size))
+	    corrupt = 1;
 	}
 
-      /* Si l'utilisateur s'amuse à copier le dossier 'Analyse' d'un projet
-       * à un autre.. */
-      stat (bin_path, &modif_time_buff);
+      free (ids_count);
+
+      /* Les hashs concordent mais le contenu ne correspond pas aux
+       * autres sections */
+      if (corrupt || cursor.pos != cursor.end)
+	{
+	  fprintf(out, "Fichier binaire '%s' corrompu. Il est conseillé de le \
+supprimer et de relancer ce programme.\n", bin_path);
+	  cache_close (&cache);
+	  return 1;
+	}
 
-      if (last_modif_Gz > modif_time_buff.st_mtime)
-	same = 0;
+      /* Les variables discrètes des fichiers repris */
+      for (i = 0; i < files_count; ++i)
+	for (j = 0; j < dvars_count; ++j)
+	  if (cached_files[i] >= 0 && (c = cached_columns[4][j]) >= 0)
+	    load_counts (discrete_vars + i * dvars_count + j,
+			 cached_counts[cached_files[i] * cached_dvars + c],
+			 ids_map[c]);
     }
 
-  free (vars_types_check);
+  /* Pour le passage d'arguments à la fonction qui affiche les résultats */
+  print_func_args *print_args = (print_func_args*) malloc
+    (sizeof(print_func_args) * scenarios_count);
 
-  if (buff_overflow)
-    {
-      printf("Fichier binaire '%s' corrompu. Il est conseillé de le \
-supprimer et de relancer ce programme.\n", bin_path);
-      exit(1);
-    }
+  print_args[0].vars_list            = vars_list;
+  print_args[0].vars_types           = vars_types;
+  print_args[0].name                 = scenarios_list[0];
 
-  else if (same)
-    {
-      /* Les options n'ont pas changées et le parsing a déjà été fait:
-       * charger les données en mémoire */
-      read_count += fread (acc_results, sizeof(double), scenarios_count
-			   * iters_count * acc_vars_count, pBin);
+  print_args[0].calcs_list           = current_conf.calcs_list;
+  print_args[0].calcs_labels         = current_conf.calcs_labels;
+  print_args[0].calcs_progs          = current_conf.calcs_progs;
+  print_args[0].calcs_relative_ranks = current_conf.calcs_relative_ranks;
+  print_args[0].calcs_vars_types     = current_conf.calcs_vars_types;
 
-      read_count += fread (bool_results, sizeof(unsigned int),
-			   scenarios_count * iters_count * bool_vars_count,
-			   pBin);
+  print_args[0].bool_results         = bool_results;
+  print_args[0].acc_results          = acc_results;
+  print_args[0].discrete_results     = discrete_vars;
+  print_args[0].dictionaries         = current_conf.dictionaries;
 
-      read_count += fread (loc_results, sizeof(double), scenarios_count
-			   * iters_count * current_conf.total_loc_count,
-			   pBin);
+  print_args[0].cmp_means            = cmp_means;
+  print_args[0].cmp_stds             = cmp_stds;
+  print_args[0].ICR_vars_means       = ICR_vars_means;
+  print_args[0].ICR_vars_stds        = ICR_vars_stds;
+  print_args[0].ICR_vars_ranks       = current_conf.ICR_vars_ranks;
+  print_args[0].ICR_vars_types       = current_conf.ICR_vars_types;
+  print_args[0].cmp_rank             = current_conf.ICR_cmp_rank;
+  print_args[0].cmp_type             = current_conf.ICR_cmp_type;
+  print_args[0].calcs_count          = current_conf.calcs_count;
 
-      read_count += fread (c_bool_results, sizeof(unsigned int),
-			   scenarios_count * iters_count
-			   * current_conf.bool_count, pBin);
+  print_args[0].num_scen             = 0;
+  print_args[0].iters_count          = scen_iters[0];
+  print_args[0].pop                  = pop;
+  print_args[0].ICR_vars_count       = current_conf.ICR_vars_count;
+  print_args[0].vars_count           = vars_count;
 
-      int keys_count;
-      string current_key;
-      int current_key_size;
-      int value;
+  print_args[0].acc_vars_count       = acc_vars_count;
+  print_args[0].discrete_vars_count  = current_conf.discrete_vars_count;
+  print_args[0].bool_vars_count      = bool_vars_count;
+  print_args[0].loc_count            = current_conf.loc_count;
 
-      for (i = 0; i < scenarios_count * iters_count
-	     * current_conf.discrete_vars_count; ++i)
-	{
-	  read_count += fread (&keys_count, sizeof(int), 1, pBin);
-	  keys_read_count += keys_count;
+  print_args[0].loc_list             = current_conf.loc_list;
+  print_args[0].loc_labels           = current_conf.loc_labels;
+  print_args[0].loc_results          = loc_results;
 
-	  for (v = 0; v < keys_count; ++v)
-	    {
-	      read_count += fread (&current_key_size, sizeof(int), 1, pBin);
-	      if ( current_key_size > BUFFER_SIZE )
-		{
-		  printf("Fichier binaire '%s' corrompu. Il est conseillé \
-de le supprimer et de relancer ce programme.\n", bin_path);
-		  exit(1);
-		}
+  print_args[0].c_bool_count         = current_conf.bool_count;
+  print_args[0].c_bool_labels        = current_conf.bool_labels;
+  print_args[0].c_bool_results       = c_bool_results;
 
-	      read_count += fread (line, current_key_size, 1, pBin);
-	      read_count += fread (&value, sizeof(unsigned int), 1, pBin);
-	      discrete_vars[i][string(line)] = value;
-	    }
-	}
+  print_args[0].no_show              = current_conf.no_show;
+  print_args[0].out                  = out;
+  print_args[0].stream_parts         = NULL;
+  print_args[0].parts_count          = 0;
 
-      fclose(pBin);
+  print_args[0].total_loc_count      = current_conf.total_loc_count;
+  print_args[0].cond_vars_rank       = current_conf.cond_vars_rank;
 
-      /* Sorte de checksum */
-      if (read_count !=
-	  3 + (current_conf.loc_count * 2) + arg_counter + vars_count
-	  + ( (current_conf.total_loc_count - current_conf.loc_count +
-	     keys_read_count + arg_counter) * 3 )
-	  + ( scenarios_count * iters_count *
-	      (acc_vars_count + bool_vars_count +
-	       current_conf.total_loc_count + current_conf.bool_count +
-	       current_conf.discrete_vars_count) ))
-	{
-	  puts("Certaines données n'ont pu être correctement récupérées. \
-Cela peut être dû à un fichier '.aux' corrompu, des droits de lecture \
-manquants, ou un système de fichier instable.");
-	  exit(1);
-	}
+  for (int i = 1; i < scenarios_count; i++)
+    {
+      print_args[i] = print_args[0]; /* deep copy */
+
+      print_args[i].num_scen    = i;
+      print_args[i].name        = scenarios_list[i];
+      print_args[i].iters_count = scen_iters[i];
+    }
 
+  if (! tasks_count)
+    {
+      /* Tous les fichiers ont déjà été parsés: rien à refaire */
       /* Afficher les données qui furent chargées */
       for (i = 0; i < scenarios_count; ++i)
 	print_results (print_args + i);
@@ -830,45 +1648,44 @@ manquants, ou un système de fichier instable.");
   else
     {
       /* Parsing doit se faire! */
-      if (pBin != NULL)
-	fclose(pBin);
-
       /* Fichier qui montre la progression en temps réel */
       char progress_file [BUFFER_SIZE];
       strcpy (progress_file, argv[1]);
       strcat (progress_file, "progression.txt");
 
-      int max_threads = atoi(argv[4]);
+      mkdir (index_path, 0755);
+      for (i = 0; i < scenarios_count; ++i)
+	{
+	  snprintf (task_path, BUFFER_SIZE, "%s%s", index_path,
+		    scenarios_list[i]);
+	  mkdir (task_path, 0755);
+	}
+
+      /* Les threads de parsing, en nombre fixe peu importe le nombre
+       * de scénarios (partagés avec les autres projets avec
+       * --projects) */
+      int workers_count = project->workers->workers_count;
 
-      /* Nombre de threads par scénario */
-      int threads_per_scen =  (iters_count >= ( max_threads /
-						      scenarios_count ) ) ?
-	(int)ceil((float)max_threads / scenarios_count) : 1;
+      scheduler parse_tasks;
 
       /* La progression de chaque thread */
-      int *progress = (int*) calloc (threads_per_scen
-				     * scenarios_count, sizeof(int));
-
-      /* Contenir les threads eux-mêmes */
-      pthread_t *threads_array = (pthread_t*) malloc
-	(sizeof(pthread_t) * scenarios_count * threads_per_scen);
+      progress_counter *progress = (progress_counter*) cache_aligned_alloc
+	(sizeof(progress_counter) * workers_count);
+      for (v = 0; v < workers_count; ++v)
+	new (progress + v) progress_counter ();
 
       /* Contenir les paramètres à passer aux threads */
       thread_args *list_args = (thread_args*) malloc
-	(sizeof(thread_args) * scenarios_count * threads_per_scen);
+	(sizeof(thread_args) * workers_count);
 
       /* Les paramètres à passer aux threads, en commençant par le premier
        * thread. */
-      strcpy (file_path, argv[1]);
-      strcat (file_path, "/Results/");
-
-      list_args[0].lower_lim           = 0;
-      list_args[0].upper_lim           = iters_count/threads_per_scen;
-      list_args[0].iters_count         = iters_count;
+      list_args[0].first_files         = first_files;
 
       list_args[0].acc_results         = acc_results;
       list_args[0].bool_results        = bool_results;
       list_args[0].discrete_results    = discrete_vars;
+      list_args[0].dictionaries        = current_conf.dictionaries;
       list_args[0].c_bool_results      = c_bool_results;
       list_args[0].loc_results         = loc_results;
 
@@ -879,127 +1696,203 @@ manquants, ou un système de fichier instable.");
       list_args[0].bool_vars_count     = bool_vars_count;
 
       list_args[0].pop                 = pop;
-      list_args[0].num_scen            = 0;
-      list_args[0].name                = scenarios_list[0];
+      list_args[0].batch_size          = batch_size;
+      list_args[0].inflaters           = NULL;
+      list_args[0].whole_limit         = whole_limit;
+      list_args[0].prefetch            = NULL;
+      list_args[0].readahead           = 0;
+
+      /* Décompression en pipeline: les threads de parsing deviennent
+       * les évaluateurs */
+      pipeline inflaters;
+      if (inflaters_count)
+	{
+	  pipeline_start (&inflaters, inflaters_count, workers_count,
+			  whole_limit);
+	  list_args[0].inflaters = &inflaters;
+	}
+      list_args[0].scenarios_list      = scenarios_list;
       list_args[0].path                = file_path;
+      list_args[0].tasks               = &parse_tasks;
+      list_args[0].cached_files        = cached_files;
+      list_args[0].full_slots          = full_slots;
+      list_args[0].missing_slots       = missing_slots;
+      list_args[0].store_path          = store_path;
+      list_args[0].index_path          = index_path;
+      list_args[0].stamps              = stamps;
 
       list_args[0].loc_count           = current_conf.loc_count;
       list_args[0].loc_vars_count      = current_conf.loc_vars_count;
       list_args[0].loc_vars_ranks      = current_conf.loc_vars_ranks;
       list_args[0].loc_list            = current_conf.loc_list;
+      list_args[0].loc_progs           = current_conf.loc_progs;
 
       list_args[0].c_bool_count        = current_conf.bool_count;
       list_args[0].c_bool_vars_count   = current_conf.bool_vars_count;
-      list_args[0].c_bool_vars_ranks   = current_conf.bool_vars_ranks;
-      list_args[0].comp_op_list        = current_conf.comp_op_list;
-      list_args[0].bool_op_list        = current_conf.bool_op_list;
-      list_args[0].data_comp_list      = current_conf.data_comp_list;
+      list_args[0].c_bool_preds        = current_conf.bool_preds;
 
       list_args[0].cond_vars_rank      = current_conf.cond_vars_rank;
       list_args[0].total_loc_count     = current_conf.total_loc_count;
 
       list_args[0].progress            = progress;
-      list_args[0].progress_id         = 0;
 
-      /* Premier scénario */
-      pthread_create(threads_array, NULL, parse_csv, (void*) list_args);
+      list_args[0].calcs_progs          = current_conf.calcs_progs;
+      list_args[0].calcs_relative_ranks = current_conf.calcs_relative_ranks;
+      list_args[0].calcs_vars_types     = current_conf.calcs_vars_types;
+      list_args[0].calcs_count          = current_conf.calcs_count;
 
-      for (v = 1; v < threads_per_scen; ++v)
+      /* Mode --streaming: les accumulateurs de chaque thread, chacun sur
+       * ses propres lignes de cache */
+      int stream_columns = acc_vars_count + bool_vars_count + loc_count
+	+ c_bool_count + current_conf.calcs_count;
+      stream_part *parts = NULL;
+
+      if (streaming)
 	{
-	  list_args[v]             = list_args[v-1]; /* deep copy */
-	  list_args[v].lower_lim   = list_args[v-1].upper_lim;
-	  list_args[v].progress_id = v;
+	  parts = (stream_part*) malloc (sizeof(stream_part)
+					 * workers_count);
 
-	  list_args[v].upper_lim = (v == threads_per_scen - 1) ?
-	    iters_count : list_args[v-1].upper_lim +
-	    (list_args[v-1].upper_lim - list_args[v-1].lower_lim);
+	  for (v = 0; v < workers_count; ++v)
+	    {
+	      parts[v].stats = (welford*) cache_aligned_alloc
+		(sizeof(welford) * (scenarios_count * stream_columns + 1));
+	      memset (parts[v].stats, 0, sizeof(welford)
+		      * (scenarios_count * stream_columns + 1));
+
+	      parts[v].discrete = (discrete_stats*) calloc
+		(scenarios_count * dvars_count + 1, sizeof(discrete_stats));
+
+	      parts[v].calcs_errors = (int*) malloc
+		(sizeof(int) * (scenarios_count * current_conf.calcs_count
+				+ 1));
+	      for (i = 0; i < scenarios_count * current_conf.calcs_count; ++i)
+		parts[v].calcs_errors[i] = -1;
+	    }
 
-	  pthread_create(threads_array+v, NULL, parse_csv,
-			 (void*) (list_args+v));
+	  for (i = 0; i < scenarios_count; ++i)
+	    {
+	      print_args[i].stream_parts = parts;
+	      print_args[i].parts_count  = workers_count;
+	    }
 	}
 
-      int offset;
-      /* Les autres scénarios */
-      for (i = 1; i < scenarios_count; ++i)
-	{
-	  offset            = i * threads_per_scen;
-	  list_args[offset] = list_args[0];
-
-	  list_args[offset].name        = scenarios_list[i];
-	  list_args[offset].num_scen    = i;
-	  list_args[offset].progress_id = offset;
+      /* Les gros fichiers dont l'index d'accès est à jour sont
+       * découpés en tranches, parsées en parallèle (sauf avec
+       * --inflate=whole, où chaque fichier est lu d'un coup) */
+      file_chunks **chunked = (file_chunks**) calloc (files_count + 1,
+						      sizeof(file_chunks*));
+      int chunks_count = tasks_count;
+      file_chunks *chunks;
+      char store_file [BUFFER_SIZE];
 
-	  if (threads_per_scen > 1)
+      for (i = 0; i < scenarios_count; ++i)
+	for (v = first_files[i]; v < first_files[i + 1]; ++v)
+	  if ((cached_files[v] < 0 || missing)
+	      && whole_limit != INFLATE_ALWAYS)
 	    {
-	      list_args[offset].lower_lim = 0;
-	      list_args[offset].upper_lim = iters_count /
-		threads_per_scen;
+	      snprintf (task_path, BUFFER_SIZE, "%s%s/%d_Output.idx",
+			index_path, scenarios_list[i], v - first_files[i]);
+	      snprintf (store_file, BUFFER_SIZE, "%s%s/%d_Output.col",
+			store_path, scenarios_list[i], v - first_files[i]);
+
+	      chunked[v] = chunk_file (task_path, store_file, stamps + v,
+				       pop, list_args);
+	      if (chunked[v] != NULL)
+		chunks_count += chunked[v]->count - 1;
 	    }
 
-	  pthread_create(threads_array + offset, NULL, parse_csv,
-			 (void*) (list_args + offset));
+      /* Une tâche par fichier (ou tranche) à parser, avec la taille du
+       * fichier (ou de la tranche) compressé pour commencer par les plus
+       * gros */
+      task *tasks = (task*) malloc (sizeof(task) * chunks_count);
+      int  t = 0, c, point, next;
+      long end;
 
-	  /* Division des threads pour un même scénario */
-	  for (v = 1; v < threads_per_scen; ++v)
+      for (i = 0; i < scenarios_count; ++i)
+	for (v = 0; v < scen_iters[i]; ++v)
+	  if (cached_files[first_files[i] + v] < 0 || missing)
 	    {
-	      list_args[offset+v] = list_args[offset+v-1];
-	      list_args[offset+v].progress_id++;
-
-	      list_args[offset+v].lower_lim = list_args[offset+v].upper_lim;
+	      chunks = chunked[first_files[i] + v];
 
-	      list_args[offset+v].upper_lim = (v == threads_per_scen
-					       - 1) ? iters_count :
-		list_args[offset+v].upper_lim
-		+ (list_args[offset+v-1].upper_lim
-		   - list_args[offset+v-1].lower_lim);
+	      for (c = 0; c < (chunks != NULL ? chunks->count : 1); ++c)
+		{
+		  tasks[t].scen  = i;
+		  tasks[t].iter  = v;
+		  tasks[t].chunk = chunks != NULL ? c : -1;
+		  tasks[t].size  = stamps[first_files[i] + v].size;
+		  tasks[t].inode = stamps[first_files[i] + v].inode;
+
+		  /* Une tranche: du bloc de son premier point à celui du
+		   * point qui la termine */
+		  if (chunks != NULL)
+		    {
+		      point = chunks->points[c];
+		      next  = chunks->ends[c];
+		      end   = next < (int) chunks->index.header->points_count
+			? (long) chunks->index.points[next].in : tasks[t].size;
 
-	      pthread_create(threads_array+offset+v, NULL, parse_csv,
-			     (void*) (list_args+offset+v));
+		      tasks[t].size = end - (long) chunks->index.points[point].in;
+		    }
+		  t++;
+		}
 	    }
+
+      /* Sur un système de fichiers lent (--readahead), les fichiers
+       * sont pris par inode et les prochains de chaque thread sont lus
+       * d'avance */
+      scheduler_init (&parse_tasks, workers_count, tasks, chunks_count,
+		      scenarios_count,
+		      readahead ? SCHEDULE_INODE : SCHEDULE_SIZE);
+      free (tasks);
+
+      prefetcher prefetch;
+      if (readahead)
+	prefetch_start (&prefetch, prefetchers ? prefetchers : readahead,
+			workers_count * readahead);
+
+      for (v = 0; v < workers_count; ++v)
+	{
+	  list_args[v]           = list_args[0]; /* deep copy */
+	  list_args[v].worker_id = v;
+	  list_args[v].stream    = parts != NULL ? parts + v : NULL;
+	  list_args[v].chunked   = chunked;
+	  list_args[v].prefetch  = readahead ? &prefetch : NULL;
+	  list_args[v].readahead = readahead;
 	}
 
+      pool_job parsing;
+      pool_submit (project->workers, &parsing, parse_csv, list_args,
+		   sizeof(thread_args));
+
       /* On crée le thread qui servira à suivre la progression */
       FILE *p_bar = fopen(progress_file, "w");
       pthread_t progress_thread;
-      pBar_args current_progress = { p_bar, progress,
-				     scenarios_count * iters_count,
-				     threads_per_scen
-				     * scenarios_count };
+      pBar_args current_progress = { p_bar, progress, tasks_count,
+				     workers_count };
 
       pthread_create (&progress_thread, NULL, display_progress,
 		      (void*) (&current_progress));
 
-      /* Tous les threads ont été créés. Il faut traiter leur mort. */
-      void *status;
-      int  *done_parsing = (int*) calloc (scenarios_count, sizeof(int));
+      /* Affichage des résultats de chaque scénario dès qu'il est
+       * complet (et que ceux qui le précèdent ont été affichés) */
+      while ((i = scheduler_wait (&parse_tasks)) >= 0)
+	print_results (print_args + i);
 
-      for (i = 0; i < scenarios_count * threads_per_scen; ++i)
-	{
-	  pthread_join (threads_array[i], &status);
-	  done_parsing [CONVERSION status] ++ ;
+      pool_wait (project->workers, &parsing);
+
+      if (readahead)
+	prefetch_stop (&prefetch);
 
-	  /* Si vrai, alors impossible qu'un scénario ait eu le temps
-	   * de finir: on saute la vérification */
-	  if (i < (threads_per_scen - 1))
-	    {
-	      continue;
-	    }
-	  else
-	    {
-	      for (v = 0; v < scenarios_count; ++v)
-		{
-		  if (done_parsing [v] == threads_per_scen)
-		    {
-		      /* Affichage des résultats */
-		      print_results (print_args + v);
-		      done_parsing [v] = -1;
-		    }
-		}
-	    }
-	}
-      free (threads_array);
       free (list_args);
-      free (done_parsing);
+      scheduler_free (&parse_tasks);
+
+      for (v = 0; v < files_count; ++v)
+	if (chunked[v] != NULL)
+	  free_chunks (chunked[v], current_conf.discrete_vars_count);
+      free (chunked);
+
+      if (inflaters_count)
+	pipeline_stop (&inflaters);
 
       /* Le parsing est complété, alors le thread de progression devient
        * inutile: il faut l'interrompre. */
@@ -1009,110 +1902,205 @@ manquants, ou un système de fichier instable.");
       remove (progress_file);
       free (current_progress.progress);
 
-      /* Sauvegarder les résultats du parsing */
-      pBin = fopen ( bin_path , "wb");
-      if (pBin != NULL)
+      for (v = 0; v < workers_count && streaming; ++v)
 	{
-	  /* Même ordre que la lecture du fichier binaire plus haut */
-	  fwrite (vars_types, sizeof(int), vars_count, pBin);
-
-	  fwrite (&iters_count, sizeof(int), 1, pBin);
-
-          fwrite (&current_conf.total_loc_count, sizeof(int), 1, pBin);
-
-	  fwrite (&current_conf.bool_count, sizeof(int), 1, pBin);
+	  for (i = 0; i < scenarios_count * dvars_count; ++i)
+	    free (parts[v].discrete[i].stats);
+	  free (parts[v].stats);
+	  free (parts[v].discrete);
+	  free (parts[v].calcs_errors);
+	}
+      free (parts);
 
-	  int  key_size;
-	  /* Calculs locaux et condtionnels */
-	  for (i = 0; i < current_conf.total_loc_count; ++i)
+      /* Sauvegarder les résultats du parsing (sauf en mode --streaming,
+       * où ils n'existent plus): les scénarios courants, puis les
+       * segments du fichier binaire qui n'ont pas servi (s'ils ont
+       * toutes les colonnes courantes) */
+      if (! streaming)
+	{
+	  cache_buffer scen_list, files, columns, acc, bools, locs, c_bools;
+	  cache_buffer keys, counts;
+	  dictionary *dict;
+	  discrete_counts saved;
+	  unsigned int counts_size, name_size, columns_count;
+	  int  key_size, d, first, last;
+
+	  cache_buffer_init (&scen_list);
+	  cache_buffer_init (&files);
+	  cache_buffer_init (&columns);
+	  cache_buffer_init (&acc);
+	  cache_buffer_init (&bools);
+	  cache_buffer_init (&locs);
+	  cache_buffer_init (&c_bools);
+	  cache_buffer_init (&keys);
+	  cache_buffer_init (&counts);
+
+	  unsigned int segments_count = scenarios_count;
+	  for (i = 0; i < index.scenarios_count && ! missing; ++i)
+	    segments_count += ! used_segments[i];
+	  cache_buffer_add (&scen_list, &segments_count, sizeof(unsigned int));
+
+	  for (i = 0; i < scenarios_count; ++i)
 	    {
-	      key_size = strlen(current_conf.loc_list[i]) + 1;
-	      fwrite (&key_size, sizeof(int), 1, pBin);
-	      fwrite (current_conf.loc_list[i], key_size, 1, pBin);
-
-	      if (i >= current_conf.loc_count)
-		fwrite (&current_conf.cond_vars_rank
-			[i - current_conf.loc_count],
-			sizeof(int), 1 , pBin);
+	      name_size = strlen(scenarios_list[i]) + 1;
+	      cache_buffer_add (&scen_list, scen_iters + i,
+				sizeof(unsigned int));
+	      cache_buffer_add (&scen_list, &name_size, sizeof(unsigned int));
+	      cache_buffer_add (&scen_list, scenarios_list[i], name_size);
 	    }
 
-	  /* Expressions booléennes */
-	  for (i = 0; i < current_conf.bool_count; ++i)
+	  for (g = 0; g < CACHE_GROUPS; ++g)
 	    {
-	      fwrite (&current_conf.bool_vars_count[i], sizeof(int),
-		      1, pBin);
+	      columns_count = groups_count[g];
+	      cache_buffer_add (&columns, &columns_count,
+				sizeof(unsigned int));
+	      cache_buffer_add (&columns, groups_keys[g],
+				sizeof(uint64_t) * columns_count);
+	    }
 
-	      for (v = 0; v < current_conf.bool_vars_count[i]; v++)
-		{
-		  key_size = strlen(current_conf.data_comp_list[i][v]) + 1;
-		  fwrite (&key_size, sizeof(int), 1, pBin);
-		  fwrite (current_conf.data_comp_list[i][v], key_size,
-			  1, pBin);
-		  fwrite (&current_conf.comp_op_list[i][v], sizeof(int),
-			  1, pBin);
-		}
+	  cache_buffer_add (&files, stamps, sizeof(cache_stamp) * files_count);
+	  cache_buffer *tensors_buffers [CACHE_GROUPS - 1] =
+	    { &acc, &bools, &locs, &c_bools };
+
+	  for (g = 0; g < CACHE_GROUPS - 1; ++g)
+	    cache_buffer_add (tensors_buffers[g], results[g]->data,
+			      tensor_size (results[g], files_count));
 
-	      for (v = 0; v < current_conf.bool_vars_count[i] - 1; v++)
+	  /* Les variables discrètes: d'abord le dictionnaire de chaque
+	   * variable, puis les comptes indexés par identifiant */
+	  for (d = 0; d < dvars_count; ++d)
+	    {
+	      dict = current_conf.dictionaries + d;
+	      cache_buffer_add (&keys, &dict->count, sizeof(unsigned int));
+
+	      for (v = 0; v < (int) dict->count; ++v)
 		{
-		  fwrite (&current_conf.bool_op_list[i][v], sizeof(int),
-			  1, pBin);
+		  key_size = strlen(dict->keys[v]) + 1;
+		  cache_buffer_add (&keys, &key_size, sizeof(int));
+		  cache_buffer_add (&keys, dict->keys[v], key_size);
 		}
 	    }
 
-	  /* Les résultats eux-mêmes */
-	  fwrite (acc_results, sizeof(double), scenarios_count
-		  * iters_count * acc_vars_count, pBin);
+	  /* Les tableaux sont plus grands que nécessaire: seuls les
+	   * identifiants connus sont sauvegardés */
+	  for (i = 0; i < files_count * dvars_count; ++i)
+	    {
+	      dict = current_conf.dictionaries + i % dvars_count;
+	      counts_size = discrete_vars[i].size < dict->count ?
+		discrete_vars[i].size : dict->count;
 
-	  fwrite (bool_results, sizeof(unsigned int), scenarios_count
-		  * iters_count * bool_vars_count, pBin);
+	      cache_buffer_add (&counts, &counts_size, sizeof(unsigned int));
+	      cache_buffer_add (&counts, discrete_vars[i].counts,
+				sizeof(unsigned int) * counts_size);
+	    }
 
-	  fwrite (loc_results, sizeof(double), scenarios_count
-		  * iters_count * current_conf.total_loc_count, pBin);
+	  /* Les autres segments, colonne par colonne, avec leurs comptes
+	   * traduits dans le dictionnaire courant */
+	  for (segment = 0; segment < index.scenarios_count && ! missing;
+	       ++segment)
+	    {
+	      if (used_segments[segment])
+		continue;
 
-	  fwrite (c_bool_results, sizeof(unsigned int), scenarios_count
-		  * iters_count * current_conf.bool_count, pBin);
+	      first = index.first[segment];
+	      last  = first + index.iters_count[segment];
 
-	  int  keys_count;
-	  const char *c_key;
+	      name_size = strlen(index.names[segment]) + 1;
+	      cache_buffer_add (&scen_list, index.iters_count + segment,
+				sizeof(unsigned int));
+	      cache_buffer_add (&scen_list, &name_size, sizeof(unsigned int));
+	      cache_buffer_add (&scen_list, index.names[segment], name_size);
 
-	  /* Les résultats des variables discrètes est un peux plus
-	   * complexe: il s'agit de séraliser un std::map */
-	  for (i = 0; i < scenarios_count * iters_count
-		 * current_conf.discrete_vars_count; ++i)
-	    {
-	      keys_count = 0;
+	      cache_buffer_add (&files, index.stamps + first,
+				sizeof(cache_stamp) * (last - first));
 
-	      for (unordered_map<string, unsigned int>::iterator it =
-		     discrete_vars[i].begin(); it!=discrete_vars[i].end();
-		   ++it)
+	      for (c = first; c < last; ++c)
 		{
-		  keys_count++;
-		}
-
-	      fwrite (&keys_count, sizeof(int), 1, pBin);
+		  for (g = 0; g < CACHE_GROUPS - 1; ++g)
+		    {
+		      elem_size = tensor_elem_size (cached[g]);
 
-	      for (unordered_map<string, unsigned int>::iterator it =
-		     discrete_vars[i].begin(); it!=discrete_vars[i].end();
-		   ++it)
-		{
-		  /* Strings C plus facile à sérialiser */
-		  c_key = it->first.c_str();
-		  key_size = strlen(c_key) + 1;
-		  fwrite (&key_size, sizeof(int), 1, pBin);
+		      for (j = 0; j < groups_count[g]; ++j)
+			cache_buffer_add (tensors_buffers[g],
+					  (char*) tensor_row (cached[g], c)
+					  + cached_columns[g][j] * elem_size,
+					  elem_size);
+		    }
 
-		  fwrite (c_key, key_size, 1, pBin);
-		  fwrite (&it->second, sizeof(unsigned int), 1, pBin);
+		  for (d = 0; d < dvars_count; ++d)
+		    {
+		      dict = current_conf.dictionaries + d;
+
+		      saved.counts = NULL;
+		      saved.size   = 0;
+		      load_counts (&saved, cached_counts
+				   [c * cached_dvars + cached_columns[4][d]],
+				   ids_map[cached_columns[4][d]]);
+
+		      counts_size = saved.size < dict->count ?
+			saved.size : dict->count;
+		      cache_buffer_add (&counts, &counts_size,
+					sizeof(unsigned int));
+		      cache_buffer_add (&counts, saved.counts,
+					sizeof(unsigned int) * counts_size);
+		      free (saved.counts);
+		    }
 		}
 	    }
-	  fclose (pBin);
-	}
-      else
-	{
-	  printf("Incapable d'écrire le fichier binaire: %s\n\n", bin_path);
-	  /* N'interrompt pas le programme mais devrait peut-être */
+
+	  /* Même ordre que les sections de l'en-tête */
+	  const void *sections [CACHE_SECTIONS_COUNT] =
+	    { scen_list.data, files.data, columns.data, acc.data, bools.data,
+	      locs.data, c_bools.data, keys.data, counts.data };
+	  size_t sizes [CACHE_SECTIONS_COUNT] =
+	    { scen_list.size, files.size, columns.size, acc.size, bools.size,
+	      locs.size, c_bools.size, keys.size, counts.size };
+
+	  if (! cache_write (bin_path, CACHE_LAYOUT_SCEN_ITER_VAR, sections,
+			     sizes))
+	    {
+	      fprintf(out, "Incapable d'écrire le fichier binaire: %s\n\n",
+			    bin_path);
+	      /* N'interrompt pas le programme mais devrait peut-être */
+	    }
+
+	  cache_buffer_free (&scen_list);
+	  cache_buffer_free (&files);
+	  cache_buffer_free (&columns);
+	  cache_buffer_free (&acc);
+	  cache_buffer_free (&bools);
+	  cache_buffer_free (&locs);
+	  cache_buffer_free (&c_bools);
+	  cache_buffer_free (&keys);
+	  cache_buffer_free (&counts);
 	}
     }
 
+  if (same == CACHE_VALID)
+    {
+      cache_index_free (&index);
+
+      /* Les tenseurs utilisés sur place restent projetés */
+      if (! in_place)
+	cache_close (&cache);
+    }
+  for (i = 0; i < cached_dvars; ++i)
+    free (ids_map[i]);
+  free (ids_map);
+  for (g = 0; g < CACHE_GROUPS; ++g)
+    {
+      free (groups_slots[g]);
+      free (groups_keys[g]);
+      free (cached_columns[g]);
+    }
+  free (slot_keys);
+  free (full_slots);
+  free (missing_slots);
+  free (cached_counts);
+  free (cached_files);
+  free (used_segments);
+  free (stamps);
+
   /* Si pas de variables d'ICR, fin du programme */
   if (! current_conf.ICR_vars_count)
     return 0;
@@ -1121,43 +2109,106 @@ manquants, ou un système de fichier instable.");
    * encourager de trouver une meilleure méthode.
    */
 
-  puts("* Calculs d\'ICER (Incremental Cost-Effectiveness Ratio)");
-  puts("( À noter: IC = intervalle de confiance à ~ 95% )");
+  fputs("* Calculs d\'ICER (Incremental Cost-Effectiveness Ratio)\n", out);
+  fputs("( À noter: IC = intervalle de confiance à ~ 95% )\n", out);
+
+  /* Pour chaque variable d'ICR: les scénarios dans l'ordre du
+   * comparateur, leur statut (dominé ou non) et le scénario efficient
+   * auquel chacun est comparé (voir frontier.h) */
+  int *scenarios_new_ranks = (int*) malloc
+    (sizeof(int) * current_conf.ICR_vars_count * scenarios_count);
+  int *frontier_status = (int*) malloc
+    (sizeof(int) * current_conf.ICR_vars_count * scenarios_count);
+  int *frontier_refs = (int*) malloc
+    (sizeof(int) * current_conf.ICR_vars_count * scenarios_count);
+  double *effects = (double*) malloc (sizeof(double) * scenarios_count);
+
+  int *new_ranks, *status, *refs;
+  int previous; /* scénario de comparaison */
+
+  double delta_cmp, delta_var, ICR;
+  bootstrap_pair *pair, *sample;
+
+  const char *to_display = ""; /* variable en traitement */
+
+  /* La comparaison de chaque scénario avec le scénario efficient qui le
+   * précède, pour chaque variable d'ICR. Celles qui ont un ICR (pas de
+   * division par zéro) sont recopiées pour le bootstrap: rang -1 sinon */
+  int pairs_count = 0;
+  int *pairs_ranks = (int*) malloc
+    (sizeof(int) * current_conf.ICR_vars_count * scenarios_count);
+  bootstrap_pair *pairs = (bootstrap_pair*) malloc
+    (sizeof(bootstrap_pair) * current_conf.ICR_vars_count
+     * scenarios_count);
+  bootstrap_pair *sampled = (bootstrap_pair*) malloc
+    (sizeof(bootstrap_pair) * current_conf.ICR_vars_count
+     * scenarios_count);
 
-  /* On veut établir le rang des scénarios selon le comparateur */
-  double *sorted_cmp_means = (double*) malloc
-    (sizeof(double) * scenarios_count);
-
-  memcpy (sorted_cmp_means, cmp_means, sizeof(double) * scenarios_count);
-  qsort  (sorted_cmp_means, scenarios_count, sizeof(double), sort_func);
-
-  /* Les rangs sont trouvés et stockés ici */
-  int *scenarios_new_ranks = (int*) malloc (sizeof(int) * scenarios_count);
-  for (i = 0; i < scenarios_count; ++i)
+  for (i = 0; i < current_conf.ICR_vars_count; ++i)
     {
+      new_ranks = scenarios_new_ranks + i * scenarios_count;
+      status    = frontier_status + i * scenarios_count;
+      refs      = frontier_refs + i * scenarios_count;
+
+      /* L'effet croît avec la variable (décroît si inversée) */
       for (v = 0; v < scenarios_count; ++v)
+	effects[v] = current_conf.ICR_vars_inv[i]
+	  ? - ICR_vars_means[v * current_conf.ICR_vars_count + i]
+	  : ICR_vars_means[v * current_conf.ICR_vars_count + i];
+
+      frontier_compute (cmp_means, effects, scenarios_count, new_ranks,
+			status, refs);
+
+      for (v = 1; v < scenarios_count; ++v)
 	{
-	  if (sorted_cmp_means[i] == cmp_means[v])
+	  previous = new_ranks[refs[v]];
+	  pair = pairs + i * scenarios_count + v;
+
+	  /* Noms de variables plus clairs: c = current, p = previous */
+	  pair->c_cmp       = cmp_means[new_ranks[v]];
+	  pair->inter_c_cmp = get_CI (cmp_stds[new_ranks[v]],
+				      scen_iters[new_ranks[v]]);
+
+	  pair->p_cmp       = cmp_means[previous];
+	  pair->inter_p_cmp = get_CI (cmp_stds[previous],
+				      scen_iters[previous]);
+
+	  pair->c_var       = ICR_vars_means[new_ranks[v]
+					     * current_conf.ICR_vars_count
+					     + i];
+	  pair->inter_c_var = get_CI (
+			       ICR_vars_stds[new_ranks[v]
+					     * current_conf.ICR_vars_count
+					     + i], scen_iters[new_ranks[v]]);
+
+	  pair->p_var       = ICR_vars_means[previous
+					     * current_conf.ICR_vars_count
+					     + i];
+	  pair->inter_p_var = get_CI (
+			       ICR_vars_stds[previous
+					     * current_conf.ICR_vars_count
+					     + i], scen_iters[previous]);
+
+	  pair->inv         = current_conf.ICR_vars_inv[i];
+
+	  delta_var   = pair->inv ? pair->p_var - pair->c_var
+	    : pair->c_var - pair->p_var;
+
+	  if (! delta_var) /* div par zéro */
 	    {
-	      scenarios_new_ranks[i] = v;
-	      break;
+	      pairs_ranks[i * scenarios_count + v] = -1;
+	      continue;
 	    }
+
+	  sampled[pairs_count] = *pair;
+	  pairs_ranks[i * scenarios_count + v] = pairs_count++;
 	}
     }
 
-  int previous, how_much_backward; /* scénario de comparaison & offset dû
-				    * aux scénarios dominés */
-
-  double c_cmp, inter_c_cmp, c_var, inter_c_var, delta_cmp, delta_var;
-  double p_cmp, inter_p_cmp, p_var, inter_p_var, ICR;
-
-  double denom; /* scindé la division en deux */
-  double *ICR_bootstrap = (double*) malloc (sizeof(double) * BOOTSTRAP);
-
-  char *to_display; /* variable en traitement */
-
-  /* Le seed du générateur de nombres réels aléatoires */
-  srand48(time(NULL));
+  /* On sélectionne des échantillons ici pour le calcul d'intervalle de
+   * confiance de chaque ICR: toutes les comparaisons en parallèle */
+  fprintf(out, "( Bootstrap: %ld échantillons, graine: %lu )\n", draws, seed);
+  bootstrap_run (sampled, pairs_count, draws, seed, threads_count);
 
   /* Commencer par formater un peu les tableaux */
   for (i = 0; i < current_conf.ICR_vars_count; ++i)
@@ -1182,7 +2233,8 @@ manquants, ou un système de fichier instable.");
 	  break;
 	}
 
-      printf("\nOption,Total %s,IC(±),Delta %s,", to_display, to_display);
+      fprintf(out, "\nOption,Total %s,IC(±),Delta %s,", to_display,
+	      to_display);
 
       /* Variable au dénominateur */
       switch (current_conf.ICR_vars_types[i])
@@ -1207,100 +2259,61 @@ manquants, ou un système de fichier instable.");
 	  break;
 	}
 
-      printf("Total %s,IC(±),Delta %s,ICR,IC(-),IC(+),Status\n",
-	     to_display, to_display ) ;
+      fprintf(out, "Total %s,IC(±),Delta %s,ICR,IC(-),IC(+),Status\n",
+		   to_display, to_display ) ;
+
+      new_ranks = scenarios_new_ranks + i * scenarios_count;
+      status    = frontier_status + i * scenarios_count;
 
-      printf("%s,%.8G,%.8G,N/A,%.8G,%.8G,N/A,Baseline,N/A,N/A, \n",
-	     scenarios_list[*scenarios_new_ranks], *sorted_cmp_means,
-	     get_CI (cmp_stds[*scenarios_new_ranks], iters_count),
-	     ICR_vars_means[*scenarios_new_ranks*current_conf
-			    .ICR_vars_count+i],
-	     get_CI (ICR_vars_stds[*scenarios_new_ranks*current_conf
-				   .ICR_vars_count+i], iters_count));
+      fprintf(out, "%s,%.8G,%.8G,N/A,%.8G,%.8G,N/A,Baseline,N/A,N/A, \n",
+		   scenarios_list[*new_ranks], cmp_means[*new_ranks],
+		   get_CI (cmp_stds[*new_ranks], scen_iters[*new_ranks]),
+		   ICR_vars_means[*new_ranks*current_conf.ICR_vars_count+i],
+		   get_CI (ICR_vars_stds[*new_ranks*current_conf
+					 .ICR_vars_count+i],
+			   scen_iters[*new_ranks]));
 
-      how_much_backward = 0; /* si scénario dominé, alors comparaison
-			      * du suivant est faite avec le précédent */
       for (v = 1; v < scenarios_count; ++v)
 	{
-	  previous = v - 1 - how_much_backward;
-
-	  /* Noms de variables plus clairs: c = current, p = previous */
-	  c_cmp       = sorted_cmp_means[v];
-	  inter_c_cmp = get_CI (cmp_stds[scenarios_new_ranks[v]]
-				, iters_count);
-
-	  p_cmp       = sorted_cmp_means[previous];
-	  inter_p_cmp = get_CI (cmp_stds[scenarios_new_ranks[previous]]
-				, iters_count);
+	  pair = pairs + i * scenarios_count + v;
 
-	  delta_cmp   = c_cmp - p_cmp;
+	  delta_cmp   = pair->c_cmp - pair->p_cmp;
+	  delta_var   = pair->inv ? pair->p_var - pair->c_var :
+	    pair->c_var - pair->p_var;
 
-	  c_var       = ICR_vars_means[scenarios_new_ranks[v]
-				       * current_conf.ICR_vars_count + i];
-	  inter_c_var = get_CI (
-			 ICR_vars_stds[scenarios_new_ranks[v]
-				       * current_conf.ICR_vars_count + i]
-			 , iters_count);
-
-	  p_var       = ICR_vars_means[scenarios_new_ranks[previous]
-				       * current_conf.ICR_vars_count + i];
-	  inter_p_var = get_CI (
-			 ICR_vars_stds[scenarios_new_ranks[previous]
-				       * current_conf.ICR_vars_count + i]
-			 , iters_count);
-
-	  delta_var   = current_conf.ICR_vars_inv[i] ? p_var - c_var :
-	    c_var - p_var;
-
-	  if (! delta_var) /* div par zéro */
+	  if (pairs_ranks[i * scenarios_count + v] < 0) /* div par zéro */
 	    {
-	      printf("%s,%.8G,%.8G,%.8G,%.8G,%.8G,%.8G,inf,N/A,N/A,Dominé\n"
-		     ,scenarios_list[scenarios_new_ranks[v]], c_cmp,
-		     inter_c_cmp, delta_cmp, c_var, inter_c_var, delta_var);
-	      ++how_much_backward;
+	      fprintf(out, "%s,%.8G,%.8G,%.8G,%.8G,%.8G,%.8G,inf,N/A,N/A,\
+Dominé\n", scenarios_list[new_ranks[v]], pair->c_cmp,
+			   pair->inter_c_cmp, delta_cmp, pair->c_var,
+			   pair->inter_c_var, delta_var);
 	      continue;
 	    }
 
 	  ICR = delta_cmp / delta_var;
-
-	  /* On sélectionne des échantillons ici pour le calcul
-	   * d'intervalle de confiance de l'ICR */
-	  for (int k = 0; k < BOOTSTRAP; ++k)
-	    {
-	      denom = current_conf.ICR_vars_inv[i] ?
-		((drand48() * inter_p_var * 2) + (p_var - inter_p_var))
-		- ((drand48() * inter_c_var * 2) + (c_var - inter_c_var)):
-		((drand48() * inter_c_var * 2) + (c_var - inter_c_var))
-		- ((drand48() * inter_p_var * 2) + (p_var - inter_p_var));
-
-	      ICR_bootstrap[k] = (( (drand48() * inter_c_cmp * 2)
-				   + (c_cmp - inter_c_cmp) )
-		- ( (drand48() * inter_p_cmp * 2)
-		    + (p_cmp - inter_p_cmp) )) / denom;
-	    }
-
-	  /* On ordonne les ICR générés aléatoirement par bootstrap */
-	  qsort (ICR_bootstrap, BOOTSTRAP, sizeof(double), sort_func);
+	  sample = sampled + pairs_ranks[i * scenarios_count + v];
 
 	  /* IC basé sur les 2.5e et 97.5e percentiles */
-	  printf("%s,%.8G,%.8G,%.8G,%.8G,%.8G,%.8G,%.8G,%+.8G,%+.8G,",
-		 scenarios_list[scenarios_new_ranks[v]], c_cmp, inter_c_cmp,
-		 delta_cmp, c_var, inter_c_var, delta_var, ICR,
-		 ICR_bootstrap[(int)floor((double)BOOTSTRAP*0.025)]-ICR,
-		 ICR_bootstrap[(int)ceil((double)BOOTSTRAP*0.975)]-ICR);
-
-	  if (delta_var < 0)
-	    {
-	      printf("Dominé");
-	      ++how_much_backward;
-	    }
-	  else
-	    {
-	      how_much_backward = 0;
-	    }
-	  printf("\n");
+	  fprintf(out, "%s,%.8G,%.8G,%.8G,%.8G,%.8G,%.8G,%.8G,%+.8G,%+.8G,",
+		       scenarios_list[new_ranks[v]], pair->c_cmp,
+		       pair->inter_c_cmp, delta_cmp, pair->c_var,
+		       pair->inter_c_var, delta_var, ICR, sample->low - ICR,
+		       sample->high - ICR);
+
+	  if (status[v] == FRONTIER_DOMINATED)
+	    fprintf(out, "Dominé");
+	  else if (status[v] == FRONTIER_EXTENDED)
+	    fprintf(out, "Dominé (extension)");
+	  fprintf(out, "\n");
 	}
     }
+  free (pairs);
+  free (sampled);
+  free (pairs_ranks);
+  free (scenarios_new_ranks);
+  free (frontier_status);
+  free (frontier_refs);
+  free (effects);
   return 0;
 }
 
@@ -1308,9 +2321,9 @@ manquants, ou un système de fichier instable.");
  * Parcourt un fichier de configuration pour en extraire les spécifications
  * de l'usager.
  */
-void  parse_configuration  (FILE * pConf, conf_args * to_fill,
+int   parse_configuration  (FILE * pConf, conf_args * to_fill,
 			    int *vars_types, char **vars_list,
-			    int vars_count)
+			    int vars_count, FILE *out)
 {
   /* Cette fonction est le résultat de l'ajout successif de plusieurs
    * fonctionnalités. Elle pourrait être réécrite en utilisant GNU Bison.
@@ -1331,8 +2344,9 @@ void  parse_configuration  (FILE * pConf, conf_args * to_fill,
   char  *pch   ; /* Pointeur du buffer */
   char  *pch_h ; /* Pointeur "helpeur" */
   char  *current = choices[7]; /* catégorie en cours de traitement */
-  int   index  ;
+  int   index  = 0;
   int   valid  ;
+  int   rank   ;
 
   int discrete_vars_count  = 0  ;
 
@@ -1379,8 +2393,8 @@ void  parse_configuration  (FILE * pConf, conf_args * to_fill,
 
 	  if (! valid)
 	    {
-	      printf("Catégorie non reconnue: %s", line);
-	      exit(1);
+	      fprintf(out, "Catégorie non reconnue: %s", line);
+	      return 1;
 	    }
 	}
       /* Si la ligne n'est pas un commentaire */
@@ -1388,8 +2402,8 @@ void  parse_configuration  (FILE * pConf, conf_args * to_fill,
 	{
 	  if ( *current == NUL )
 	    {
-	      printf("Aucune catégorie n'a été initialisée: %s", line);
-	      exit(1);
+	      fprintf(out, "Aucune catégorie n'a été initialisée: %s", line);
+	      return 1;
 	    }
 	  else
 	    {
@@ -1404,8 +2418,10 @@ void  parse_configuration  (FILE * pConf, conf_args * to_fill,
 		  *pch_h = NUL;
 
 		  /* Changer le type */
-		  vars_types [find_var_rank(pch, vars_count, vars_list)]
-		    = DISCRETE;
+		  rank = find_var_rank(pch, vars_count, vars_list, out);
+		  if (rank < 0)
+		    return 1;
+		  vars_types [rank] = DISCRETE;
 		  discrete_vars_count++;
 		  break;
 
@@ -1470,9 +2486,9 @@ void  parse_configuration  (FILE * pConf, conf_args * to_fill,
 
 		  /* Encore une fois trouver le plus grand nombre de
 		   * variables pour déterminer l'allocation de mém. */
-		  if (index == 3 && calcs_vars_count > loc_higher_nb)
+		  if (index != 4 && calcs_vars_count > loc_higher_nb)
 		    loc_higher_nb = calcs_vars_count;
-		  else if (calcs_vars_count > bool_higher_nb)
+		  else if (index == 4 && calcs_vars_count > bool_higher_nb)
 		    bool_higher_nb = calcs_vars_count;
 
 		  break;
@@ -1491,6 +2507,8 @@ void  parse_configuration  (FILE * pConf, conf_args * to_fill,
 
   char  **calcs_list    = (char**) malloc (sizeof(char*) * calcs_count);
   char  **calcs_labels  = (char**) malloc (sizeof(char*) * calcs_count);
+  eval_program *calcs_progs = (eval_program*) malloc (sizeof(eval_program)
+						      * calcs_count);
 
   char  **loc_list      = (char**) malloc (sizeof(char*) * total_loc_count);
   char  **loc_labels    = (char**) malloc (sizeof(char*) * total_loc_count);
@@ -1511,6 +2529,9 @@ void  parse_configuration  (FILE * pConf, conf_args * to_fill,
     }
 
   int   *loc_vars_count  = (int*)  malloc (sizeof(int)  * total_loc_count);
+  eval_program *loc_progs = (eval_program*) malloc (sizeof(eval_program)
+						    * total_loc_count);
+  eval  compiler; /* Compile les calculs une seule fois */
   int   **loc_vars_ranks = (int**) malloc (sizeof(int*) * total_loc_count);
   for (int i = 0; i < total_loc_count; ++i)
     {
@@ -1526,6 +2547,8 @@ void  parse_configuration  (FILE * pConf, conf_args * to_fill,
   int   **bool_op_list    = (int**) malloc (sizeof(int*)  * bool_count);
   int   **comp_op_list    = (int**) malloc (sizeof(int*)  * bool_count);
   char  ***data_comp_list = (char***) malloc (sizeof(char**) * bool_count);
+  predicate **bool_preds  = (predicate**) malloc (sizeof(predicate*)
+						  * bool_count);
 
   for (int i = 0; i < bool_count; ++i)
     {
@@ -1533,6 +2556,8 @@ void  parse_configuration  (FILE * pConf, conf_args * to_fill,
       bool_op_list[i]    = (int*) malloc (sizeof(int) * bool_higher_nb);
       comp_op_list[i]    = (int*) malloc (sizeof(int) * bool_higher_nb);
       data_comp_list[i]  = (char**) malloc(sizeof(char*) * bool_higher_nb);
+      bool_preds[i]      = (predicate*) malloc (sizeof(predicate)
+						* bool_higher_nb);
     }
 
   int   *ICR_vars_ranks   = (int*) malloc (sizeof(int) * ICR_vars_count);
@@ -1543,6 +2568,13 @@ void  parse_configuration  (FILE * pConf, conf_args * to_fill,
 					   + total_loc_count + calcs_count,
 					   sizeof(int) );
 
+  /* Un dictionnaire par variable discrète, dans l'ordre des colonnes */
+  dictionary *dictionaries = new dictionary [discrete_vars_count];
+  dictionary *dict;
+
+  for (int i = 0; i < discrete_vars_count; ++i)
+    dictionary_init (dictionaries + i);
+
   int   ICR_cmp_rank  = -1;
   int   ICR_cmp_type;
   int   inv_ready     =  0;
@@ -1640,24 +2672,25 @@ void  parse_configuration  (FILE * pConf, conf_args * to_fill,
 		      pch_h = strchr(pch+1, '"');
 		      if (pch_h == NULL)
 			{
-			  printf("Une variable n'a pas été refermée par un \
-guillemet dans les calculs: %s", line) ;
-			  exit(1);
+			  fprintf(out, "Une variable n'a pas été refermée par un \
+guillemet dans les calculs: %s", line);
+			  return 1;
 			}
 		      *pch_h = NUL;
 
-		      find_var_type_and_rank(++pch, vars_count, vars_list,
-					     vars_types, calcs_count,
-					     calcs_labels, total_loc_count,
-					     loc_labels, bool_count,
-					     bool_labels, &var_type,
-					     &var_abs_rank);
+		      if (find_var_type_and_rank(++pch, vars_count, vars_list,
+						 vars_types, calcs_count,
+						 calcs_labels, total_loc_count,
+						 loc_labels, bool_count,
+						 bool_labels, &var_type,
+						 &var_abs_rank, out))
+			return 1;
 
 		      if (var_type == DISCRETE)
 			{
-			  printf("Impossible d'utiliser la variable '%s'. \
+			  fprintf(out, "Impossible d'utiliser la variable '%s'. \
 Type invalide.\n", pch);
-			  exit(1);
+			  return 1;
 			}
 
 		      /* Si variable de type standard, il faut trouver
@@ -1684,7 +2717,8 @@ Type invalide.\n", pch);
 		  else if (! isspace (*pch) && ! isdigit (*pch)
 			   && *pch != '.')
 		    {
-		      check_delim_exist(*pch);
+		      if (check_delim_exist(*pch, out))
+			return 1;
 		      ++pch;
 		    }
 		  else
@@ -1696,7 +2730,16 @@ Type invalide.\n", pch);
 	       * rang et type. */
 	      calcs_list[calcs_rank] = (char*) malloc(strlen(equ_start));
 	      strncpy(calcs_list[calcs_rank], equ_start, strlen(equ_start));
-	      calcs_list[calcs_rank++][strlen(equ_start)-1] = NUL;
+	      calcs_list[calcs_rank][strlen(equ_start)-1] = NUL;
+
+	      if (compiler.compile (calcs_list[calcs_rank],
+				    calcs_progs + calcs_rank) != SUCCESS
+		  || calcs_progs[calcs_rank].vars_count != calcs_vars_count)
+		{
+		  fprintf(out, "Calcul invalide: %s\n", calcs_list[calcs_rank]);
+		  return 1;
+		}
+	      calcs_rank++;
 	      break;
 
 	      /* ICR: Trouver le rang et type des variables et du
@@ -1706,18 +2749,18 @@ Type invalide.\n", pch);
               pch = strchr (line, '=');
               if (pch == NULL)
                 {
-                  printf("Aucun symbole '=': %s", line);
-                  exit(1);
+		  fprintf(out, "Aucun symbole '=': %s", line);
+		  return 1;
                 }
 
 	      else if (! strncmp (line, "variable", 8))
 		{
 		  if (inv_ready)
 		    {
-		      printf("Il faut préciser l'inversion de la variable \
+		      fprintf(out, "Il faut préciser l'inversion de la variable \
 '%s' avant de passer à une autre variable.\n",
-			     vars_list[ICR_vars_ranks[ICR_rank]]);
-                      exit(1);
+			      vars_list[ICR_vars_ranks[ICR_rank]]);
+		      return 1;
 		    }
 
 		  do
@@ -1730,13 +2773,14 @@ Type invalide.\n", pch);
 		  while ( ! isspace(*pch_h) );
 		  *pch_h = NUL;
 
-		  find_var_type_and_rank(pch, vars_count, vars_list,
-					 vars_types, calcs_count,
-					 calcs_labels, total_loc_count,
-					 loc_labels, bool_count,
-					 bool_labels,
-					 ICR_vars_types+ICR_rank,
-					 ICR_vars_ranks+ICR_rank);
+		  if (find_var_type_and_rank(pch, vars_count, vars_list,
+					     vars_types, calcs_count,
+					     calcs_labels, total_loc_count,
+					     loc_labels, bool_count,
+					     bool_labels,
+					     ICR_vars_types+ICR_rank,
+					     ICR_vars_ranks+ICR_rank, out))
+		    return 1;
 
 		  inv_ready = 1;
 		}
@@ -1745,9 +2789,9 @@ Type invalide.\n", pch);
 		{
 		  if (! inv_ready)
 		    {
-		      puts("Il faut préciser une variable avant de \
-spécifier une inversion.");
-		      exit(1);
+		      fprintf(out, "Il faut préciser une variable avant de \
+spécifier une inversion.\n");
+		      return 1;
                     }
 
 		  do
@@ -1768,9 +2812,9 @@ spécifier une inversion.");
 		{
 		  if (ICR_cmp_rank >= 0)
 		    {
-		      printf("Un comparateur existe déjà: '%s'\n",
-			     vars_list[ICR_cmp_rank]) ;
-		      exit(1);
+		      fprintf(out, "Un comparateur existe déjà: '%s'\n",
+			      vars_list[ICR_cmp_rank]);
+		      return 1;
 		    }
 
 		  do
@@ -1783,17 +2827,18 @@ spécifier une inversion.");
 		  while ( ! isspace (*pch_h) );
 		  *pch_h = NUL;
 
-		  find_var_type_and_rank(pch, vars_count, vars_list,
-					 vars_types, calcs_count,
-					 calcs_labels, total_loc_count,
-					 loc_labels, bool_count,
-					 bool_labels, &ICR_cmp_type,
-					 &ICR_cmp_rank);
+		  if (find_var_type_and_rank(pch, vars_count, vars_list,
+					     vars_types, calcs_count,
+					     calcs_labels, total_loc_count,
+					     loc_labels, bool_count,
+					     bool_labels, &ICR_cmp_type,
+					     &ICR_cmp_rank, out))
+		    return 1;
 		}
 	      else
 		{
-		  printf("Argument non reconnu: %s", line);
-		  exit(1);
+		  fprintf(out, "Argument non reconnu: %s", line);
+		  return 1;
 		}
 	      break;
 
@@ -1808,8 +2853,8 @@ spécifier une inversion.");
 		      pch = strchr (line, '=');
                       if (pch == NULL)
                         {
-                          printf("Aucun symbole '=': %s", line);
-                          exit(1);
+			  fprintf(out, "Aucun symbole '=': %s", line);
+			  return 1;
                         }
 
 		      do
@@ -1822,18 +2867,19 @@ spécifier une inversion.");
 		      while ( !isspace (*pch_h) );
 		      *pch_h = NUL;
 
-		      find_var_type_and_rank(pch, vars_count, vars_list,
-					     vars_types, calcs_count,
-					     calcs_labels, total_loc_count,
-					     loc_labels, bool_count,
-					     bool_labels, &var_type,
-					     &var_relative_rank);
+		      if (find_var_type_and_rank(pch, vars_count, vars_list,
+						 vars_types, calcs_count,
+						 calcs_labels, total_loc_count,
+						 loc_labels, bool_count,
+						 bool_labels, &var_type,
+						 &var_relative_rank, out))
+			return 1;
 
 		      if (! (var_type == CUSTOM_BOOLEAN
 			     || var_type == BOOLEAN) )
 			{
-			  printf("Type invalide: %s\n", pch);
-			  exit(1);
+			  fprintf(out, "Type invalide: %s\n", pch);
+			  return 1;
 			}
 
 		      cond_vars_rank[cond_rank - loc_count] =
@@ -1847,16 +2893,16 @@ spécifier une inversion.");
 		    }
 		  else
 		    {
-		      printf("Il faut préciser un calcul avant de spécifier\
+		      fprintf(out, "Il faut préciser un calcul avant de spécifier\
  une condition: %s", line);
-		      exit(1);
+		      return 1;
 		    }
 		}
 	      else if (bool_ready)
 		{
-		  printf("Il faut préciser la condition du calcul '%s' \
+		  fprintf(out, "Il faut préciser la condition du calcul '%s' \
 avant de passer à un calcul suivant.\n", loc_list[cond_rank]);
-		  exit(1);
+		  return 1;
 		}
 	      else
 		{
@@ -1897,18 +2943,19 @@ avant de passer à un calcul suivant.\n", loc_list[cond_rank]);
 			  pch_h = strchr(pch+1, '"');
 			  if (pch_h == NULL)
 			    {
-			      printf("Une variable n'a pas été refermée par\
- un guillemet dans les calculs: %s", line) ;
-			      exit(1);
+			      fprintf(out, "Une variable n'a pas été refermée par\
+ un guillemet dans les calculs: %s", line);
+			      return 1;
 			    }
 			  *pch_h = NUL;
-			  find_var_type_and_rank(++pch, vars_count,
-						 vars_list, vars_types,
-						 calcs_count, calcs_labels,
-						 total_loc_count,
-						 loc_labels, bool_count,
-						 bool_labels, &var_type,
-						 &var_relative_rank);
+			  if (find_var_type_and_rank(++pch, vars_count,
+						     vars_list, vars_types,
+						     calcs_count, calcs_labels,
+						     total_loc_count,
+						     loc_labels, bool_count,
+						     bool_labels, &var_type,
+						     &var_relative_rank, out))
+			    return 1;
 
 			  /* Les types booléens ne sont pas acceptés dans
 			   * les calculs. */
@@ -1916,21 +2963,31 @@ avant de passer à un calcul suivant.\n", loc_list[cond_rank]);
 			      || var_type == CUSTOM_BOOLEAN
 			      || var_type == GLOB_CALC)
 			    {
-			      printf("Impossible d'utiliser la variable \
-'%s'. Type invalide.\n", pch) ;
-			      exit(1);
+			      fprintf(out, "Impossible d'utiliser la variable \
+'%s'. Type invalide.\n", pch);
+			      return 1;
 			    }
 
-			  loc_vars_ranks[loc_rank][calcs_vars_count++]
-			    = var_type == LOC_CALC ? var_relative_rank +
-			    vars_count : var_relative_rank ;
+			  /* Rang dans la cache de parse_csv: les calculs
+			   * conditionnels y suivent les expressions
+			   * booléennes. */
+			  if (var_type != LOC_CALC)
+			    loc_vars_ranks[loc_rank][calcs_vars_count++]
+			      = var_relative_rank;
+			  else if (var_relative_rank < loc_count)
+			    loc_vars_ranks[loc_rank][calcs_vars_count++]
+			      = vars_count + var_relative_rank;
+			  else
+			    loc_vars_ranks[loc_rank][calcs_vars_count++]
+			      = vars_count + bool_count + var_relative_rank;
 
 			  *pch_h = '"';
 			  pch = pch_h + 1;
 			}
 		      else if (! isspace (*pch) && ! isdigit (*pch))
 			{
-			  check_delim_exist(*pch);
+			  if (check_delim_exist(*pch, out))
+			    return 1;
 			  ++pch;
 			}
 		      else
@@ -1939,9 +2996,9 @@ avant de passer à un calcul suivant.\n", loc_list[cond_rank]);
 
 		  if (! calcs_vars_count)
 		    {
-		      printf("Calcul invalide! Il faut utiliser au moins \
-une variable: %s", line) ;
-		      exit(1);
+		      fprintf(out, "Calcul invalide! Il faut utiliser au moins \
+une variable: %s", line);
+		      return 1;
 		    }
 
 		  /* Tout est valide: copie de l'équation en mémoire */
@@ -1950,6 +3007,14 @@ une variable: %s", line) ;
 		  strncpy(loc_list[loc_rank], equ_start, strlen(equ_start));
 		  loc_list[loc_rank][strlen(equ_start)-1] = NUL;
 
+		  if (compiler.compile (loc_list[loc_rank],
+					loc_progs + loc_rank) != SUCCESS
+		      || loc_progs[loc_rank].vars_count != calcs_vars_count)
+		    {
+		      fprintf(out, "Calcul invalide: %s\n", loc_list[loc_rank]);
+		      return 1;
+		    }
+
 		  if (index == 3)
 		    loc_norm_rank++;
 		  else
@@ -1985,9 +3050,9 @@ une variable: %s", line) ;
 		}
 	      else
 		{
-		  printf("Il faut donner une étiquette à l'expression \
-booléenne: %s", line) ;
-		  exit(1);
+		  fprintf(out, "Il faut donner une étiquette à l'expression \
+booléenne: %s", line);
+		  return 1;
 		}
 
 	      calcs_vars_count = 0;
@@ -2001,38 +3066,44 @@ booléenne: %s", line) ;
 		      pch_h = strchr(pch+1, '"');
 		      if (pch_h == NULL)
 			{
-			  printf("Une variable n'a pas été refermée par un \
+			  fprintf(out, "Une variable n'a pas été refermée par un \
 guillemet dans les expressions booléennes: %s",
-				 line) ;
-			  exit(1);
+				  line);
+			  return 1;
 			}
 		      *pch_h = NUL;
 
-		      find_var_type_and_rank(++pch, vars_count, vars_list,
-					     vars_types, calcs_count,
-					     calcs_labels, total_loc_count,
-					     loc_labels, bool_count,
-					     bool_labels, &var_type,
-					     &var_relative_rank);
+		      if (find_var_type_and_rank(++pch, vars_count, vars_list,
+						 vars_types, calcs_count,
+						 calcs_labels, total_loc_count,
+						 loc_labels, bool_count,
+						 bool_labels, &var_type,
+						 &var_relative_rank, out))
+			return 1;
 
 		      /* Les calculs globaux ne sont calculés qu'après le
 		       * parsing... Utiliser les calculs locaux. */
 		      if (var_type == GLOB_CALC)
 			{
-			  printf("Impossible d'utiliser la variable '%s'. \
+			  fprintf(out, "Impossible d'utiliser la variable '%s'. \
 Type invalide.\n",
-				 pch);
-			  exit(1);
+				  pch);
+			  return 1;
 			}
 
+		      /* Rang dans la cache de parse_csv */
 		      if (var_type <= DISCRETE)
 			bool_vars_ranks[bool_rank][calcs_vars_count]
 			  = var_relative_rank;
+		      else if (var_type == CUSTOM_BOOLEAN)
+			bool_vars_ranks[bool_rank][calcs_vars_count]
+			  = vars_count + loc_count + var_relative_rank;
+		      else if (var_relative_rank < loc_count)
+			bool_vars_ranks[bool_rank][calcs_vars_count]
+			  = vars_count + var_relative_rank;
 		      else
 			bool_vars_ranks[bool_rank][calcs_vars_count]
-			  = var_type == LOC_CALC ? vars_count
-			  + var_relative_rank : vars_count + loc_count
-			  + var_relative_rank;
+			  = vars_count + bool_count + var_relative_rank;
 
 		      *pch_h = '"';
 		      pch = pch_h + 1;
@@ -2046,8 +3117,8 @@ Type invalide.\n",
 			      || (*pch == '|' && *(pch+1) != '|')
 			      || calcs_vars_count-1 != bool_op_count )
 			    {
-			      printf("Expression invalide: %s", line);
-			      exit(1);
+			      fprintf(out, "Expression invalide: %s", line);
+			      return 1;
 			    }
 			  bool_op_list[bool_rank][calcs_vars_count - 1]
 			    = *pch == '&' ? AND : OR ;
@@ -2059,15 +3130,15 @@ Type invalide.\n",
 			{
 			  if (calcs_vars_count != comp_op_count)
 			    {
-			      printf("Expression invalide: %s", line);
-			      exit(1);
+			      fprintf(out, "Expression invalide: %s", line);
+			      return 1;
 			    }
 			  if (*pch == '=' || *pch == '!')
 			    {
 			      if ( *(pch+1) != '=')
 				{
-				  printf("Expression invalide: %s", line);
-				  exit(1);
+				  fprintf(out, "Expression invalide: %s", line);
+				  return 1;
 				}
 
 			      comp_op_list[bool_rank][calcs_vars_count]
@@ -2093,8 +3164,8 @@ Type invalide.\n",
 
 			  if (*pch == '\n')
 			    {
-			      printf("Expression invalide: %s", line);
-			      exit(1);
+			      fprintf(out, "Expression invalide: %s", line);
+			      return 1;
 			    }
 
 			  pch_h = pch;
@@ -2110,15 +3181,32 @@ Type invalide.\n",
 			    = (char*) malloc ( strlen(pch) + 1);
 
 			  strcpy (data_comp_list[bool_rank]
-				  [calcs_vars_count++], pch) ;
+				  [calcs_vars_count], pch) ;
+
+			  /* Dictionnaire de la variable discrète */
+			  dict = dictionaries;
+			  for (int r = 0; var_type == DISCRETE
+				 && r < var_relative_rank; ++r)
+			    dict += vars_types[r] == DISCRETE;
+
+			  /* La comparaison est résolue une fois pour toutes */
+			  lower_predicate (bool_preds[bool_rank]
+					   + calcs_vars_count, var_type,
+					   bool_vars_ranks[bool_rank]
+					   [calcs_vars_count],
+					   comp_op_list[bool_rank]
+					   [calcs_vars_count],
+					   data_comp_list[bool_rank]
+					   [calcs_vars_count], dict);
+			  calcs_vars_count++;
 
 			  *pch_h = to_save;
 			  pch = pch_h;
 			}
 		      else
 			{
-			  printf("Expression invalide: %s", line);
-			  exit(1);
+			  fprintf(out, "Expression invalide: %s", line);
+			  return 1;
 			}
 		    }
 		  else
@@ -2127,11 +3215,17 @@ Type invalide.\n",
 
 	      if (! calcs_vars_count)
 		{
-		  printf("Expression invalide! Il faut utiliser au moins \
-une variable: %s", line) ;
-		  exit(1);
+		  fprintf(out, "Expression invalide! Il faut utiliser au moins \
+une variable: %s", line);
+		  return 1;
 		}
 
+	      /* Évaluation de gauche à droite: chaque comparaison est
+	       * combinée au résultat de celles qui la précèdent. */
+	      bool_preds[bool_rank][0].link = OR;
+	      for (int i = 1; i < calcs_vars_count; ++i)
+		bool_preds[bool_rank][i].link = bool_op_list[bool_rank][i-1];
+
 	      bool_vars_count[bool_rank++] = calcs_vars_count;
 	      break;
 
@@ -2143,11 +3237,12 @@ une variable: %s", line) ;
 	      while ( ! isspace (*pch_h) );
 
 	      *pch_h = NUL;
-	      find_var_type_and_rank(pch, vars_count, vars_list, vars_types,
-				     calcs_count, calcs_labels,
-				     total_loc_count, loc_labels,
-				     bool_count, bool_labels, &var_type,
-				     &var_relative_rank) ;
+	      if (find_var_type_and_rank(pch, vars_count, vars_list, vars_types,
+					 calcs_count, calcs_labels,
+					 total_loc_count, loc_labels,
+					 bool_count, bool_labels, &var_type,
+					 &var_relative_rank, out))
+		return 1;
 
 	      switch (var_type)
 		{
@@ -2176,8 +3271,10 @@ une variable: %s", line) ;
   /* Remplir le struct */
   to_fill->calcs_list     = calcs_list     ;
   to_fill->calcs_labels   = calcs_labels   ;
+  to_fill->calcs_progs    = calcs_progs    ;
   to_fill->loc_list       = loc_list       ;
   to_fill->loc_labels     = loc_labels     ;
+  to_fill->loc_progs      = loc_progs      ;
 
   to_fill->calcs_relative_ranks = calcs_relative_ranks ;
   to_fill->calcs_vars_types     = calcs_vars_types     ;
@@ -2189,6 +3286,7 @@ une variable: %s", line) ;
   to_fill->bool_op_list         = bool_op_list     ;
   to_fill->comp_op_list         = comp_op_list     ;
   to_fill->data_comp_list       = data_comp_list   ;
+  to_fill->bool_preds           = bool_preds       ;
   to_fill->bool_labels          = bool_labels      ;
 
   to_fill->cond_vars_rank       = cond_vars_rank   ;
@@ -2200,6 +3298,7 @@ une variable: %s", line) ;
   to_fill->ICR_vars_types = ICR_vars_types ;
   to_fill->ICR_vars_inv = ICR_vars_inv ;
 
+  to_fill->dictionaries        = dictionaries        ;
   to_fill->discrete_vars_count = discrete_vars_count ;
   to_fill->calcs_count         = calcs_count         ;
   to_fill->loc_count           = loc_count           ;
@@ -2209,33 +3308,35 @@ une variable: %s", line) ;
 
   if (ICR_vars_count && ICR_cmp_rank < 0)
     {
-      puts("Des variables d\'ICR existent, mais aucun comparateur n'a été \
-donné.");
-      exit(1);
+      fprintf(out, "Des variables d\'ICR existent, mais aucun comparateur \
+n'a été donné.\n");
+      return 1;
     }
 
   else if (inv_ready)
     {
-      printf("Il faut préciser l'inversion de la variable '%s'\n",
-	     vars_list[ICR_vars_ranks[ICR_rank]]) ;
-      exit (1);
+      fprintf(out, "Il faut préciser l'inversion de la variable '%s'\n",
+	      vars_list[ICR_vars_ranks[ICR_rank]]);
+      return 1;
     }
 
   else if (bool_ready)
     {
-      printf("Il faut préciser la condition du calcul: %s\n",
-	     loc_list[cond_rank]);
-      exit(1);
+      fprintf(out, "Il faut préciser la condition du calcul: %s\n",
+	      loc_list[cond_rank]);
+      return 1;
     }
 
   else
-    return;
+    return 0;
 }
 
 /*
  * Retourne le rang de la variable 'var'. (variables standards seulement)
+ * Retourne -1, avec la liste des variables dans 'out', si elle n'existe
+ * pas.
  */
-int find_var_rank (char *var, int vars_count, char **vars_list)
+int find_var_rank (char *var, int vars_count, char **vars_list, FILE *out)
 {
   for (int i = 0; i < vars_count; ++i)
     {
@@ -2244,22 +3345,24 @@ int find_var_rank (char *var, int vars_count, char **vars_list)
 	  return i;
 	}
     }
-  printf("'%s' n'est pas une variable reconnue. ", var);
-  printf("Voici une liste des variables disponibles:\n");
+  fprintf(out, "'%s' n'est pas une variable reconnue. ", var);
+  fprintf(out, "Voici une liste des variables disponibles:\n");
   for (int i = 0; i < vars_count; i++)
-    printf(" - %s\n", vars_list[i]);
-  exit(1);
+    fprintf(out, " - %s\n", vars_list[i]);
+  return -1;
 }
 
 /*
  * Trouve le type et le rang de la variable 'var'. (toutes les variables
- * traitées jusqu'à l'appel de la fonction)
+ * traitées jusqu'à l'appel de la fonction) Retourne 1, avec la liste des
+ * variables dans 'out', si elle n'existe pas.
  */
-void find_var_type_and_rank (char *var, int vars_count, char **vars_list,
-			     int *vars_types, int calcs_count,
-			     char **calcs_labels, int loc_count,
-			     char **loc_labels, int bool_count,
-			     char **bool_labels, int *type, int *rank)
+int find_var_type_and_rank (char *var, int vars_count, char **vars_list,
+			    int *vars_types, int calcs_count,
+			    char **calcs_labels, int loc_count,
+			    char **loc_labels, int bool_count,
+			    char **bool_labels, int *type, int *rank,
+			    FILE *out)
 {
   for (int i = 0; i < vars_count; ++i)
     {
@@ -2267,7 +3370,7 @@ void find_var_type_and_rank (char *var, int vars_count, char **vars_list,
 	{
 	  *type = vars_types[i];
 	  *rank = i;
-	  return;
+	  return 0;
 	}
     }
   for (int i = 0; i < calcs_count; ++i)
@@ -2277,7 +3380,7 @@ void find_var_type_and_rank (char *var, int vars_count, char **vars_list,
 	  {
 	    *type = GLOB_CALC;
 	    *rank = i;
-	    return;
+	    return 0;
 	  }
     }
   for (int i = 0; i < loc_count; ++i)
@@ -2287,7 +3390,7 @@ void find_var_type_and_rank (char *var, int vars_count, char **vars_list,
 	  {
 	    *type = LOC_CALC;
 	    *rank = i;
-	    return;
+	    return 0;
 	  }
     }
   for (int i = 0; i < bool_count; ++i)
@@ -2296,565 +3399,1554 @@ void find_var_type_and_rank (char *var, int vars_count, char **vars_list,
 	{
 	  *type = CUSTOM_BOOLEAN;
 	  *rank = i;
-	  return;
+	  return 0;
 	}
     }
-  printf("'%s'n'est pas une variable reconnue. ", var);
-  printf("Voici une liste des variables disponibles:\n");
+  fprintf(out, "'%s'n'est pas une variable reconnue. ", var);
+  fprintf(out, "Voici une liste des variables disponibles:\n");
   int i;
   for (i = 0; i < vars_count; i++)
-    printf(" - %s\n", vars_list[i]);
+    fprintf(out, " - %s\n", vars_list[i]);
   for (i = 0; i < calcs_count; i++)
     if (calcs_labels[i] != NULL)
-      printf(" - %s\n", calcs_labels[i]);
+      fprintf(out, " - %s\n", calcs_labels[i]);
   for (i = 0; i < loc_count; i++)
     if (loc_labels[i] != NULL)
-      printf(" - %s\n", loc_labels[i]);
+      fprintf(out, " - %s\n", loc_labels[i]);
   for (i = 0; i < bool_count; i++)
-    printf(" - %s\n", bool_labels[i]);
-  exit(1);
+    fprintf(out, " - %s\n", bool_labels[i]);
+  return 1;
 }
 
 /*
- * Vérifie si le délimiteur existe. (pour les calculs)
+ * Vérifie si le délimiteur existe. (pour les calculs) Retourne 1, avec
+ * l'erreur dans 'out', s'il n'existe pas.
  */
-void check_delim_exist (char delim)
+int check_delim_exist (char delim, FILE *out)
 {
   for (int i = 0; i < 7; i++)
     {
       /* delims est un tableau à portée globale défini dans eval.h: le fait
        * qu'il soit global provient du code original */
       if (delim == delims[i])
-	return;
+	return 0;
+    }
+  fprintf(out, "Le délimiteur '%c' dans les calculs n'est pas valide.\n",
+	  delim);
+  return 1;
+}
+
+/*
+ * Ligne suivante d'un fichier Summary.gz, qui doit exister. Retourne
+ * NULL, avec l'erreur dans 'out', si le fichier est incomplet.
+ */
+char *summary_next (reader *rd, FILE *out)
+{
+  size_t length;
+  char   *row = reader_next (rd, &length);
+
+  if (row == NULL)
+    fprintf(out, "Fichier incomplet: %s\n", rd->path);
+  return row;
+}
+
+/*
+ * Résout une comparaison d'expression booléenne: type de lecture, masque
+ * de résultats et constante déjà convertie.
+ */
+void lower_predicate (predicate *pred, int var_type, int slot, int comp_op,
+		      char *constant, dictionary *dict)
+{
+  static const int masks[] = { 0, 0, /* AND, OR */
+			       EQ_BIT, LT_BIT | GT_BIT | UNORD_BIT,
+			       GT_BIT, GT_BIT | EQ_BIT,
+			       LT_BIT, LT_BIT | EQ_BIT };
+
+  pred->slot     = slot;
+  pred->mask     = masks[comp_op];
+  pred->constant = parse_number (constant);
+  pred->kind     = NUM_CMP;
+
+  switch (var_type)
+    {
+    case BOOLEAN: case CUSTOM_BOOLEAN:
+      /* Valeurs 0/1 dans la cache: une autre constante que true/false
+       * n'est jamais égale (NaN) */
+      if (comp_op == EQ || comp_op == NE)
+	{
+	  if (! strcmp (constant, "true"))
+	    pred->constant = 1;
+	  else if (! strcmp (constant, "false"))
+	    pred->constant = 0;
+	  else
+	    pred->constant = NAN;
+	}
+      break;
+
+    case DISCRETE:
+      /* Égalité: comparer les identifiants du dictionnaire. Sinon, la
+       * valeur numérique de la cache suffit. */
+      if (comp_op == EQ || comp_op == NE)
+	{
+	  pred->kind = ID_CMP;
+	  pred->id   = dictionary_intern (dict, constant, strlen (constant),
+					  &pred->constant);
+	}
+      break;
+    }
+}
+
+/*
+ * Évalue une comparaison pour les 'rows' individus d'un bloc et combine
+ * le résultat (selon pred->link) avec celui de l'expression jusqu'ici.
+ * Même résultat que l'évaluation de gauche à droite avec court-circuit:
+ * une comparaison n'a pas d'effet de bord.
+ */
+void test_predicate (const predicate *pred, const double *values,
+		     const unsigned int *ids, int rows,
+		     unsigned char *state)
+{
+  const int    and_link = pred->link == AND;
+  const int    mask     = pred->mask;
+  const double constant = pred->constant;
+  const unsigned int id = pred->id;
+  unsigned char test;
+  double value;
+  int outcome, r;
+
+  if (pred->kind == ID_CMP)
+    {
+#pragma omp simd private(outcome, test)
+      for (r = 0; r < rows; ++r)
+	{
+	  outcome = ids[r] == id ? EQ_BIT : UNORD_BIT;
+	  test = (mask & outcome) != 0;
+	  state[r] = and_link ? (state[r] & test) : (state[r] | test);
+	}
+      return;
+    }
+
+#pragma omp simd private(value, outcome, test)
+  for (r = 0; r < rows; ++r)
+    {
+      value = values[r];
+      outcome = (value < constant) | (value == constant) << 1
+	| (value > constant) << 2;
+      outcome |= (! outcome) << 3;
+
+      test = (mask & outcome) != 0;
+      state[r] = and_link ? (state[r] & test) : (state[r] | test);
     }
-  printf("Le délimiteur '%c' dans les calculs n'est pas valide.\n", delim);
-  exit(1);
+}
+
+/*
+ * Agrandit un tableau de comptes pour y inclure l'identifiant 'id'.
+ */
+void grow_counts (discrete_counts *counts, unsigned int id)
+{
+  unsigned int size = counts->size ? counts->size : 8;
+
+  while (size <= id)
+    size *= 2;
+
+  counts->counts = (unsigned int*) realloc (counts->counts,
+					    sizeof(unsigned int) * size);
+  memset (counts->counts + counts->size, 0,
+	  sizeof(unsigned int) * (size - counts->size));
+  counts->size = size;
+}
+
+/*
+ * Agrandit un tableau de statistiques pour y inclure l'identifiant 'id'.
+ */
+void grow_stats (discrete_stats *stats, unsigned int id)
+{
+  unsigned int size = stats->size ? stats->size : 8;
+
+  while (size <= id)
+    size *= 2;
+
+  stats->stats = (welford*) realloc (stats->stats, sizeof(welford) * size);
+  memset (stats->stats + stats->size, 0,
+	  sizeof(welford) * (size - stats->size));
+  stats->size = size;
+}
+
+/*
+ * Ajoute à 'counts' les comptes sauvegardés d'un fichier (leur nombre,
+ * puis un compte par identifiant sauvegardé), traduits dans les
+ * identifiants du dictionnaire courant.
+ */
+void load_counts (discrete_counts *counts, const char *saved,
+		  const unsigned int *ids_map)
+{
+  unsigned int counts_size, count;
+
+  memcpy (&counts_size, saved, sizeof(unsigned int));
+  saved += sizeof(unsigned int);
+
+  for (unsigned int id = 0; id < counts_size; ++id)
+    {
+      memcpy (&count, saved + id * sizeof(unsigned int),
+	      sizeof(unsigned int));
+      if (! count)
+	continue;
+
+      if (ids_map[id] >= counts->size)
+	grow_counts (counts, ids_map[id]);
+      counts->counts[ids_map[id]] = count;
+    }
+}
+
+/*
+ * Clé de chaque colonne de parse_csv (mêmes rangs): un hash de la
+ * définition de la colonne et des clés des colonnes dont elle dépend. Les
+ * colonnes sont prises dans l'ordre où parse_csv les évalue. Un libellé
+ * ou des espaces différents ne changent donc pas la clé d'un calcul, mais
+ * un changement à une variable ou à un calcul qu'il utilise, oui.
+ */
+void column_keys (const conf_args *conf, char **vars_list,
+		  const int *vars_types, int vars_count, uint64_t *keys)
+{
+  const predicate *pred;
+  const char *pch;
+  cache_buffer def;
+  char tag;
+  int  k, p, slot, quoted;
+
+  memset (keys, 0, sizeof(uint64_t) * (vars_count + conf->total_loc_count
+				       + conf->bool_count));
+  cache_buffer_init (&def);
+
+  /* Variables: nom et type */
+  for (k = 0; k < vars_count; ++k)
+    {
+      def.size = 0;
+      tag = 'v';
+      cache_buffer_add (&def, &tag, 1);
+      cache_buffer_add (&def, vars_types + k, sizeof(int));
+      cache_buffer_add (&def, vars_list[k], strlen(vars_list[k]) + 1);
+      keys[k] = cache_hash (def.data, def.size, 0);
+    }
+
+  for (k = 0; k < conf->total_loc_count + conf->bool_count; ++k)
+    {
+      def.size = 0;
+
+      /* Expressions booléennes: après les calculs locaux */
+      if (k >= conf->loc_count && k < conf->loc_count + conf->bool_count)
+	{
+	  int b = k - conf->loc_count;
+
+	  slot = vars_count + k;
+	  tag  = 'b';
+	  cache_buffer_add (&def, &tag, 1);
+
+	  for (p = 0; p < conf->bool_vars_count[b]; ++p)
+	    {
+	      pred = conf->bool_preds[b] + p;
+	      cache_buffer_add (&def, keys + pred->slot, sizeof(uint64_t));
+	      cache_buffer_add (&def, &pred->kind, sizeof(int));
+	      cache_buffer_add (&def, &pred->mask, sizeof(int));
+	      cache_buffer_add (&def, &pred->link, sizeof(int));
+	      cache_buffer_add (&def, conf->data_comp_list[b][p],
+				strlen(conf->data_comp_list[b][p]) + 1);
+	    }
+
+	  keys[slot] = cache_hash (def.data, def.size, 0);
+	  continue;
+	}
+
+      /* Calculs locaux, puis conditionnels */
+      int calc = k < conf->loc_count ? k : k - conf->bool_count;
+
+      slot = vars_count + (calc < conf->loc_count ? calc
+			   : conf->bool_count + calc);
+      tag  = calc < conf->loc_count ? 'l' : 'c';
+      cache_buffer_add (&def, &tag, 1);
+
+      /* Le calcul sans les espaces (hors des noms de variables) */
+      quoted = 0;
+      for (pch = conf->loc_list[calc]; *pch; ++pch)
+	{
+	  if (*pch == '"')
+	    quoted = ! quoted;
+	  if (quoted || ! isspace (*pch))
+	    cache_buffer_add (&def, pch, 1);
+	}
+      cache_buffer_add (&def, "", 1);
+
+      for (p = 0; p < conf->loc_vars_count[calc]; ++p)
+	cache_buffer_add (&def, keys + conf->loc_vars_ranks[calc][p],
+			  sizeof(uint64_t));
+
+      if (calc >= conf->loc_count)
+	cache_buffer_add (&def, keys + conf->cond_vars_rank
+			  [calc - conf->loc_count], sizeof(uint64_t));
+
+      keys[slot] = cache_hash (def.data, def.size, 0);
+    }
+
+  cache_buffer_free (&def);
+}
+
+/*
+ * Découpe un fichier à parser aux points de son index d'accès
+ * ('index_file'), s'il est à jour et qu'aucun magasin de colonnes n'est
+ * lu à sa place. Une tranche commence au premier bloc de SUM_ROWS
+ * individus qui suit un point; sa lecture part du dernier point avant ce
+ * bloc et s'arrête au premier point après son dernier individu. Les
+ * points au-delà de la population, ou dont la ligne n'a été trouvée
+ * qu'à la fin du texte, sont ignorés. Les totaux des blocs et des
+ * tranches sont alloués selon 'args'. Retourne NULL si le fichier reste
+ * entier.
+ */
+file_chunks *chunk_file (const char *index_file, const char *store_file,
+			 const cache_stamp *stamp, int pop,
+			 const thread_args *args)
+{
+  gzindex ix;
+  int     *points, *ends, *rows, count, blocks, n, p, c, row;
+  uint64_t line;
+
+  if (store_current (store_file, stamp)
+      || ! gzindex_open (&ix, index_file, stamp))
+    return NULL;
+
+  /* Le premier point doit être au début du texte (l'en-tête) */
+  n = ix.header->points_count;
+  if (n < 2 || ix.points[0].line != 0)
+    {
+      gzindex_close (&ix);
+      return NULL;
+    }
+
+  points = (int*) malloc (sizeof(int) * (n + 1));
+  ends   = (int*) malloc (sizeof(int) * (n + 1));
+  rows   = (int*) malloc (sizeof(int) * (n + 1));
+  count  = 0;
+
+  /* La ligne 0 est l'en-tête: l'individu r est à la ligne r + 1 */
+  for (p = 0; p < n; ++p)
+    {
+      line = ix.points[p].line;
+      if (line > (uint64_t) pop || ix.points[p].row >= ix.header->text_size)
+	break;
+
+      row = line ? line - 1 : 0;
+      row = (row + SUM_ROWS - 1) / SUM_ROWS * SUM_ROWS;
+      if (row >= pop)
+	break;
+
+      /* Même bloc: la lecture part du point le plus proche */
+      if (count && row == rows[count - 1])
+	{
+	  points[count - 1] = p;
+	  continue;
+	}
+
+      points[count] = p;
+      rows[count]   = row;
+      count++;
+    }
+
+  rows[count] = pop;
+
+  for (c = 0; c < count; ++c)
+    {
+      for (p = points[c] + 1;
+	   p < n && ix.points[p].line <= (uint64_t) rows[c + 1]; ++p)
+	;
+      ends[c] = p;
+    }
+
+  if (count < 2)
+    {
+      free (points);
+      free (ends);
+      free (rows);
+      gzindex_close (&ix);
+      return NULL;
+    }
+
+  file_chunks *chunks = new file_chunks;
+
+  chunks->index  = ix;
+  chunks->count  = count;
+  chunks->points = points;
+  chunks->ends   = ends;
+  chunks->rows   = rows;
+  chunks->left.store (count, std::memory_order_relaxed);
+
+  blocks = (pop + SUM_ROWS - 1) / SUM_ROWS;
+  chunks->acc_sums = (double*) malloc (sizeof(double) * blocks
+				       * (args->acc_vars_count + 1));
+  chunks->loc_sums = (double*) malloc (sizeof(double) * blocks
+				       * (args->total_loc_count + 1));
+  chunks->bool_sums = (unsigned int*) malloc
+    (sizeof(unsigned int) * count * (args->bool_vars_count + 1));
+  chunks->c_bool_sums = (unsigned int*) malloc
+    (sizeof(unsigned int) * count * (args->c_bool_count + 1));
+  chunks->counts = (discrete_counts*) calloc
+    (count * args->discrete_vars_count + 1, sizeof(discrete_counts));
+
+  return chunks;
+}
+
+/*
+ * Garde les comptes de la tranche 'chunk' d'un fichier découpé (les
+ * totaux de ses blocs y sont déjà, voir close_block). Si c'est la
+ * dernière tranche à terminer, les totaux de tous les blocs sont
+ * additionnés dans l'ordre des blocs, et les comptes de toutes les
+ * tranches dans l'ordre des tranches: ceux du fichier remplacent ceux de
+ * la tranche, et les comptes des variables discrètes s'ajoutent à
+ * 'counts'. Retourne 1 dans ce cas seulement.
+ */
+int merge_chunk (const thread_args *args, file_chunks *chunks, int chunk,
+		 double *acc_sums, unsigned int *bool_sums, double *loc_sums,
+		 unsigned int *c_bool_sums, discrete_counts *counts)
+{
+  int    b, c, k;
+  int    blocks = (chunks->rows[chunks->count] + SUM_ROWS - 1) / SUM_ROWS;
+  unsigned int id, count;
+  double sum;
+  discrete_counts *part;
+
+  memcpy (chunks->bool_sums + chunk * args->bool_vars_count, bool_sums,
+	  sizeof(unsigned int) * args->bool_vars_count);
+  memcpy (chunks->c_bool_sums + chunk * args->c_bool_count, c_bool_sums,
+	  sizeof(unsigned int) * args->c_bool_count);
+
+  /* Les totaux des autres tranches sont visibles par la dernière */
+  if (chunks->left.fetch_sub (1, std::memory_order_acq_rel) > 1)
+    return 0;
+
+  for (k = 0; k < args->acc_vars_count; ++k)
+    {
+      sum = 0;
+      for (b = 0; b < blocks; ++b)
+	sum += chunks->acc_sums[b * args->acc_vars_count + k];
+      acc_sums[k] = sum;
+    }
+
+  for (k = 0; k < args->bool_vars_count; ++k)
+    {
+      count = 0;
+      for (c = 0; c < chunks->count; ++c)
+	count += chunks->bool_sums[c * args->bool_vars_count + k];
+      bool_sums[k] = count;
+    }
+
+  for (k = 0; k < args->total_loc_count; ++k)
+    {
+      sum = 0;
+      for (b = 0; b < blocks; ++b)
+	sum += chunks->loc_sums[b * args->total_loc_count + k];
+      loc_sums[k] = sum;
+    }
+
+  for (k = 0; k < args->c_bool_count; ++k)
+    {
+      count = 0;
+      for (c = 0; c < chunks->count; ++c)
+	count += chunks->c_bool_sums[c * args->c_bool_count + k];
+      c_bool_sums[k] = count;
+    }
+
+  for (c = 0; c < chunks->count; ++c)
+    for (k = 0; k < args->discrete_vars_count; ++k)
+      {
+	part = chunks->counts + c * args->discrete_vars_count + k;
+
+	if (part->size && part->size > counts[k].size)
+	  grow_counts (counts + k, part->size - 1);
+
+	for (id = 0; id < part->size; ++id)
+	  counts[k].counts[id] += part->counts[id];
+
+	free (part->counts);
+	part->counts = NULL;
+	part->size   = 0;
+      }
+
+  return 1;
+}
+
+void free_chunks (file_chunks *chunks, int discrete_vars_count)
+{
+  for (int k = 0; k < chunks->count * discrete_vars_count; ++k)
+    free (chunks->counts[k].counts);
+
+  gzindex_close (&chunks->index);
+  free (chunks->points);
+  free (chunks->ends);
+  free (chunks->rows);
+  free (chunks->acc_sums);
+  free (chunks->bool_sums);
+  free (chunks->loc_sums);
+  free (chunks->c_bool_sums);
+  free (chunks->counts);
+  delete chunks;
+}
+
+/*
+ * Ferme le total partiel du bloc de SUM_ROWS individus 'block': gardé
+ * avec ceux des autres blocs d'un fichier découpé ('chunks'), sinon
+ * additionné aux totaux du fichier ('acc_total', 'loc_total'). Les deux
+ * cas additionnent donc les mêmes totaux partiels dans le même ordre.
+ */
+void close_block (const thread_args *args, file_chunks *chunks, int block,
+		  double *acc_sums, double *loc_sums, double *acc_total,
+		  double *loc_total)
+{
+  int k;
+
+  if (chunks != NULL)
+    {
+      memcpy (chunks->acc_sums + block * args->acc_vars_count, acc_sums,
+	      sizeof(double) * args->acc_vars_count);
+      memcpy (chunks->loc_sums + block * args->total_loc_count, loc_sums,
+	      sizeof(double) * args->total_loc_count);
+    }
+  else
+    {
+      for (k = 0; k < args->acc_vars_count; ++k)
+	acc_total[k] += acc_sums[k];
+      for (k = 0; k < args->total_loc_count; ++k)
+	loc_total[k] += loc_sums[k];
+    }
+
+  memset (acc_sums, 0, sizeof(double) * args->acc_vars_count);
+  memset (loc_sums, 0, sizeof(double) * args->total_loc_count);
+}
+
+/*
+ * Demande la lecture anticipée du fichier (ou de la tranche) de la tâche
+ * 'ahead': son magasin de colonnes s'il est à jour, sinon le fichier
+ * texte.
+ */
+void prefetch_task (const thread_args *args, const task *ahead)
+{
+  char path  [BUFFER_SIZE];
+  char store [BUFFER_SIZE];
+  const char *name = args->scenarios_list[ahead->scen];
+  int  file = args->first_files[ahead->scen] + ahead->iter;
+  file_chunks *chunks;
+  long first, end;
+  int  point, next;
+
+  snprintf (path, BUFFER_SIZE, "%s%s/%d_Output.gz", args->path, name,
+	    ahead->iter);
+
+  /* Une tranche: du bloc de son premier point (et l'octet qui le
+   * précède) à celui du point qui la termine */
+  chunks = ahead->chunk < 0 ? NULL : args->chunked[file];
+  if (chunks != NULL)
+    {
+      point = chunks->points[ahead->chunk];
+      next  = chunks->ends[ahead->chunk];
+      first = (long) chunks->index.points[point].in;
+      end   = next < (int) chunks->index.header->points_count
+	? (long) chunks->index.points[next].in : args->stamps[file].size;
+
+      first = first > 0 ? first - 1 : 0;
+      prefetch_submit (args->prefetch, path, NULL, NULL, first,
+		       end - first);
+      return;
+    }
+
+  snprintf (store, BUFFER_SIZE, "%s%s/%d_Output.col", args->store_path,
+	    name, ahead->iter);
+  prefetch_submit (args->prefetch, path, store, args->stamps + file, 0, 0);
 }
 
 /*
  * Parcourt les fichiers CSV.
+ *
+ * Les individus sont traités par blocs de 'batch_size' lignes: chaque
+ * bloc est d'abord lu dans des colonnes (une par variable, calcul ou
+ * expression), puis chaque accumulation, calcul et comparaison se fait
+ * en une boucle sur toute la colonne. Les sommes sont faites dans
+ * l'ordre des individus: les résultats restent les mêmes qu'en traitant
+ * un individu à la fois.
+ *
+ * Une tâche peut aussi n'être qu'une tranche d'un fichier découpé (voir
+ * chunk_file): ses totaux sont additionnés à ceux des autres tranches
+ * par merge_chunk, et seule la dernière tranche publie le fichier.
+ *
+ * Les sommes des variables et des calculs se font par blocs de SUM_ROWS
+ * individus (voir close_block): un fichier a exactement les mêmes
+ * totaux, qu'il soit lu d'un bout à l'autre ou en tranches, à partir du
+ * texte, d'un magasin de colonnes ou d'une archive.
  */
 void * parse_csv (void *ptr)
 {
   /* Transformer un pointeur void en pointeur de struct */
   thread_args *struct_Ptr = (thread_args *) ptr;
 
-  int str_length  = strlen (struct_Ptr->path) + strlen (struct_Ptr->name);
   char file_path [BUFFER_SIZE] ;
-  strcpy (file_path, struct_Ptr->path);
-  strcat (file_path, struct_Ptr->name);
-
-  char line [BUFFER_SIZE] ;
-  char iter_buffer [32] ;
   char *dump ; /* Pour rendre une fonction thread-safe */
 
-  int i, v, k, p ;
+  int i, v, k, p, r ;
+
+  /* Le fichier en cours, et les colonnes qu'il doit produire */
+  task current;
+  char *name;
+  const unsigned char *slots;
 
   int acc_vars_rank  ;
   int bool_vars_rank ;
   int dis_vars_rank  ;
 
-  int current_c_bool_state;
-  int previous_c_bool_state;
-
-  /* offset pour variables accumulatrices */
-  int offset_acc = ( ( struct_Ptr->iters_count * struct_Ptr->acc_vars_count
-		       * struct_Ptr->num_scen )
-		     + ( struct_Ptr->lower_lim
-			 * struct_Ptr->acc_vars_count ) );
-
-  /* offset pour variables booléennes */
-  int offset_bo = ( ( struct_Ptr->iters_count * struct_Ptr->bool_vars_count
-		    * struct_Ptr->num_scen )
-		   + ( struct_Ptr->lower_lim
-		       * struct_Ptr->bool_vars_count ) );
-
-  /* offset pour variables discrètes */
-  int offset_dis = ( ( struct_Ptr->iters_count
-		       * struct_Ptr->discrete_vars_count
-		       * struct_Ptr->num_scen )
-		     + ( struct_Ptr->lower_lim
-			 * struct_Ptr->discrete_vars_count ) );
-
-  /* offset pour calculs */
-  int offset_loc = ((struct_Ptr->iters_count * struct_Ptr->total_loc_count
-		       * struct_Ptr->num_scen )
-		     + ( struct_Ptr->lower_lim
-			 * struct_Ptr->total_loc_count) );
-
-  /* offset pour booléens personnalisés */
-  int offset_c_bo = ( ( struct_Ptr->iters_count * struct_Ptr->c_bool_count
-			* struct_Ptr->num_scen )
-		      + ( struct_Ptr->lower_lim
-			  * struct_Ptr->c_bool_count ) );
-
-  /* On initialise sa part des tableaux de résultats à 0 */
-  memset ( struct_Ptr->acc_results + offset_acc, 0,
-	   sizeof(double) * ( ( struct_Ptr->upper_lim
-				- struct_Ptr->lower_lim )
-			      * struct_Ptr->acc_vars_count ) );
-
-  memset ( struct_Ptr->bool_results + offset_bo, 0,
-	   sizeof(unsigned int) * ( ( struct_Ptr->upper_lim
-				      - struct_Ptr->lower_lim )
-				    * struct_Ptr->bool_vars_count ) );
-
-  memset ( struct_Ptr->loc_results + offset_loc, 0,
-	   sizeof(double) * ( (struct_Ptr->upper_lim
-			       - struct_Ptr->lower_lim)
-			      * struct_Ptr->total_loc_count ) );
-
-  memset ( struct_Ptr->c_bool_results + offset_c_bo, 0,
-	   sizeof(unsigned int) * ( (struct_Ptr->upper_lim
-				     - struct_Ptr->lower_lim)
-				    * struct_Ptr->c_bool_count ) );
-
-  /* Évite une multiplication dans la boucle for */
-  offset_acc  -= struct_Ptr->acc_vars_count      ;
-  offset_bo   -= struct_Ptr->bool_vars_count     ;
-  offset_dis  -= struct_Ptr->discrete_vars_count ;
-  offset_loc  -= struct_Ptr->total_loc_count     ;
-  offset_c_bo -= struct_Ptr->c_bool_count        ;
-
-  string value;
-  double num_value;
-
-  /* Une cache qui contient les informations sur le dernier individu. */
-  last_value *cache = (last_value*) malloc
-    (sizeof(last_value)
+  const predicate *pred, *end_pred;
+
+  /* Rang du fichier en cours dans les tenseurs de résultats */
+  int file, offset_dis;
+
+  /* Totaux du fichier en cours, propres au thread (chacun sur ses
+   * propres lignes de cache): les tableaux partagés ne sont touchés
+   * qu'une fois par fichier. */
+  double *acc_sums = (double*) cache_aligned_alloc
+    (sizeof(double) * struct_Ptr->acc_vars_count);
+  unsigned int *bool_sums = (unsigned int*) cache_aligned_alloc
+    (sizeof(unsigned int) * struct_Ptr->bool_vars_count);
+  double *loc_sums = (double*) cache_aligned_alloc
+    (sizeof(double) * struct_Ptr->total_loc_count);
+  unsigned int *c_bool_sums = (unsigned int*) cache_aligned_alloc
+    (sizeof(unsigned int) * struct_Ptr->c_bool_count);
+
+  /* Les totaux ci-dessus sont ceux du bloc de SUM_ROWS individus en
+   * cours; ceux du fichier entier les additionnent bloc par bloc */
+  double *acc_total = (double*) cache_aligned_alloc
+    (sizeof(double) * struct_Ptr->acc_vars_count);
+  double *loc_total = (double*) cache_aligned_alloc
+    (sizeof(double) * struct_Ptr->total_loc_count);
+
+  double sum;
+  unsigned int count;
+
+  /* Variables discrètes: table locale des valeurs déjà rencontrées */
+  dict_cache *dict_caches = (dict_cache*) malloc
+    (sizeof(dict_cache) * (struct_Ptr->discrete_vars_count + 1));
+  for (k = 0; k < struct_Ptr->discrete_vars_count; ++k)
+    dict_cache_init (dict_caches + k, struct_Ptr->dictionaries + k);
+
+  discrete_counts *counts;
+  unsigned int id;
+
+  /* Mode --streaming: les comptes du fichier en cours */
+  discrete_counts *file_counts = (discrete_counts*) calloc
+    (struct_Ptr->discrete_vars_count + 1, sizeof(discrete_counts));
+
+  /* Les colonnes du bloc en cours: variables standards, calculs locaux,
+   * expressions booléennes puis calculs conditionnels (même rangs que
+   * dans la configuration). Les variables discrètes gardent aussi les
+   * identifiants de leurs valeurs. */
+  int batch_size = struct_Ptr->batch_size;
+  int rows;
+
+  double *columns = (double*) malloc
+    (sizeof(double) * batch_size
      * (struct_Ptr->vars_count + struct_Ptr->total_loc_count
 	+ struct_Ptr->c_bool_count));
+  unsigned int *ids = (unsigned int*) malloc
+    (sizeof(unsigned int) * batch_size * struct_Ptr->vars_count);
+  double *column, *cond;
+
+  /* Résultats d'une expression booléenne, erreurs d'un calcul */
+  unsigned char *state = (unsigned char*) malloc (batch_size);
+  char *errors = (char*) malloc (batch_size);
+
+  /* Les colonnes des variables d'un calcul local */
+  int max_loc_vars = 1;
+  for (k = 0; k < struct_Ptr->total_loc_count; ++k)
+    if (struct_Ptr->loc_vars_count[k] > max_loc_vars)
+      max_loc_vars = struct_Ptr->loc_vars_count[k];
+
+  const double **operands = (const double**) malloc (sizeof(double*)
+						     * max_loc_vars);
+  int return_check;
 
-  char tokenizer [BUFFER_SIZE]; /* pour recevoir une copie qui sera
-				 * mise en morceaux par strtok_r */
-  char buffer    [BUFFER_SIZE];
+  char   *parsing, *row;
+  size_t row_length;
+  reader p_file;
+  int    opened;
+
+  /* Magasin de colonnes du fichier en cours: dictionnaire, valeur et
+   * identifiant (trouvé à la première rencontre) de chaque entrée */
+  char   store_file [BUFFER_SIZE];
+  store  st;
+  int    stored;
+  double num;
+
+  /* L'index d'accès du fichier en cours, s'il doit être construit */
+  char   index_file [BUFFER_SIZE];
+  const cache_stamp *stamp;
+  gzindex_builder index;
+  int    indexing;
+
+  /* Le fichier découpé dont la tâche est une tranche (NULL: le fichier
+   * entier), et les individus à parser */
+  file_chunks    *chunks;
+  gzindex_cursor range;
+  int    first_row, last_row, skip;
+  discrete_counts *dis_counts;
+
+  /* La partie du bloc en cours qui appartient au même total partiel */
+  int    from, to;
+
+  const char ***store_keys = (const char***) calloc
+    (struct_Ptr->vars_count + 1, sizeof(const char**));
+  double **store_nums = (double**) calloc (struct_Ptr->vars_count + 1,
+					   sizeof(double*));
+  unsigned int **store_ids = (unsigned int**) calloc
+    (struct_Ptr->vars_count + 1, sizeof(unsigned int*));
+  unsigned int *local_ids = (unsigned int*) malloc
+    (sizeof(unsigned int) * batch_size);
+
+  /* En pipeline: le flux qui reçoit les blocs décompressés */
+  stream source;
+  if (struct_Ptr->inflaters != NULL)
+    stream_init (&source, PIPELINE_DEPTH, READER_BLOCK);
+
+  /* Lecture anticipée: les 'readahead' prochaines tâches de la file
+   * au départ, puis celle qui entre dans cette fenêtre à chaque tâche */
+  task ahead;
+  int  distance = 0;
+
+  while (scheduler_next (struct_Ptr->tasks, struct_Ptr->worker_id,
+			 &current))
+    {
+      if (struct_Ptr->prefetch != NULL)
+	{
+	  for (; distance < struct_Ptr->readahead; ++distance)
+	    if (scheduler_ahead (struct_Ptr->tasks, struct_Ptr->worker_id,
+				 distance, &ahead))
+	      prefetch_task (struct_Ptr, &ahead);
+	  distance--;
+	}
 
-  char *pch, *dump_calc;
+      i    = current.iter;
+      name = struct_Ptr->scenarios_list[current.scen];
 
-  int return_check;
-  eval evaluator; /* Permet les calculs. */
+      /* Un fichier déjà parsé ne produit que les colonnes qui manquent
+       * au fichier binaire */
+      slots = struct_Ptr->cached_files[struct_Ptr->first_files
+				       [current.scen] + i] < 0
+	? struct_Ptr->full_slots : struct_Ptr->missing_slots;
 
-  /* Évite un avertissement de conversion dépréciée */
-  char true_s[] = "true";
-  char false_s[] = "false";
+      chunks = current.chunk < 0 ? NULL : struct_Ptr->chunked
+	[struct_Ptr->first_files[current.scen] + i];
 
-  char   *parsing;
-  gzFile p_file;
+      snprintf (file_path, BUFFER_SIZE, "%s%s/%d_Output.gz",
+		struct_Ptr->path, name, i);
 
-  for (i = struct_Ptr->lower_lim; i < struct_Ptr->upper_lim; ++i)
-    {
-      /* Ouvrir le fichier de la simulation à analyser */
-      sprintf (iter_buffer, "/%d_Output.gz", i);
-      strcpy (file_path + str_length, iter_buffer);
+      /* Le magasin de colonnes s'il est à jour, sinon le fichier texte */
+      snprintf (store_file, BUFFER_SIZE, "%s%s/%d_Output.col",
+		struct_Ptr->store_path, name, i);
 
-      p_file = gzopen (file_path, "rb");
+      stored = chunks == NULL
+	&& open_store (struct_Ptr, store_file,
+		       struct_Ptr->first_files[current.scen] + i, slots, &st,
+		       store_keys, store_nums, store_ids);
 
-      if (p_file == Z_NULL)
+      if (! stored)
 	{
-	  printf("Mauvais chemin ou fichier inexistant: %s\n", file_path);
-	  exit(1);
-	}
+	  snprintf (index_file, BUFFER_SIZE, "%s%s/%d_Output.idx",
+		    struct_Ptr->index_path, name, i);
+	  stamp    = struct_Ptr->stamps + struct_Ptr->first_files[current.scen]
+	    + i;
+	  /* Une tranche se lit à partir de l'index: il est à jour. Un
+	   * fichier décompressé d'un coup (--inflate=whole) n'en
+	   * construit pas: l'index suit une décompression par blocs. Un
+	   * membre d'archive non plus: il est lu d'un bout à l'autre. */
+	  indexing = chunks == NULL
+	    && struct_Ptr->whole_limit != INFLATE_ALWAYS
+	    && ! gzindex_current (index_file, stamp)
+	    && ! archive_find (file_path, NULL);
+
+	  /* Ouvrir le fichier de la simulation à analyser */
+	  if (struct_Ptr->inflaters != NULL)
+	    {
+	      if (chunks != NULL)
+		stream_reset_range (&source, file_path, &chunks->index,
+				    chunks->points[current.chunk],
+				    chunks->ends[current.chunk]);
+	      else
+		stream_reset (&source, file_path,
+			      indexing ? index_file : NULL, stamp);
+	      pipeline_submit (struct_Ptr->inflaters, &source);
+	      opened = reader_attach (&p_file, &source);
+	    }
+	  else if (chunks != NULL)
+	    opened = reader_open_range (&p_file, file_path, READER_BLOCK,
+					&range, &chunks->index,
+					chunks->points[current.chunk],
+					chunks->ends[current.chunk]);
+	  else if (indexing)
+	    opened = reader_open_index (&p_file, file_path, READER_BLOCK,
+					&index);
+	  else
+	    opened = reader_open (&p_file, file_path, READER_BLOCK,
+				  struct_Ptr->whole_limit);
+
+	  if (! opened)
+	    {
+	      printf("Mauvais chemin ou fichier inexistant: %s\n",
+		     file_path);
+	      exit(1);
+	    }
 
-      gzgets (p_file, line, BUFFER_SIZE);
+	  /* L'en-tête, ou les lignes entre le point où commence la lecture
+	   * d'une tranche et son premier individu (la ligne 0 est
+	   * l'en-tête: l'individu r est à la ligne r + 1) */
+	  skip = chunks == NULL ? 1 : chunks->rows[current.chunk] + 1
+	    - (int) chunks->index.points[chunks->points[current.chunk]].line;
 
-      /* Mettre à jour l'offset */
-      offset_acc  += struct_Ptr->acc_vars_count      ;
-      offset_bo   += struct_Ptr->bool_vars_count     ;
-      offset_dis  += struct_Ptr->discrete_vars_count ;
-      offset_loc  += struct_Ptr->total_loc_count     ;
-      offset_c_bo += struct_Ptr->c_bool_count        ;
+	  while (skip-- > 0 && reader_next (&p_file, &row_length) != NULL)
+	    ;
+	}
 
-      /* Parsing selon la population et la colonne (fichier CSV) */
-      for (v = 0; v < struct_Ptr->pop; ++v)
+      /* Le rang de l'itération dans les tenseurs de résultats */
+      file       = tensor_file (&struct_Ptr->acc_results, current.scen, i);
+      offset_dis = file * struct_Ptr->discrete_vars_count;
+
+      /* Les individus de la tranche, ou toute la population */
+      first_row = chunks != NULL ? chunks->rows[current.chunk] : 0;
+      last_row  = chunks != NULL ? chunks->rows[current.chunk + 1]
+	: struct_Ptr->pop;
+
+      /* Les comptes des variables discrètes: ceux de la tranche, du
+       * fichier en cours (--streaming) ou les résultats */
+      dis_counts = chunks != NULL ? chunks->counts + current.chunk
+	* struct_Ptr->discrete_vars_count
+	: struct_Ptr->stream != NULL ? file_counts
+	: struct_Ptr->discrete_results + offset_dis;
+
+      memset (acc_sums, 0, sizeof(double) * struct_Ptr->acc_vars_count);
+      memset (bool_sums, 0, sizeof(unsigned int)
+	      * struct_Ptr->bool_vars_count);
+      memset (loc_sums, 0, sizeof(double) * struct_Ptr->total_loc_count);
+      memset (c_bool_sums, 0, sizeof(unsigned int)
+	      * struct_Ptr->c_bool_count);
+      memset (acc_total, 0, sizeof(double) * struct_Ptr->acc_vars_count);
+      memset (loc_total, 0, sizeof(double) * struct_Ptr->total_loc_count);
+
+      /* Parsing selon la population, un bloc d'individus à la fois */
+      for (v = first_row; v < last_row; v += rows)
 	{
-	  gzgets(p_file, line, BUFFER_SIZE);
-	  strtok_r(line, ",", &dump);
+	  rows = last_row - v < batch_size ? last_row - v : batch_size;
 
-	  acc_vars_rank  = 0;
-	  bool_vars_rank = 0;
-	  dis_vars_rank  = 0;
+	  /* Lecture du bloc dans les colonnes (magasin de colonnes) */
+	  dis_vars_rank = 0;
 
-	  /* Les variables standards */
-	  for (k = 0; k < struct_Ptr->vars_count; ++k)
+	  for (k = 0; k < struct_Ptr->vars_count && stored; ++k)
 	    {
-	      parsing = strtok_r(NULL, ",", &dump);
+	      column = columns + k * batch_size;
+
+	      if (slots[k] && struct_Ptr->vars_types [k] != DISCRETE)
+		store_decode (&st, k, v, rows, store_nums[k], column, NULL);
+	      else if (slots[k])
+		{
+		  store_decode (&st, k, v, rows, store_nums[k], column,
+				local_ids);
+
+		  for (r = 0; r < rows; ++r)
+		    {
+		      id = store_ids[k][local_ids[r]];
+		      if (id == UINT_MAX)
+			{
+			  parsing = (char*) store_keys[k][local_ids[r]];
+			  id = store_ids[k][local_ids[r]] = dict_cache_lookup
+			    (dict_caches + dis_vars_rank, parsing,
+			     strlen (parsing), &num);
+			}
+		      ids[k * batch_size + r] = id;
+		    }
+		}
 
-	      if (parsing == NULL)
+	      dis_vars_rank += struct_Ptr->vars_types [k] == DISCRETE;
+	    }
+
+	  /* Lecture du bloc dans les colonnes (fichier CSV) */
+	  for (r = 0; r < rows && ! stored; ++r)
+	    {
+	      row = reader_next (&p_file, &row_length);
+	      if (row == NULL)
 		{
-		  printf("Inexistant! Fichier: %s, Ligne: %d, Var #: %d\n",
-			 file_path, v, k);
+		  printf("Inexistant! Fichier: %s, Ligne: %d\n", file_path,
+			 v + r);
 		  exit(1);
 		}
+	      strtok_r(row, ",", &dump);
+
+	      dis_vars_rank = 0;
 
-	      /* Enregistrer les résultats dans le tableau approprié
-	       * et la cache */
-	      switch ( struct_Ptr->vars_types [k] )
+	      for (k = 0; k < struct_Ptr->vars_count; ++k)
 		{
-		case BOOLEAN:
-		  if (! strncmp(parsing, "true", 4))
-		      ++struct_Ptr->bool_results[offset_bo+bool_vars_rank];
+		  parsing = strtok_r(NULL, ",", &dump);
 
-		  cache[k].string_value = parsing ;
-		  ++bool_vars_rank;
-		  break;
+		  if (parsing == NULL)
+		    {
+		      printf("Inexistant! Fichier: %s, Ligne: %d, Var #: %d\n",
+			     file_path, v + r, k);
+		      exit(1);
+		    }
 
-		case ACCUMUL:
-		  num_value = atof (parsing) ;
-		  struct_Ptr->acc_results [offset_acc + acc_vars_rank++]
-		    += num_value ;
-		  cache[k].num_value = num_value ;
-		  break;
+		  column = columns + k * batch_size;
 
-		case DISCRETE:
-		  value = string (parsing);
-		  if (value[value.size() - 1] == '\n')
-		    value[value.size() - 1] = NUL;
-		  ++struct_Ptr->discrete_results[offset_dis
-						 + dis_vars_rank++][value];
-		  cache[k].string_value = parsing ;
-		  break;
+		  /* Colonne inutile pour ce fichier */
+		  if (! slots[k])
+		    {
+		      dis_vars_rank += struct_Ptr->vars_types [k] == DISCRETE;
+		      continue;
+		    }
+
+		  switch ( struct_Ptr->vars_types [k] )
+		    {
+		    case BOOLEAN:
+		      column[r] = is_true (parsing);
+		      break;
+
+		    case ACCUMUL:
+		      column[r] = parse_number (parsing);
+		      break;
+
+		    case DISCRETE:
+		      ids[k * batch_size + r] = dict_cache_lookup
+			(dict_caches + dis_vars_rank++, parsing,
+			 strlen (parsing), column + r);
+		      break;
+		    }
 		}
 	    }
 
-	  /* Calculs locaux */
-	  for (k = 0; k < struct_Ptr->loc_count; ++k)
-	    {
-	      strcpy (tokenizer, struct_Ptr->loc_list[k]);
+	  /* Les totaux du bloc, une partie à la fois: un total partiel se
+	   * ferme tous les SUM_ROWS individus depuis le premier du fichier,
+	   * peu importe comment le fichier est lu (texte, tranches, magasin
+	   * de colonnes, archive) */
+	  for (from = 0; from < rows; from = to)
+	    {
+	      if ((v + from) % SUM_ROWS == 0 && v + from > first_row)
+		close_block (struct_Ptr, chunks, (v + from) / SUM_ROWS - 1,
+			     acc_sums, loc_sums, acc_total, loc_total);
+
+	      to = (v + from) / SUM_ROWS * SUM_ROWS + SUM_ROWS - v;
+	      if (to > rows)
+		to = rows;
+
+	    acc_vars_rank  = 0;
+	    bool_vars_rank = 0;
+	    dis_vars_rank  = 0;
+
+	    /* Les variables standards, une colonne à la fois */
+	    for (k = 0; k < struct_Ptr->vars_count; ++k)
+	      {
+		column = columns + k * batch_size;
+
+		/* Totaux déjà connus */
+		if (! (slots[k] & SLOT_PUBLISH))
+		  {
+		    acc_vars_rank  += struct_Ptr->vars_types [k] == ACCUMUL;
+		    bool_vars_rank += struct_Ptr->vars_types [k] == BOOLEAN;
+		    dis_vars_rank  += struct_Ptr->vars_types [k] == DISCRETE;
+		    continue;
+		  }
+
+		switch ( struct_Ptr->vars_types [k] )
+		  {
+		  case BOOLEAN:
+		    count = 0;
+#pragma omp simd reduction(+:count)
+		    for (r = from; r < to; ++r)
+		      count += (unsigned int) column[r];
+
+		    bool_sums[bool_vars_rank++] += count;
+		    break;
+
+		  case ACCUMUL:
+		    /* Pas de réassociation: même somme qu'avant */
+		    sum = acc_sums[acc_vars_rank];
+		    for (r = from; r < to; ++r)
+		      sum += column[r];
+
+		    acc_sums[acc_vars_rank++] = sum;
+		    break;
+
+		  case DISCRETE:
+		    counts = dis_counts + dis_vars_rank++;
+
+		    for (r = from; r < to; ++r)
+		      {
+			id = ids[k * batch_size + r];
+			if (id >= counts->size)
+			  grow_counts (counts, id);
+			++counts->counts[id];
+		      }
+		    break;
+		  }
+	      }
+
+	    /* Calculs locaux */
+	    for (k = 0; k < struct_Ptr->loc_count; ++k)
+	      {
+		if (! slots[struct_Ptr->vars_count + k])
+		  continue;
+
+		/* Colonnes des variables du calcul, dans l'ordre */
+		for (p = 0; p < struct_Ptr->loc_vars_count[k]; ++p)
+		  operands[p] = columns + struct_Ptr->loc_vars_ranks[k][p]
+		    * batch_size + from;
+
+		column = columns + (struct_Ptr->vars_count + k) * batch_size;
+
+		return_check = eval::execute_columns
+		  (struct_Ptr->loc_progs + k, operands, to - from,
+		   column + from, errors + from);
+
+		if (return_check == R_ERROR)
+		  {
+		    for (r = from; ! errors[r]; ++r)
+		      ;
+
+		    printf("Erreur de champ (range) dans les calculs locaux: \
+%s, scénario: %s, iteration %d, individu %d\n",
+			   struct_Ptr->loc_list[k], name, i, v + r);
+		    exit(1);
+		  }
+
+		sum = loc_sums[k];
+		for (r = from; r < to; ++r)
+		  sum += column[r];
+
+		loc_sums[k] = sum;
+	      }
+
+	    /* Expressions booléennes: chaque comparaison sur tout le bloc,
+	     * combinée de gauche à droite aux précédentes. */
+	    for (k = 0; k < struct_Ptr->c_bool_count; ++k)
+	      {
+		if (! slots[struct_Ptr->vars_count + struct_Ptr->loc_count
+			    + k])
+		  continue;
+
+		pred     = struct_Ptr->c_bool_preds[k];
+		end_pred = pred + struct_Ptr->c_bool_vars_count[k];
+
+		/* La première comparaison a le lien OR: 0 || x */
+		memset (state + from, 0, to - from);
+
+		for ( ; pred < end_pred; ++pred)
+		  test_predicate (pred, columns + pred->slot * batch_size
+				  + from, ids + pred->slot * batch_size
+				  + from, to - from, state + from);
+
+		column = columns + (struct_Ptr->vars_count
+				    + struct_Ptr->loc_count + k) * batch_size;
+		count  = 0;
+
+#pragma omp simd reduction(+:count)
+		for (r = from; r < to; ++r)
+		  {
+		    column[r] = state[r];
+		    count    += state[r];
+		  }
+
+		c_bool_sums[k] += count;
+	      }
+
+	    /* Calculs avec condition. (on ne peut pas les jumeler aux
+	     * calculs locaux parce qu'ils doivent suivre les expressions
+	     * booléennes) */
+	    for (k = struct_Ptr->loc_count; k < struct_Ptr->total_loc_count;
+		 ++k)
+	      {
+		if (! slots[struct_Ptr->vars_count + struct_Ptr->c_bool_count
+			    + k])
+		  continue;
+
+		for (p = 0; p < struct_Ptr->loc_vars_count[k]; ++p)
+		  operands[p] = columns + struct_Ptr->loc_vars_ranks[k][p]
+		    * batch_size + from;
+
+		cond   = columns + struct_Ptr->cond_vars_rank
+		  [k - struct_Ptr->loc_count] * batch_size;
+		column = columns + (struct_Ptr->vars_count
+				    + struct_Ptr->c_bool_count + k)
+		  * batch_size;
+
+		eval::execute_columns (struct_Ptr->loc_progs + k, operands,
+				       to - from, column + from,
+				       errors + from);
+
+		/* Seuls les individus qui respectent la condition comptent
+		 * (et peuvent causer une erreur); les autres valent 0. */
+		sum = loc_sums[k];
+		for (r = from; r < to; ++r)
+		  {
+		    if (! cond[r])
+		      {
+			column[r] = 0;
+			continue;
+		      }
+
+		    if (errors[r])
+		      {
+			printf("Erreur de champ (range) dans les calculs \
+conditionnels: %s, scénario: %s, iteration %d, individu %d\n",
+			       struct_Ptr->loc_list[k], name, i, v + r);
+			exit(1);
+		      }
+
+		    sum += column[r];
+		  }
+
+		loc_sums[k] = sum;
+	      }
+	    }
+	}
+
+      /* Le dernier bloc, puis les totaux du fichier entier */
+      if (last_row > first_row)
+	close_block (struct_Ptr, chunks, (last_row - 1) / SUM_ROWS, acc_sums,
+		     loc_sums, acc_total, loc_total);
+
+      if (chunks == NULL)
+	{
+	  memcpy (acc_sums, acc_total, sizeof(double)
+		  * struct_Ptr->acc_vars_count);
+	  memcpy (loc_sums, loc_total, sizeof(double)
+		  * struct_Ptr->total_loc_count);
+	}
+
+      if (stored)
+	store_close (&st);
+      else
+	{
+	  /* L'index couvre tout le fichier, même au-delà de la
+	   * population */
+	  if (p_file.index != NULL)
+	    {
+	      gzindex_save (p_file.index, index_file, stamp);
+	      gzindex_end (p_file.index);
+	    }
+	  reader_close (&p_file);
+	}
+
+      /* Une tranche: la dernière à terminer a les totaux du fichier */
+      if (chunks != NULL
+	  && ! merge_chunk (struct_Ptr, chunks, current.chunk, acc_sums,
+			    bool_sums, loc_sums, c_bool_sums,
+			    struct_Ptr->stream != NULL ? file_counts
+			    : struct_Ptr->discrete_results + offset_dis))
+	{
+	  scheduler_done (struct_Ptr->tasks, current.scen);
+	  continue;
+	}
+
+      /* Mode --streaming: les totaux du fichier vont aux accumulateurs
+       * du thread. Sinon, les publier une seule fois (les colonnes
+       * reprises du fichier binaire sont déjà en place) */
+      if (struct_Ptr->stream != NULL)
+	stream_file (struct_Ptr, current.scen, i, acc_sums, bool_sums,
+		     loc_sums, c_bool_sums, file_counts);
+      else
+	{
+	  acc_vars_rank  = 0;
+	  bool_vars_rank = 0;
+	  for (k = 0; k < struct_Ptr->vars_count; ++k)
+	    {
+	      if (struct_Ptr->vars_types [k] == ACCUMUL)
+		{
+		  if (slots[k] & SLOT_PUBLISH)
+		    tensor_f64 (&struct_Ptr->acc_results, file)
+		      [acc_vars_rank] = acc_sums[acc_vars_rank];
+		  acc_vars_rank++;
+		}
+	      else if (struct_Ptr->vars_types [k] == BOOLEAN)
+		{
+		  if (slots[k] & SLOT_PUBLISH)
+		    tensor_u32 (&struct_Ptr->bool_results, file)
+		      [bool_vars_rank] = bool_sums[bool_vars_rank];
+		  bool_vars_rank++;
+		}
+	    }
+
+	  for (k = 0; k < struct_Ptr->total_loc_count; ++k)
+	    if (slots[struct_Ptr->vars_count + k
+		      + (k < struct_Ptr->loc_count ? 0
+			 : struct_Ptr->c_bool_count)] & SLOT_PUBLISH)
+	      tensor_f64 (&struct_Ptr->loc_results, file)[k] = loc_sums[k];
+
+	  for (k = 0; k < struct_Ptr->c_bool_count; ++k)
+	    if (slots[struct_Ptr->vars_count + struct_Ptr->loc_count + k]
+		& SLOT_PUBLISH)
+	      tensor_u32 (&struct_Ptr->c_bool_results, file)[k]
+		= c_bool_sums[k];
+	}
+
+      /* Pour pouvoir afficher une progression */
+      struct_Ptr->progress[struct_Ptr->worker_id].files
+	.fetch_add (1, std::memory_order_relaxed);
+
+      scheduler_done (struct_Ptr->tasks, current.scen);
+    }
+  if (struct_Ptr->inflaters != NULL)
+    stream_free (&source);
+
+  free (acc_sums);
+  free (bool_sums);
+  free (loc_sums);
+  free (c_bool_sums);
+  free (acc_total);
+  free (loc_total);
+
+  free (columns);
+  free (ids);
+  free (state);
+  free (errors);
+  free (operands);
+
+  for (k = 0; k < struct_Ptr->discrete_vars_count; ++k)
+    {
+      dict_cache_free (dict_caches + k);
+      free (file_counts[k].counts);
+    }
+  free (dict_caches);
+  free (file_counts);
+
+  for (k = 0; k < struct_Ptr->vars_count; ++k)
+    {
+      free (store_keys[k]);
+      free (store_nums[k]);
+      free (store_ids[k]);
+    }
+  free (store_keys);
+  free (store_nums);
+  free (store_ids);
+  free (local_ids);
+
+  return NULL;
+}
+
+/*
+ * Mode --streaming: ajoute les totaux d'un fichier (itération 'iter' du
+ * scénario 'scen') aux accumulateurs du thread, et évalue les calculs
+ * globaux sur cette seule itération. Les comptes des variables discrètes
+ * sont remis à zéro pour le fichier suivant.
+ */
+void stream_file (const thread_args *args, int scen, int iter,
+		  const double *acc_sums, const unsigned int *bool_sums,
+		  const double *loc_sums, const unsigned int *c_bool_sums,
+		  discrete_counts *counts)
+{
+  stream_part *part = args->stream;
+  int columns = args->acc_vars_count + args->bool_vars_count
+    + args->total_loc_count + args->c_bool_count + args->calcs_count;
+  welford *stats = part->stats + scen * columns;
+  int k, p, rank, *first_error;
+  unsigned int id;
+  discrete_stats *dstats;
+
+  for (k = 0; k < args->acc_vars_count; ++k)
+    welford_add (stats++, acc_sums[k]);
+  for (k = 0; k < args->bool_vars_count; ++k)
+    welford_add (stats++, bool_sums[k]);
+  for (k = 0; k < args->total_loc_count; ++k)
+    welford_add (stats++, loc_sums[k]);
+  for (k = 0; k < args->c_bool_count; ++k)
+    welford_add (stats++, c_bool_sums[k]);
+
+  /* Variables discrètes: les comptes non nuls seulement */
+  for (k = 0; k < args->discrete_vars_count; ++k)
+    {
+      dstats = part->discrete + scen * args->discrete_vars_count + k;
+
+      for (id = 0; id < counts[k].size; ++id)
+	{
+	  if (! counts[k].counts[id])
+	    continue;
+
+	  if (id >= dstats->size)
+	    grow_stats (dstats, id);
+	  welford_add (dstats->stats + id, counts[k].counts[id]);
+	  counts[k].counts[id] = 0;
+	}
+    }
+
+  if (! args->calcs_count)
+    return;
+
+  /* Calculs globaux: une colonne d'une seule valeur par variable */
+  int max_vars = 1;
+  for (k = 0; k < args->calcs_count; ++k)
+    if (args->calcs_progs[k].vars_count > max_vars)
+      max_vars = args->calcs_progs[k].vars_count;
+
+  double *values = (double*) malloc (sizeof(double) * args->calcs_count);
+  double *inputs = (double*) malloc (sizeof(double) * max_vars);
+  const double **operands = (const double**) malloc (sizeof(double*)
+						     * max_vars);
+  char error;
+
+  for (k = 0; k < args->calcs_count; ++k)
+    {
+      values[k] = 0;
+      if (! args->calcs_progs[k].vars_count)
+	continue;
+
+      for (p = 0; p < args->calcs_progs[k].vars_count; ++p)
+	{
+	  rank = args->calcs_relative_ranks[k][p];
+
+	  switch (args->calcs_vars_types[k][p])
+	    {
+	    case BOOLEAN:
+	      inputs[p]   = bool_sums[rank];
+	      operands[p] = inputs + p;
+	      break;
+
+	    case ACCUMUL:
+	      operands[p] = acc_sums + rank;
+	      break;
+
+	    case CUSTOM_BOOLEAN:
+	      inputs[p]   = c_bool_sums[rank];
+	      operands[p] = inputs + p;
+	      break;
+
+	    case LOC_CALC:
+	      operands[p] = loc_sums + rank;
+	      break;
+
+	    case GLOB_CALC:
+	      operands[p] = values + rank;
+	      break;
+	    }
+	}
+
+      if (eval::execute_columns (args->calcs_progs + k, operands, 1,
+				 values + k, &error) == R_ERROR)
+	{
+	  first_error = part->calcs_errors + scen * args->calcs_count + k;
+	  if (*first_error < 0 || iter < *first_error)
+	    *first_error = iter;
+	}
+
+      welford_add (stats + k, values[k]);
+    }
 
-	      if (tokenizer[0] != "\""[0])
-		{
-		  pch = strtok_r (tokenizer, "\"", &dump_calc);
-		  strcpy (buffer, pch);
-		  pch = strtok_r (NULL, "\"", &dump_calc);
-		}
-	      else
-		{
-		  strcpy (buffer, "");
-		  pch = strtok_r(tokenizer, "\"", &dump_calc);
-		  pch++;
-		}
+  free (values);
+  free (inputs);
+  free (operands);
+}
 
-	      if (struct_Ptr->vars_types[struct_Ptr->loc_vars_ranks[k][0]]
-		  == DISCRETE)
-		cache[struct_Ptr->loc_vars_ranks[k][0]].num_value
-		  = atof(cache
-			 [struct_Ptr->loc_vars_ranks[k][0]].string_value);
+/*
+ * Projette le magasin de colonnes 'path' du fichier 'file' s'il peut
+ * remplacer le fichier texte: assez d'individus, et pour chaque colonne
+ * utile un encodage qui convient au type de la variable (une variable
+ * discrète doit avoir son dictionnaire). Prépare alors la valeur de
+ * chaque entrée des dictionnaires utiles; son identifiant ne sera cherché
+ * qu'à sa première rencontre, comme lors de la lecture du texte.
+ */
+int open_store (const thread_args *args, const char *path, int file,
+		const unsigned char *slots, store *st, const char ***keys,
+		double **nums, unsigned int **ids_map)
+{
+  unsigned int i, count;
+  int k, ok;
 
-	      sprintf (buffer, "%s%f", buffer,
-		       cache[struct_Ptr->loc_vars_ranks[k][0]].num_value);
+  if (! store_open (st, path, args->stamps + file, args->vars_count,
+		    slots))
+    return 0;
 
-	      for (p = 1; p < struct_Ptr->loc_vars_count[k]; ++p)
-		{
-		  pch = strtok_r (NULL, "\"", &dump_calc);
-		  strcat (buffer, pch);
-		  pch = strtok_r (NULL, "\"", &dump_calc);
+  ok = st->header->rows >= (uint32_t) args->pop;
 
-		  sprintf (buffer, "%s%f", buffer,
-			   cache[struct_Ptr->loc_vars_ranks[k][p]]
-			   .num_value);
-		}
+  for (k = 0; k < args->vars_count && ok; ++k)
+    {
+      if (! slots[k])
+	continue;
 
-	      pch = strtok_r (NULL, "\"", &dump_calc);
+      switch ( args->vars_types [k] )
+	{
+	case BOOLEAN:
+	  ok = st->columns[k].encoding == STORE_BITS;
+	  break;
 
-	      if (pch != NULL)
-		strcat(buffer, pch);
+	case ACCUMUL:
+	  ok = st->columns[k].encoding != STORE_BITS;
+	  break;
 
-	      /* appel d'un équivalent C du 'eval' pythonesqe */
-	      return_check = evaluator.evaluate (buffer, &num_value);
+	case DISCRETE:
+	  ok = store_is_dict (st, k);
+	  break;
+	}
 
-	      if (return_check == -2)
-		{
-		  printf("Erreur de champ (range) dans les calculs locaux: \
-%s, calcul: %s, scénario: %s, iteration %d\n",
-			 struct_Ptr->loc_list[k], buffer,
-			 struct_Ptr->name, i);
-		  exit(1);
-		}
+      if (! ok || ! store_is_dict (st, k))
+	continue;
 
-	      cache [struct_Ptr->vars_count + k].num_value = num_value;
-	      struct_Ptr->loc_results [offset_loc + k] += num_value ;
-	    }
+      count      = st->columns[k].keys_count;
+      keys[k]    = (const char**) realloc (keys[k], sizeof(const char*)
+					   * (count + 1));
+      nums[k]    = (double*) realloc (nums[k], sizeof(double)
+					* (count + 1));
+      ids_map[k] = (unsigned int*) realloc (ids_map[k],
+					    sizeof(unsigned int)
+					    * (count + 1));
+
+      store_keys (st, k, keys[k]);
+      for (i = 0; i < count; ++i)
+	{
+	  nums[k][i]    = parse_number (keys[k][i]);
+	  ids_map[k][i] = UINT_MAX;
+	}
+    }
 
-	  /* Expressions booléennes */
-	  for (k = 0; k < struct_Ptr->c_bool_count; ++k)
-	    {
-	      for (p = 0; p < struct_Ptr->c_bool_vars_count[k]; ++p)
-		{
-		  previous_c_bool_state = current_c_bool_state;
+  if (! ok)
+    store_close (st);
+  return ok;
+}
 
-		  /* Traiter l'opérateur rencontré */
-		  switch (struct_Ptr->comp_op_list[k][p])
-		    {
-		    case EQ:
-		      if ((struct_Ptr->c_bool_vars_ranks[k][p]
-			   >= struct_Ptr->vars_count
-			   && struct_Ptr->c_bool_vars_ranks[k][p]
-			   < struct_Ptr->vars_count + struct_Ptr->loc_count)
-			  || struct_Ptr->vars_types
-			  [struct_Ptr->c_bool_vars_ranks[k][p]] == ACCUMUL)
-			{
-			  if ( cache[struct_Ptr->c_bool_vars_ranks[k][p]]
-			       .num_value == atof
-			       (struct_Ptr->data_comp_list[k][p]) )
-			    current_c_bool_state = 1;
-			  else
-			    current_c_bool_state = 0;
-			}
-		      else
-			{
-			  if (! strcmp (cache [struct_Ptr->
-					       c_bool_vars_ranks[k][p]]
-					.string_value, struct_Ptr->
-					data_comp_list[k][p]))
-			    current_c_bool_state = 1;
-			  else
-			    current_c_bool_state = 0;
-			}
-		      break;
+/*
+ * Transcode en magasins de colonnes (store.h) tous les fichiers dont le
+ * magasin n'est pas à jour, sur 'max_threads' threads. Un fichier qui ne
+ * peut être transcodé est simplement laissé en texte.
+ */
+void transcode_files (char **scenarios_list, int scenarios_count,
+		      const int *first_files, char *path, char *store_path,
+		      const cache_stamp *stamps, const int *vars_types,
+		      int vars_count, int max_threads, size_t whole_limit)
+{
+  char task_path [BUFFER_SIZE];
+  store st;
+  int i, v, t = 0;
 
-		    case NE:
-		      if ((struct_Ptr->c_bool_vars_ranks[k][p]
-			   >= struct_Ptr->vars_count
-			   && struct_Ptr->c_bool_vars_ranks[k][p]
-			   < struct_Ptr->vars_count + struct_Ptr->loc_count)
-			  || struct_Ptr->vars_types
-			  [struct_Ptr->c_bool_vars_ranks[k][p]] == ACCUMUL)
-			{
-			  if (cache [struct_Ptr->c_bool_vars_ranks[k][p]]
-			      .num_value != atof
-			      (struct_Ptr->data_comp_list[k][p]))
-			    current_c_bool_state = 1;
-			  else
-			    current_c_bool_state = 0;
-			}
-		      else
-			{
-			  if (strcmp (cache [struct_Ptr->c_bool_vars_ranks
-					     [k][p]].string_value,
-				      struct_Ptr->data_comp_list[k][p]))
-			    current_c_bool_state = 1;
-			  else
-			    current_c_bool_state = 0;
-			}
-		      break;
+  unsigned char *bits = (unsigned char*) malloc (vars_count);
+  for (v = 0; v < vars_count; ++v)
+    bits[v] = vars_types[v] == BOOLEAN;
 
-		    case GT:
-		      if (struct_Ptr->vars_types
-			  [struct_Ptr->c_bool_vars_ranks[k][p]]
-			  == DISCRETE)
-			{
-			  if (atof(cache[struct_Ptr->c_bool_vars_ranks
-					 [k][p]].string_value)
-			      > atof(struct_Ptr->data_comp_list[k][p]))
-			    current_c_bool_state = 1;
-			  else
-			    current_c_bool_state = 0;
-			}
-		      else
-			{
-			  if (cache [struct_Ptr->c_bool_vars_ranks[k][p]]
-			      .num_value > atof
-			      (struct_Ptr->data_comp_list[k][p]))
-			    current_c_bool_state = 1;
-			  else
-			    current_c_bool_state = 0;
-			}
-		      break;
+  mkdir (store_path, 0755);
 
-		    case GE:
-		      if (struct_Ptr->vars_types
-			  [struct_Ptr->c_bool_vars_ranks[k][p]] == DISCRETE)
-			{
-			  if (atof(cache [struct_Ptr->c_bool_vars_ranks
-					  [k][p]].string_value)
-			      >= atof(struct_Ptr->data_comp_list[k][p]))
-			    current_c_bool_state = 1;
-			  else
-			    current_c_bool_state = 0;
-			}
-		      else
-			{
-			  if (cache [struct_Ptr->c_bool_vars_ranks[k][p]]
-			      .num_value >= atof(struct_Ptr->data_comp_list
-						 [k][p]))
-			    current_c_bool_state = 1;
-			  else
-			    current_c_bool_state = 0;
-			}
-		      break;
+  task *tasks = (task*) malloc (sizeof(task)
+				* first_files[scenarios_count]);
 
-		    case LT:
-		      if (struct_Ptr->vars_types
-			  [struct_Ptr->c_bool_vars_ranks[k][p]] == DISCRETE)
-			{
-			  if (atof(cache [struct_Ptr->c_bool_vars_ranks
-					  [k][p]].string_value)
-			      < atof(struct_Ptr->data_comp_list[k][p]))
-			    current_c_bool_state = 1;
-			  else
-			    current_c_bool_state = 0;
-			}
-		      else
-			{
-			  if (cache [struct_Ptr->c_bool_vars_ranks[k][p]]
-			      .num_value < atof
-			      (struct_Ptr->data_comp_list[k][p]))
-			    current_c_bool_state = 1;
-			  else
-			    current_c_bool_state = 0;
-			}
-		      break;
+  for (i = 0; i < scenarios_count; ++i)
+    {
+      snprintf (task_path, BUFFER_SIZE, "%s%s", store_path,
+		scenarios_list[i]);
+      mkdir (task_path, 0755);
 
-		    case LE:
-		      if (struct_Ptr->vars_types
-			  [struct_Ptr->c_bool_vars_ranks[k][p]] == DISCRETE)
-			{
-			  if (atof(cache [struct_Ptr->c_bool_vars_ranks
-					  [k][p]].string_value)
-			      <= atof(struct_Ptr->data_comp_list[k][p]))
-			    current_c_bool_state = 1;
-			  else
-			    current_c_bool_state = 0;
-			}
-		      else
-			{
-			  if (cache [struct_Ptr->c_bool_vars_ranks[k][p]]
-			      .num_value <= atof
-			      (struct_Ptr->data_comp_list[k][p]))
-			    current_c_bool_state = 1;
-			  else
-			    current_c_bool_state = 0;
-			}
-		      break;
-		    }
-		  /* Vérifie si l'on est rendu à un délimiteur de type
-		     && ou || */
-		  if (p & 1)
-		    {
-		      /* Mettre à jour la valeur actuelle en prenant en
-		       * en compte la valeur actuelle et précédente */
-		      switch (struct_Ptr->bool_op_list[k][p >> 1])
-			{
-			case AND:
-			  if (previous_c_bool_state && current_c_bool_state)
-			    current_c_bool_state = 1;
-			  else
-			    current_c_bool_state = 0;
-			  break;
+      for (v = 0; v < first_files[i + 1] - first_files[i]; ++v)
+	{
+	  snprintf (task_path, BUFFER_SIZE, "%s%s/%d_Output.col",
+		    store_path, scenarios_list[i], v);
 
-			case OR:
-			  if (previous_c_bool_state || current_c_bool_state)
-			    current_c_bool_state = 1;
-			  else
-			    current_c_bool_state = 0;
-			  break;
-			}
-		    }
-		}
-	      if (current_c_bool_state)
-		{
-		  ++struct_Ptr->c_bool_results [offset_c_bo + k] ;
-		  cache[struct_Ptr->vars_count+struct_Ptr->loc_count+k]
-		    .string_value = true_s;
-		}
-	      else
-		cache[struct_Ptr->vars_count+struct_Ptr->loc_count+k]
-		  .string_value = false_s;
+	  /* Déjà à jour et intact */
+	  if (store_open (&st, task_path, stamps + first_files[i] + v,
+			  vars_count, NULL))
+	    {
+	      store_close (&st);
+	      continue;
 	    }
 
-	  /* Calculs avec condition */
-	  for (k = struct_Ptr->loc_count; k < struct_Ptr->total_loc_count;
-	       ++k)
-	    {
-	      if ( strncmp(cache[struct_Ptr->cond_vars_rank
-				[k - struct_Ptr->loc_count]]
-			   .string_value, "true", 4) )
-		{
-		  /* La condition est fausse: rien à faire sauf mettre la
-		   * cache à jour. */
-		  cache [struct_Ptr->vars_count + struct_Ptr->c_bool_count
-			 + k].num_value = 0;
-		}
+	  tasks[t].scen  = i;
+	  tasks[t].iter  = v;
+	  tasks[t].chunk = -1;
+	  tasks[t].size  = stamps[first_files[i] + v].size;
+	  tasks[t].inode = stamps[first_files[i] + v].inode;
+	  t++;
+	}
+    }
 
-	      /* Simple copier coller des calculs locaux. (on ne peut pas
-	       * les jumeler parce que ceux avec conditions doivent suivre
-	       * les expressions booléennes)
-	       */
-	      else
-		{
-		  strcpy (tokenizer, struct_Ptr->loc_list[k]);
+  if (t)
+    {
+      int workers_count = max_threads < 1 ? 1 : max_threads;
+      if (workers_count > t)
+	workers_count = t;
 
-		  if (tokenizer[0] != "\""[0])
-		    {
-		      pch = strtok_r (tokenizer, "\"", &dump_calc);
-		      strcpy (buffer, pch);
-		      pch = strtok_r (NULL, "\"", &dump_calc);
-		    }
-		  else
-		    {
-		      strcpy (buffer, "");
-		      pch = strtok_r(tokenizer, "\"", &dump_calc);
-		      pch++;
-		    }
+      scheduler transcode_tasks;
+      scheduler_init (&transcode_tasks, workers_count, tasks, t,
+		      scenarios_count, SCHEDULE_SIZE);
+
+      pthread_t *threads_array = (pthread_t*) malloc
+	(sizeof(pthread_t) * workers_count);
+      transcode_args *list_args = (transcode_args*) malloc
+	(sizeof(transcode_args) * workers_count);
 
-		  if (struct_Ptr->vars_types[struct_Ptr->loc_vars_ranks
-					     [k][0]]
-		      == DISCRETE)
-		    cache[struct_Ptr->loc_vars_ranks[k][0]].num_value
-		      = atof(cache
-			     [struct_Ptr->loc_vars_ranks[k][0]]
-			     .string_value);
+      for (v = 0; v < workers_count; ++v)
+	{
+	  list_args[v].scenarios_list = scenarios_list;
+	  list_args[v].path           = path;
+	  list_args[v].store_path     = store_path;
+	  list_args[v].stamps         = stamps;
+	  list_args[v].bits           = bits;
+	  list_args[v].vars_count     = vars_count;
+	  list_args[v].first_files    = first_files;
+	  list_args[v].tasks          = &transcode_tasks;
+	  list_args[v].worker_id      = v;
+	  list_args[v].whole_limit    = whole_limit;
+
+	  pthread_create (threads_array+v, NULL, transcode_worker,
+			  (void*) (list_args+v));
+	}
 
-		  sprintf (buffer, "%s%f", buffer,
-			   cache[struct_Ptr->loc_vars_ranks[k][0]]
-			   .num_value);
+      for (v = 0; v < workers_count; ++v)
+	pthread_join (threads_array[v], NULL);
 
-		  for (p = 1; p < struct_Ptr->loc_vars_count[k]; ++p)
-		    {
-		      pch = strtok_r (NULL, "\"", &dump_calc);
-		      strcat (buffer, pch);
-		      pch = strtok_r (NULL, "\"", &dump_calc);
+      free (threads_array);
+      free (list_args);
+      scheduler_free (&transcode_tasks);
+    }
 
-		      sprintf (buffer, "%s%f", buffer,
-			       cache[struct_Ptr->loc_vars_ranks[k][p]]
-			       .num_value);
-		    }
+  free (tasks);
+  free (bits);
+}
 
-		  pch = strtok_r (NULL, "\"", &dump_calc);
+void * transcode_worker (void *ptr)
+{
+  transcode_args *args = (transcode_args *) ptr;
 
-		  if (pch != NULL)
-		    strcat(buffer, pch);
+  char source [BUFFER_SIZE];
+  char target [BUFFER_SIZE];
+  task current;
 
-		  /* appel d'un équivalent C du 'eval' pythonesqe */
-		  return_check = evaluator.evaluate (buffer, &num_value);
+  while (scheduler_next (args->tasks, args->worker_id, &current))
+    {
+      snprintf (source, BUFFER_SIZE, "%s%s/%d_Output.gz", args->path,
+		args->scenarios_list[current.scen], current.iter);
+      snprintf (target, BUFFER_SIZE, "%s%s/%d_Output.col",
+		args->store_path, args->scenarios_list[current.scen],
+		current.iter);
+
+      /* Le fichier restera lu en texte */
+      if (! store_transcode (source, target, args->stamps
+			     + args->first_files[current.scen]
+			     + current.iter, args->bits, args->vars_count,
+			     args->whole_limit))
+	printf("Incapable de transcoder le fichier: %s\n", source);
+
+      scheduler_done (args->tasks, current.scen);
+    }
 
-		  if (return_check == -2)
-		    {
-		      printf("Erreur de champ (range) dans les calculs \
-locaux: %s, calcul: %s, scénario: %s, iteration %d\n",
-			     struct_Ptr->loc_list[k], buffer,
-			     struct_Ptr->name, i);
-		      exit(1);
-		    }
+  return NULL;
+}
 
-		  cache [struct_Ptr->vars_count + struct_Ptr->c_bool_count
-			 + k].num_value = num_value;
-		  struct_Ptr->loc_results [offset_loc + k] += num_value ;
-		}
-	    }
-	}
-      gzclose (p_file);
+/*
+ * Alloue un tableau aligné sur une ligne de cache, dont la taille est
+ * arrondie à un nombre entier de lignes: il ne partage aucune ligne avec
+ * les données d'un autre thread. (à libérer avec free)
+ */
+void *cache_aligned_alloc (size_t size)
+{
+  void *ptr;
 
-      /* Pour pouvoir afficher une progression */
-      struct_Ptr->progress[struct_Ptr->progress_id]++;
+  size = (size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+  if (posix_memalign (&ptr, CACHE_LINE, size ? size : CACHE_LINE))
+    {
+      puts("Mémoire insuffisante.");
+      exit(1);
     }
-  free (cache);
-
-  /* On utilise un pointeur de type void (seul retour possible d'une
-   * fonction passée à un thread) pour contenir et retourner un int.
-   * Conversion intermédiare pour éviter un avertissement du compilateur.
-   */
-  return (void *) CONVERSION struct_Ptr->num_scen ;
+  return ptr;
 }
 
 /*
@@ -2881,7 +4973,8 @@ void * display_progress (void *ptr)
       /* Aucune pénalité en performance à simplement faire du polling */
       nanosleep (&wait_time, NULL);
       for (int i = 0; i < current_Prog->threads_count; i++)
-	percent_progress += current_Prog->progress [i];
+	percent_progress += current_Prog->progress [i].files
+	  .load (std::memory_order_relaxed);
 
       percent_progress *= 100. / current_Prog->total_iters;
 
@@ -2898,151 +4991,223 @@ void * display_progress (void *ptr)
  */
 void print_results (print_func_args *args)
 {
-  /* Les différents offsets dûs au scénario en cours */
-  int offset_acc  = args->num_scen * args->iters_count
-    * args->acc_vars_count;
-  int offset_bo   = args->num_scen * args->iters_count
-    * args->bool_vars_count;
-  int offset_dis  = args->num_scen * args->iters_count
-    * args->discrete_vars_count;
-  int offset_loc  = args->num_scen * args->iters_count
-    * args->total_loc_count;
-  int offset_c_bo = args->num_scen * args->iters_count * args->c_bool_count;
+  FILE *out = args->out;
+
+  /* Le premier fichier du scénario en cours */
+  int first_file  = tensor_file (&args->acc_results, args->num_scen, 0);
+  int offset_dis  = first_file * args->discrete_vars_count;
   int icr_off     = args->num_scen * args->ICR_vars_count;
 
-  puts("---------------------------------------");
-  printf("Nom du scénario: %s\n", args->name);
-  printf("Population: %d\n", args->pop);
-  printf("Nombre d'itérations: %d\n", args->iters_count);
-  puts("---------------------------------------\n");
-  puts("Variables standards:");
-  puts("-----------------------------\n");
-  puts("Désignation,Type,Valeur,Relatif (% ou par individu),Ecart type,\
-IC (±)");
-
-  double mean, std, sum;
+  fputs("---------------------------------------\n", out);
+  fprintf(out, "Nom du scénario: %s\n", args->name);
+  fprintf(out, "Population: %d\n", args->pop);
+  fprintf(out, "Nombre d'itérations: %d\n", args->iters_count);
+  fputs("---------------------------------------\n\n", out);
+  fputs("Variables standards:\n", out);
+  fputs("-----------------------------\n\n", out);
+  fputs("Désignation,Type,Valeur,Relatif (% ou par individu),Ecart type,\
+IC (±)\n", out);
+
+  double mean, std;
   int i, v, p;
 
-  set <string> keys;
-  set <string>::iterator key_it;
-  unordered_map <string, unsigned int>::iterator it;
+  const char      **keys;
+  unsigned int    *order, keys_count, id;
+  discrete_counts *counts, *dc;
 
   int acc_vars_rank  = 0;
   int bool_vars_rank = 0;
   int dis_vars_rank  = 0;
 
-  /* Moyenne + écart type + sauvegarder valeur si dans les ICRs */
-  for (i = 0; i < args->vars_count; ++i)
+  /* Mode --streaming: les accumulateurs des threads, fusionnés pour ce
+   * scénario (même ordre de colonnes que stream_part) */
+  welford *stats = NULL, *calcs_stats = NULL, w;
+  int     *calcs_errors = NULL;
+  discrete_stats *dstats = NULL, *part_dstats;
+
+  if (args->stream_parts != NULL)
     {
-      /* Les variables standards */
-      switch (args->vars_types[i])
+      int columns = args->acc_vars_count + args->bool_vars_count
+	+ args->total_loc_count + args->c_bool_count + args->calcs_count;
+
+      stats = (welford*) calloc (columns + 1, sizeof(welford));
+      calcs_stats = stats + columns - args->calcs_count;
+      dstats = (discrete_stats*) calloc (args->discrete_vars_count + 1,
+					 sizeof(discrete_stats));
+      calcs_errors = (int*) malloc (sizeof(int)
+				    * (args->calcs_count + 1));
+      for (i = 0; i < args->calcs_count; ++i)
+	calcs_errors[i] = -1;
+
+      for (p = 0; p < args->parts_count; ++p)
 	{
-	case BOOLEAN:
-	  /* Pas de sous-routines parce que trop de paramètres à passer */
-	  sum = 0;
-	  for (v = 0; v < args->iters_count; ++v)
+	  const stream_part *part = args->stream_parts + p;
+
+	  for (i = 0; i < columns; ++i)
+	    welford_merge (stats + i, part->stats + args->num_scen * columns
+			   + i);
+
+	  for (i = 0; i < args->discrete_vars_count; ++i)
 	    {
-	      sum += args->bool_results [offset_bo +
-					 (args->bool_vars_count * v)
-					 + bool_vars_rank] ;
+	      part_dstats = part->discrete + args->num_scen
+		* args->discrete_vars_count + i;
+
+	      if (part_dstats->size > dstats[i].size)
+		grow_stats (dstats + i, part_dstats->size - 1);
+	      for (id = 0; id < part_dstats->size; ++id)
+		welford_merge (dstats[i].stats + id, part_dstats->stats + id);
 	    }
-	  mean = sum / args->iters_count;
 
-	  sum = 0;
-	  for (v = 0; v < args->iters_count; ++v)
+	  for (i = 0; i < args->calcs_count; ++i)
 	    {
-	      sum += pow (args->bool_results [offset_bo +
-					      (args->bool_vars_count * v) +
-					      bool_vars_rank] - mean, 2);
+	      v = part->calcs_errors[args->num_scen * args->calcs_count + i];
+	      if (v >= 0 && (calcs_errors[i] < 0 || v < calcs_errors[i]))
+		calcs_errors[i] = v;
 	    }
-	  std = sqrt (sum / (args->iters_count-1));
+	}
+    }
+
+  /* Moyennes et écarts types de toutes les colonnes du scénario, dans
+   * l'ordre acc, bool, loc, c_bool */
+  const tensor *tensors[] = {&args->acc_results, &args->bool_results,
+			     &args->loc_results, &args->c_bool_results};
+  int    bool_off   = args->acc_vars_count;
+  int    loc_off    = bool_off + args->bool_vars_count;
+  int    c_bool_off = loc_off + args->total_loc_count;
+  int    columns    = c_bool_off + args->c_bool_count;
+  double *means = (double*) malloc (sizeof(double) * (columns + 1));
+  double *stds  = (double*) malloc (sizeof(double) * (columns + 1));
+
+  if (stats != NULL)
+    for (i = 0; i < columns; ++i)
+      welford_result (stats + i, means + i, stds + i);
+  else
+    for (i = 0, p = 0; i < 4; p += tensors[i]->columns_count, ++i)
+      tensor_stats (tensors[i], args->num_scen, means + p, stds + p);
+
+  /* Moyenne + écart type + sauvegarder valeur si dans les ICRs */
+  for (i = 0; i < args->vars_count; ++i)
+    {
+      /* Les variables standards */
+      switch (args->vars_types[i])
+	{
+	case BOOLEAN:
+	  mean = means[bool_off + bool_vars_rank];
+	  std  = stds [bool_off + bool_vars_rank];
 
 	  if (! args->no_show [i] )
 	    {
-	      printf("%s,Booléenne,%.8G,%.8G %%,%.8G,%.8G\n",
-		     args->vars_list[i], mean, (mean / args->pop) * 100,
-		     std,  get_CI (std, args->iters_count));
+	      fprintf(out, "%s,Booléenne,%.8G,%.8G %%,%.8G,%.8G\n",
+			   args->vars_list[i], mean, (mean / args->pop) * 100,
+			   std,  get_CI (std, args->iters_count));
 	    }
 
 	  ++bool_vars_rank;
 	  break;
 
 	case ACCUMUL:
-	  sum = 0;
-	  for (v = 0; v < args->iters_count; ++v)
-	    {
-	      sum += args->acc_results [offset_acc + (args->acc_vars_count
-						      * v) + acc_vars_rank];
-	    }
-	  mean = sum / args->iters_count;
-
-	  sum = 0;
-	  for (v = 0; v < args->iters_count; ++v)
-	    {
-	      sum += pow (args->acc_results [offset_acc +
-					     (args->acc_vars_count * v) +
-					     acc_vars_rank] - mean, 2);
-	    }
-	  std = sqrt (sum / (args->iters_count-1));
+	  mean = means[acc_vars_rank];
+	  std  = stds [acc_vars_rank];
 
 	  if (! args->no_show [i] )
 	    {
-	      printf("%s,Accumulatrice,%.8G,%.8G,%.8G,%.8G\n",
-		     args->vars_list[i], mean, mean / args->pop, std,
-		     get_CI (std, args->iters_count));
+	      fprintf(out, "%s,Accumulatrice,%.8G,%.8G,%.8G,%.8G\n",
+			   args->vars_list[i], mean, mean / args->pop, std,
+			   get_CI (std, args->iters_count));
 	    }
 
 	  ++acc_vars_rank;
 	  break;
 
 	case DISCRETE:
-	  /* On insère d'abord dans le « set » les clés existantes */
-	  for (v = 0; v < args->iters_count; ++v)
-	    for (it = args->discrete_results[offset_dis +
-					     (args->discrete_vars_count * v)
-					     + dis_vars_rank].begin();
-		 it != args->discrete_results[offset_dis +
-					      (args->discrete_vars_count
-					       * v) + dis_vars_rank].end();
-		 ++it)
-	      keys.insert(it->first);
+	  /* Les valeurs connues du dictionnaire, en ordre alphabétique */
+	  keys_count = dictionary_snapshot (args->dictionaries
+					    + dis_vars_rank, &keys, &order);
+	  counts = args->discrete_results + offset_dis + dis_vars_rank;
 
 	  if (! args->no_show [i])
-	    printf("%s, Discrète\n", args->vars_list[i]);
+	    fprintf(out, "%s, Discrète\n", args->vars_list[i]);
 
-	  /* Toutes les valeurs pour les clés existantes */
-	  for (key_it = keys.begin(); key_it != keys.end(); ++key_it)
+	  /* Les comptes de toutes les valeurs à la fois, une itération
+	   * après l'autre */
+	  if (stats == NULL)
 	    {
-	      sum = 0;
+	      column_sums sums;
+	      double *dis_means = (double*) malloc (sizeof(double)
+						    * (keys_count + 1));
+	      double *dis_stds = (double*) malloc (sizeof(double)
+						   * (keys_count + 1));
+
+	      sums_init (&sums, keys_count);
+	      for (v = 0; v < args->iters_count; ++v)
+		{
+		  dc = counts + args->discrete_vars_count * v;
+		  sums_add_u32 (&sums, dc->counts,
+				dc->size < keys_count ? dc->size : keys_count);
+		}
+	      sums_means (&sums, dis_means);
+
 	      for (v = 0; v < args->iters_count; ++v)
 		{
-		  sum += args->discrete_results[offset_dis +
-						(args->discrete_vars_count
-						 * v) + dis_vars_rank]
-		    [*key_it];
+		  dc = counts + args->discrete_vars_count * v;
+		  sums_dev_u32 (&sums, dc->counts,
+				dc->size < keys_count ? dc->size : keys_count,
+				dis_means);
 		}
-	      mean = sum / args->iters_count;
+	      sums_stds (&sums, dis_stds);
+	      sums_free (&sums);
 
-	      sum = 0;
-	      for (v = 0; v< args->iters_count; ++v)
+	      for (p = 0; p < (int) keys_count; ++p)
 		{
-		  sum += pow (args->discrete_results
-			      [offset_dis + (args->discrete_vars_count
-					     * v) + dis_vars_rank]
-			      [*key_it] - mean, 2);
+		  id = order[p];
+
+		  /* Valeur absente du scénario */
+		  if (! dis_means[id])
+		    continue;
+
+		  if (! args->no_show [i] )
+		    {
+		      fprintf(out, ",%s,%.8G, %.8G %%, %.8G, %.8G\n",
+				   keys[id], dis_means[id],
+				   (dis_means[id] / args->pop) * 100,
+				   dis_stds[id], get_CI (dis_stds[id],
+							 args->iters_count));
+		    }
 		}
-	      std = sqrt (sum / (args->iters_count-1));
+
+	      free (dis_means);
+	      free (dis_stds);
+	    }
+
+	  /* Mode --streaming: toutes les valeurs présentes dans le
+	   * scénario (un compte absent d'une itération vaut 0) */
+	  for (p = 0; stats != NULL && p < (int) keys_count; ++p)
+	    {
+	      id = order[p];
+
+	      if (id >= dstats[dis_vars_rank].size
+		  || ! dstats[dis_vars_rank].stats[id].count)
+		continue;
+
+	      /* Les itérations sans la valeur: des zéros */
+	      w.count = args->iters_count
+		- dstats[dis_vars_rank].stats[id].count;
+	      w.mean  = 0;
+	      w.m2    = 0;
+	      welford_merge (&w, dstats[dis_vars_rank].stats + id);
+	      welford_result (&w, &mean, &std);
 
 	      if (! args->no_show [i] )
 		{
-		  printf(",%s,%.8G, %.8G %%, %.8G, %.8G\n", key_it->c_str(),
-			 mean, (mean / args->pop) * 100, std,
-			 get_CI (std, args->iters_count));
+		  fprintf(out, ",%s,%.8G, %.8G %%, %.8G, %.8G\n", keys[id],
+			       mean, (mean / args->pop) * 100, std,
+			       get_CI (std, args->iters_count));
 		}
 	    }
 
 	  ++dis_vars_rank;
-	  keys.clear(); /* Remettre à zéro pour itération suivante */
+	  free (keys);
+	  free (order);
 	  break;
 	}
 
@@ -3076,34 +5241,21 @@ IC (±)");
   /* Expressions booléennes */
   if (args->c_bool_count)
     {
-      puts("\n\nExpressions booléennes:");
-      puts("-----------------------------\n");
-      puts("Désignation,Valeur,Relatif,Ecart type,IC (±)");
+      fputs("\n\nExpressions booléennes:\n", out);
+      fputs("-----------------------------\n\n", out);
+      fputs("Désignation,Valeur,Relatif,Ecart type,IC (±)\n", out);
 
       for (i = 0; i < args->c_bool_count; i++)
 	{
-	  sum = 0;
-	  for (v = 0; v < args->iters_count; ++v)
-	    {
-	      sum += args->c_bool_results [offset_c_bo +
-					   (args->c_bool_count * v) + i];
-	    }
-	  mean = sum / args->iters_count;
-
-	  sum = 0;
-	  for (v = 0; v < args->iters_count; ++v)
-	    {
-	      sum += pow (args->c_bool_results [offset_c_bo +
-						(args->c_bool_count * v)
-						+ i] - mean, 2);
-	    }
-	  std = sqrt (sum / (args->iters_count-1));
+	  mean = means[c_bool_off + i];
+	  std  = stds [c_bool_off + i];
 
 	  if (! args->no_show [args->vars_count + i] )
 	    {
-	      printf("%s,%.8G,%.8G %%,%.8G,%.8G\n", args->c_bool_labels[i],
-		     mean, (mean / args->pop) * 100, std,
-		     get_CI (std, args->iters_count));
+	      fprintf(out, "%s,%.8G,%.8G %%,%.8G,%.8G\n",
+			   args->c_bool_labels[i], mean,
+			   (mean / args->pop) * 100, std,
+			   get_CI (std, args->iters_count));
 	    }
 
 	  if (! args->ICR_vars_count)
@@ -3135,36 +5287,22 @@ IC (±)");
   if (args->total_loc_count)
     {
       char *cond_var;
-      puts("\n\nCalculs locaux:");
-      puts("-----------------------------\n");
-      puts("Désignation,Calcul effectué,Condition,Valeur,Ecart type,IC (±)");
+      fputs("\n\nCalculs locaux:\n", out);
+      fputs("-----------------------------\n\n", out);
+      fputs("Désignation,Calcul effectué,Condition,Valeur,Ecart type,\
+IC (±)\n", out);
 
       for (i = 0; i < args->total_loc_count; ++i)
 	{
-	  sum = 0;
-	  for (v = 0; v < args->iters_count; ++v)
-	    {
-	      sum += args->loc_results [offset_loc + (args->total_loc_count
-						      * v) + i] ;
-	    }
-	  mean = sum / args->iters_count;
-
-	  sum = 0;
-	  for (v = 0; v < args->iters_count; ++v)
-	    {
-	      sum += pow (args->loc_results [offset_loc
-					     + (args->total_loc_count
-						* v) + i]
-			  - mean, 2) ;
-	    }
-	  std = sqrt (sum / (args->iters_count-1));
+	  mean = means[loc_off + i];
+	  std  = stds [loc_off + i];
 
 	  if (! args->no_show [args->vars_count + args->c_bool_count + i] )
 	    {
 	      if (args->loc_labels[i] != NULL)
-		printf("%s,", args->loc_labels[i]);
+		fprintf(out, "%s,", args->loc_labels[i]);
 	      else
-		printf(",");
+		fprintf(out, ",");
 
 	      /* Vérifier s'il s'agit d'un calcul avec condition */
 	      if ( i >= args->loc_count )
@@ -3178,13 +5316,13 @@ IC (±)");
 		    : args->vars_list[args->cond_vars_rank
 				     [i - args->loc_count]];
 
-		  printf("%s,%s", args->loc_list[i], cond_var);
+		  fprintf(out, "%s,%s", args->loc_list[i], cond_var);
 		}
 	      else
-		printf("%s,", args->loc_list[i]);
+		fprintf(out, "%s,", args->loc_list[i]);
 
-	      printf(",%.8G,%.8G,%.8G\n", mean, std,
-		     get_CI (std, args->iters_count));
+	      fprintf(out, ",%.8G,%.8G,%.8G\n", mean, std,
+			   get_CI (std, args->iters_count));
 	    }
 
 	  if (! args->ICR_vars_count)
@@ -3215,187 +5353,143 @@ IC (±)");
   /* Calculs globaux */
   if (args->calcs_count)
     {
-      char   tokenizer [BUFFER_SIZE]; /* pour recevoir une copie qui sera
-                                       * mise en morceaux par strtok_r */
-      char   buffer    [BUFFER_SIZE];
-      char   *parsing, *dump;
-      int    nb_equ_vars;
+      int    max_vars = 1;
+      for (i = 0; i < args->calcs_count; ++i)
+	if (args->calcs_progs[i].vars_count > max_vars)
+	  max_vars = args->calcs_progs[i].vars_count;
+
+      /* Les valeurs de chaque itération (sauf en mode --streaming) */
+      int    rows = stats != NULL ? 1 : args->iters_count;
 
       double *storing = (double*) malloc
-	(sizeof(double) * args->iters_count * args->calcs_count);
+	(sizeof(double) * rows * args->calcs_count);
+
+      /* Les colonnes (une valeur par itération) des variables d'un
+       * calcul, recopiées de façon contiguë */
+      double *columns = (double*) malloc
+	(sizeof(double) * rows * max_vars);
+      const double **operands = (const double**) malloc
+	(sizeof(double*) * max_vars);
+      char   *errors = (char*) malloc (rows);
 
-      int    return_check;
+      double *column;
       int    glob_offs;
       int    premature_exit;
+      int    rank;
 
-      eval   evaluator;
+      fputs("\n\nCalculs globaux:\n", out);
+      fputs("-----------------------------\n\n", out);
+      fputs("Désignation,Calcul effectué,Valeur,Ecart type,IC (±)\n", out);
 
-      puts("\n\nCalculs globaux:");
-      puts("-----------------------------\n");
-      puts("Désignation,Calcul effectué,Valeur,Ecart type,IC (±)");
-
-      /* Même procédure que calculs locaux. Un peu plus complexe car
-       * + de types possibles. (géré par des énoncés "switch") */
+      /* Chaque calcul est évalué sur toutes les itérations à la fois:
+       * une passe par opération sur des colonnes contiguës. */
       for (i = 0; i < args->calcs_count; ++i)
 	{
 	  glob_offs = i * args->iters_count;
 	  premature_exit = 0;
-	  sum = 0;
-	  parsing = strchr (args->calcs_list[i], "\""[0]);
 
-	  if (parsing == NULL)
+	  if (! args->calcs_progs[i].vars_count)
 	    {
-	      printf("Calcul invalide! Il faut utiliser au moins une \
+	      fprintf(out, "Calcul invalide! Il faut utiliser au moins une \
 variable: %s\n",
-		     args->calcs_list[i]);
+			   args->calcs_list[i]);
 	      continue;
 	    }
 
-	  nb_equ_vars = 0;
-
-	  while (parsing != NULL)
-	    {
-	      parsing = strchr (parsing+1, "\""[0]);
-	      ++nb_equ_vars;
-	    }
-	  nb_equ_vars >>= 1;
-
-	  for (v = 0; v < args->iters_count; ++v)
+	  /* Mode --streaming: déjà évalué fichier par fichier */
+	  if (stats != NULL)
 	    {
-	      strcpy (tokenizer, args->calcs_list[i]);
-
-	      if (tokenizer[0] != "\""[0])
-		{
-		  parsing = strtok_r (tokenizer, "\"", &dump);
-		  strcpy (buffer, parsing);
-		  parsing = strtok_r (NULL, "\"", &dump);
-		}
-	      else
-		{
-		  strcpy(buffer, "");
-		  parsing = strtok_r(tokenizer, "\"", &dump);
-		  parsing++;
-		}
-
-	      switch (args->calcs_vars_types[i][0])
+	      if (calcs_errors[i] >= 0)
 		{
-		case BOOLEAN:
-		  sprintf (buffer, "%s%u", buffer, args->bool_results
-			   [offset_bo + (args->bool_vars_count * v) +
-			    args->calcs_relative_ranks[i][0]]);
-		  break;
-
-		case ACCUMUL:
-		  sprintf (buffer, "%s%f", buffer, args->acc_results
-			   [offset_acc + (args->acc_vars_count * v)
-			    + args->calcs_relative_ranks[i][0]]);
-		  break;
-
-		case CUSTOM_BOOLEAN:
-		  sprintf (buffer, "%s%u", buffer, args->c_bool_results
-			   [offset_c_bo + (args->c_bool_count * v)
-			    + args->calcs_relative_ranks[i][0]]);
-		  break;
-
-		case LOC_CALC:
-		  sprintf (buffer, "%s%f", buffer, args->loc_results
-			   [offset_loc + (args->total_loc_count * v)
-			    + args->calcs_relative_ranks[i][0]]);
-		  break;
+		  fprintf(out, "Erreur de champ (« range ») dans les \
+calculs globaux: %s, scénario: %s, iteration: %d\n",
+			       args->calcs_list[i], args->name,
+			       calcs_errors[i]);
+		  premature_exit = 1;
 
-		case GLOB_CALC:
-		  sprintf (buffer, "%s%f", buffer, storing
-			   [(args->calcs_relative_ranks[i][0]
-			     * args->iters_count) + v]);
-		  break;
+		  if (args->calcs_labels[i] != NULL)
+		    fprintf(out, "Avertissement: Une étiquette a été \
+détectée: %s. Prendre garde que toute expression/calcul utilisant cette \
+variable sera évidemment faussé(e).\n",
+				 args->calcs_labels[i]);
 		}
-
-	      for (p = 1; p < nb_equ_vars; ++p)
+	      welford_result (calcs_stats + i, &mean, &std);
+	    }
+	  else
+	    {
+	      for (p = 0; p < args->calcs_progs[i].vars_count; ++p)
 		{
-		  parsing = strtok_r (NULL, "\"", &dump);
-		  strcat (buffer, parsing);
-		  parsing = strtok_r (NULL, "\"", &dump);
+		  rank   = args->calcs_relative_ranks[i][p];
+		  column = columns + p * args->iters_count;
 
 		  switch (args->calcs_vars_types[i][p])
 		    {
 		    case BOOLEAN:
-		      sprintf (buffer, "%s%u", buffer, args->bool_results
-			       [offset_bo + (args->bool_vars_count * v)
-				+ args->calcs_relative_ranks[i][p]]);
+		      tensor_column (&args->bool_results, first_file, rank,
+				     args->iters_count, column);
 		      break;
 
 		    case ACCUMUL:
-		      sprintf (buffer, "%s%f", buffer, args->acc_results
-			       [offset_acc + (args->acc_vars_count * v)
-				+ args->calcs_relative_ranks[i][p]]);
+		      tensor_column (&args->acc_results, first_file, rank,
+				     args->iters_count, column);
 		      break;
 
 		    case CUSTOM_BOOLEAN:
-		      sprintf (buffer, "%s%u", buffer, args->c_bool_results
-			       [offset_c_bo + (args->c_bool_count * v)
-				+ args->calcs_relative_ranks[i][p]]);
+		      tensor_column (&args->c_bool_results, first_file, rank,
+				     args->iters_count, column);
 		      break;
 
 		    case LOC_CALC:
-		      sprintf (buffer, "%s%f", buffer, args->loc_results
-			       [offset_loc + (args->total_loc_count * v)
-				+ args->calcs_relative_ranks[i][p]]);
+		      tensor_column (&args->loc_results, first_file, rank,
+				     args->iters_count, column);
 		      break;
 
 		    case GLOB_CALC:
-		      sprintf (buffer, "%s%f", buffer, storing
-			       [(args->calcs_relative_ranks[i][p]
-				 * args->iters_count) + v]);
+		      /* Déjà contigu */
+		      column = storing + rank * args->iters_count;
 		      break;
 		    }
+		  operands[p] = column;
 		}
 
-	      parsing = strtok_r (NULL, "\"", &dump);
-
-	      if (parsing != NULL)
-		strcat(buffer, parsing);
-
-	      /* appel d'un équivalent C du 'eval' pythonesqe */
-	      return_check = evaluator.evaluate (buffer, storing
-						 + glob_offs + v);
-
-	      if (return_check == -2)
+	      if (eval::execute_columns (args->calcs_progs + i, operands,
+					 args->iters_count,
+					 storing + glob_offs, errors)
+		  == R_ERROR)
 		{
-		  printf("Erreur de champ (« range ») dans les calculs \
-globaux: %s, calcul: %s, scénario: %s, iteration: %d\n",
-			 args->calcs_list[i], buffer, args->name, v);
-		  premature_exit = 1;
+		  for (v = 0; v < args->iters_count; ++v)
+		    {
+		      if (! errors[v])
+			continue;
 
-		  if (args->calcs_labels[i] != NULL)
-		    printf("Avertissement: Une étiquette a été détectée: \
-%s. Prendre garde que toute expression/calcul utilisant cette \
+		      fprintf(out, "Erreur de champ (« range ») dans les \
+calculs globaux: %s, scénario: %s, iteration: %d\n",
+				   args->calcs_list[i], args->name, v);
+		      premature_exit = 1;
+
+		      if (args->calcs_labels[i] != NULL)
+			fprintf(out, "Avertissement: Une étiquette a été \
+détectée: %s. Prendre garde que toute expression/calcul utilisant cette \
 variable sera évidemment faussé(e).\n",
-			   args->calcs_labels[i]);
+				     args->calcs_labels[i]);
+		    }
 		}
 
-	      sum += storing [glob_offs + v];
-	    }
-
-	  mean = sum / args->iters_count;
-
-	  sum = 0;
-	  for (v = 0; v < args->iters_count; ++v)
-	    {
-	      sum += pow (storing[glob_offs + v] - mean, 2);
+	      column_stats (storing + glob_offs, args->iters_count,
+			    &mean, &std);
 	    }
-	  std = sqrt(sum / (args->iters_count-1));
 
 	  if (! args->no_show [args->vars_count + args->c_bool_count
 			       + args->total_loc_count + i]
 	      && ! premature_exit)
 	    {
 	      if (args->calcs_labels[i] != NULL)
-		printf("%s,", args->calcs_labels[i]);
+		fprintf(out, "%s,", args->calcs_labels[i]);
 	      else
-		printf(",");
+		fprintf(out, ",");
 
-	      printf("%s,%.8G,%.8G,%.8G\n", args->calcs_list[i], mean, std,
-		     get_CI (std, args->iters_count));
+	      fprintf(out, "%s,%.8G,%.8G,%.8G\n", args->calcs_list[i], mean,
+			   std, get_CI (std, args->iters_count));
 	    }
 
 	  if (! args->ICR_vars_count)
@@ -3421,16 +5515,22 @@ variable sera évidemment faussé(e).\n",
 		}
 	    }
 	}
+      free (columns);
+      free (operands);
+      free (errors);
       free (storing);
     }
-  printf("\n\n");
-  return;
-}
 
-/*
- * Callback de qsort.
- */
-int sort_func (const void *elem1, const void *elem2)
-{
-  return ( *(double*)elem1 - *(double*)elem2 ) > 0 ? 1 : -1 ;
+  free (means);
+  free (stds);
+  if (stats != NULL)
+    {
+      for (i = 0; i < args->discrete_vars_count; ++i)
+	free (dstats[i].stats);
+      free (stats);
+      free (dstats);
+      free (calcs_errors);
+    }
+  fprintf(out, "\n\n");
+  return;
 }
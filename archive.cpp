@@ -0,0 +1,436 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <ctype.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "archive.h"
+
+#define TAR_BLOCK 512
+
+/* Les archives montées (voir archive.h) */
+static pthread_mutex_t mounted_lock = PTHREAD_MUTEX_INITIALIZER;
+static archive **mounted;
+static int     mounted_count;
+
+static uint64_t header_hash (const archive_header *header,
+			     const archive_entry *entries)
+{
+  uint64_t hash = cache_hash (header, offsetof(archive_header,
+					       header_hash), 0);
+  return cache_hash (entries, sizeof(archive_entry)
+		     * header->entries_count, hash);
+}
+
+/*
+ * L'itération d'un fichier N_Output.gz ou N_Summary.gz (le nom peut
+ * avoir un répertoire), ou -1. Le genre du fichier est mis dans 'kind'.
+ */
+static int member_iter (const char *name, uint32_t *kind)
+{
+  const char *base = strrchr (name, '/');
+  char       *end;
+  long       iter;
+
+  base = base != NULL ? base + 1 : name;
+  if (! isdigit ((unsigned char) base[0]))
+    return -1;
+
+  iter = strtol (base, &end, 10);
+  if (iter >= INT_MAX)
+    return -1;
+
+  if (! strcmp (end, "_Output.gz"))
+    *kind = ARCHIVE_OUTPUT;
+  else if (! strcmp (end, "_Summary.gz"))
+    *kind = ARCHIVE_SUMMARY;
+  else
+    return -1;
+  return iter;
+}
+
+/*
+ * Un nombre d'un en-tête tar: en octal, ou en base 256 si le premier
+ * octet a son bit de poids fort (GNU, pour les gros fichiers).
+ */
+static uint64_t tar_number (const unsigned char *field, int length)
+{
+  uint64_t value = 0;
+  int      i = 0;
+
+  if (field[0] & 0x80)
+    {
+      value = field[0] & 0x7f;
+      for (i = 1; i < length; ++i)
+	value = value << 8 | field[i];
+      return value;
+    }
+
+  while (i < length && (field[i] == ' ' || field[i] == '0'))
+    i++;
+  for (; i < length && field[i] >= '0' && field[i] <= '7'; ++i)
+    value = value * 8 + field[i] - '0';
+  return value;
+}
+
+/*
+ * Le nom 'path=' d'un en-tête pax ("longueur clé=valeur\n" répétés),
+ * copié dans 'name'. Retourne 0 si l'en-tête n'en a pas.
+ */
+static int pax_path (const char *records, size_t size, char *name,
+		     size_t name_size)
+{
+  const char *record = records, *key, *end = records + size;
+  long       length;
+  int        found = 0;
+
+  while (record < end)
+    {
+      length = strtol (record, (char**) &key, 10);
+      if (length <= 0 || length > end - record || *key != ' ')
+	return found;
+      key++;
+
+      if (! strncmp (key, "path=", 5))
+	{
+	  size_t value = record + length - 1 - (key + 5);
+	  if (value >= name_size)
+	    value = name_size - 1;
+	  memcpy (name, key + 5, value);
+	  name[value] = '\0';
+	  found = 1;
+	}
+      record += length;
+    }
+
+  return found;
+}
+
+static int compare_entries (const void *elem1, const void *elem2)
+{
+  const archive_entry *e1 = (const archive_entry*) elem1;
+  const archive_entry *e2 = (const archive_entry*) elem2;
+
+  if (e1->kind != e2->kind)
+    return e1->kind < e2->kind ? -1 : 1;
+  if (e1->iter != e2->iter)
+    return e1->iter - e2->iter;
+  return e1->offset < e2->offset ? -1 : e1->offset > e2->offset;
+}
+
+/*
+ * Parcourt les en-têtes de l'archive (ustar, GNU ou pax) et garde ses
+ * membres N_Output.gz et N_Summary.gz, par genre et itération. Un
+ * membre présent deux fois (archive complétée avec tar -r) est pris dans
+ * sa dernière version, comme le ferait tar. Retourne 0 si l'archive est
+ * illisible.
+ */
+static int scan_tar (archive *a)
+{
+  unsigned char block [TAR_BLOCK];
+  char          name [PATH_MAX], *extra;
+  uint64_t      offset = 0, size, blocks;
+  int           long_name = 0, iter, k, kept;
+  uint32_t      kind;
+  cache_buffer  entries;
+  archive_entry entry;
+
+  cache_buffer_init (&entries);
+
+  for (;;)
+    {
+      if (pread (a->fd, block, TAR_BLOCK, offset) != TAR_BLOCK)
+	break;
+
+      /* Deux blocs nuls terminent l'archive (un seul suffit ici) */
+      if (block[0] == '\0')
+	break;
+
+      size   = tar_number (block + 124, 12);
+      blocks = (size + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK;
+
+      /* Nom long (GNU) ou attributs (pax) du membre suivant */
+      if (block[156] == 'L' || block[156] == 'x')
+	{
+	  extra = (char*) malloc (size + 1);
+	  if (pread (a->fd, extra, size, offset + TAR_BLOCK)
+	      != (ssize_t) size)
+	    {
+	      free (extra);
+	      break;
+	    }
+	  extra[size] = '\0';
+
+	  if (block[156] == 'L')
+	    {
+	      snprintf (name, PATH_MAX, "%s", extra);
+	      long_name = 1;
+	    }
+	  else if (pax_path (extra, size, name, PATH_MAX))
+	    long_name = 1;
+	  free (extra);
+
+	  offset += TAR_BLOCK + blocks;
+	  continue;
+	}
+
+      /* Sinon: préfixe (ustar) et nom */
+      if (! long_name)
+	{
+	  if (! memcmp (block + 257, "ustar", 5) && block[345])
+	    snprintf (name, PATH_MAX, "%.155s/%.100s", block + 345, block);
+	  else
+	    snprintf (name, PATH_MAX, "%.100s", block);
+	}
+      long_name = 0;
+
+      iter = member_iter (name, &kind);
+      if ((block[156] == '0' || block[156] == '\0') && iter >= 0)
+	{
+	  entry.offset = offset + TAR_BLOCK;
+	  entry.size   = size;
+	  entry.mtime  = tar_number (block + 136, 12);
+	  entry.iter   = iter;
+	  entry.kind   = kind;
+	  cache_buffer_add (&entries, &entry, sizeof(entry));
+	}
+
+      offset += TAR_BLOCK + blocks;
+    }
+
+  a->entries_count = entries.size / sizeof(archive_entry);
+  a->entries       = (archive_entry*) entries.data;
+
+  if (a->entries_count)
+    qsort (a->entries, a->entries_count, sizeof(archive_entry),
+	   compare_entries);
+
+  /* La dernière version de chaque membre */
+  for (k = 0, kept = 0; k < a->entries_count; ++k)
+    {
+      if (kept && a->entries[kept - 1].kind == a->entries[k].kind
+	  && a->entries[kept - 1].iter == a->entries[k].iter)
+	kept--;
+      a->entries[kept++] = a->entries[k];
+    }
+  a->entries_count = kept;
+
+  return offset > 0;
+}
+
+/*
+ * Reprend les membres de l'index 'path' s'il correspond encore à
+ * l'archive.
+ */
+static int load_index (archive *a, const char *path)
+{
+  archive_header header;
+  struct stat    file_stat;
+  size_t         size;
+  int            fd, ok;
+
+  fd = open (path, O_RDONLY);
+  if (fd < 0)
+    return 0;
+
+  ok = ! fstat (fd, &file_stat)
+    && pread (fd, &header, sizeof(header), 0) == sizeof(header)
+    && ! memcmp (header.magic, ARCHIVE_MAGIC, sizeof(header.magic))
+    && header.version == ARCHIVE_VERSION
+    && header.endian == CACHE_ENDIAN
+    && ! memcmp (&header.source, &a->stamp, sizeof(cache_stamp))
+    && (uint64_t) file_stat.st_size == sizeof(header)
+    + (uint64_t) header.entries_count * sizeof(archive_entry);
+
+  if (ok)
+    {
+      size = sizeof(archive_entry) * header.entries_count;
+      a->entries = (archive_entry*) malloc (size + 1);
+      ok = pread (fd, a->entries, size, sizeof(header)) == (ssize_t) size
+	&& header.header_hash == header_hash (&header, a->entries);
+
+      if (ok)
+	a->entries_count = header.entries_count;
+      else
+	free (a->entries);
+    }
+
+  close (fd);
+  return ok;
+}
+
+/*
+ * Enregistre les membres dans 'path'. Fichier temporaire renommé une
+ * fois complet; un index qui ne peut être écrit est simplement refait à
+ * la prochaine analyse.
+ */
+static void save_index (const archive *a, const char *path)
+{
+  archive_header header;
+  int            ok;
+
+  memset (&header, 0, sizeof(header));
+  memcpy (header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+  header.version       = ARCHIVE_VERSION;
+  header.endian        = CACHE_ENDIAN;
+  header.source        = a->stamp;
+  header.entries_count = a->entries_count;
+  header.header_hash   = header_hash (&header, a->entries);
+
+  size_t tmp_size = strlen (path) + 32;
+  char  *tmp_path = (char*) malloc (tmp_size);
+  snprintf (tmp_path, tmp_size, "%s.tmp.%ld", path, (long) getpid ());
+
+  FILE *pIndex = fopen (tmp_path, "wb");
+  if (pIndex != NULL)
+    {
+      ok = fwrite (&header, sizeof(header), 1, pIndex) == 1
+	&& (! a->entries_count
+	    || fwrite (a->entries, sizeof(archive_entry)
+		       * a->entries_count, 1, pIndex) == 1);
+
+      ok = fclose (pIndex) == 0 && ok;
+      ok = ok && rename (tmp_path, path) == 0;
+      if (! ok)
+	remove (tmp_path);
+    }
+  free (tmp_path);
+}
+
+/*
+ * Monte l'archive 'results_path'/'name'.tar à la place du répertoire
+ * 'results_path'/'name'/, avec son index dans le répertoire
+ * 'index_path'. Retourne NULL s'il n'y a pas d'archive lisible.
+ */
+const archive *archive_mount (const char *results_path, const char *name,
+			      const char *index_path)
+{
+  char    path [PATH_MAX];
+  archive *a;
+  int     k;
+
+  snprintf (path, PATH_MAX, "%s%s/", results_path, name);
+
+  pthread_mutex_lock (&mounted_lock);
+  for (k = 0; k < mounted_count; ++k)
+    if (! strcmp (mounted[k]->dir, path))
+      {
+	pthread_mutex_unlock (&mounted_lock);
+	return mounted[k];
+      }
+  pthread_mutex_unlock (&mounted_lock);
+
+  a = (archive*) malloc (sizeof(archive));
+  a->dir           = strdup (path);
+  a->dir_length    = strlen (path);
+  a->entries       = NULL;
+  a->entries_count = 0;
+
+  snprintf (path, PATH_MAX, "%s%s.tar", results_path, name);
+  cache_stamp_file (&a->stamp, path);
+  a->fd = open (path, O_RDONLY);
+
+  if (a->fd < 0)
+    {
+      free (a->dir);
+      free (a);
+      return NULL;
+    }
+
+  snprintf (path, PATH_MAX, "%s%s.tar.idx", index_path, name);
+  if (! load_index (a, path))
+    {
+      if (! scan_tar (a))
+	{
+	  close (a->fd);
+	  free (a->entries);
+	  free (a->dir);
+	  free (a);
+	  return NULL;
+	}
+
+      /* Le répertoire des index, au premier index écrit */
+      mkdir (index_path, 0755);
+      save_index (a, path);
+    }
+
+  pthread_mutex_lock (&mounted_lock);
+  mounted = (archive**) realloc (mounted, sizeof(archive*)
+				 * (mounted_count + 1));
+  mounted[mounted_count++] = a;
+  pthread_mutex_unlock (&mounted_lock);
+
+  return a;
+}
+
+/*
+ * Le membre qui remplace le fichier 'path' (Results/S/N_Output.gz ou
+ * N_Summary.gz), si son scénario est archivé. 'member' peut être NULL.
+ */
+int archive_find (const char *path, archive_member *member)
+{
+  const archive       *a = NULL;
+  const archive_entry *entry;
+  int k, iter, first, last, middle;
+  uint32_t kind;
+
+  pthread_mutex_lock (&mounted_lock);
+  for (k = 0; k < mounted_count && a == NULL; ++k)
+    if (! strncmp (mounted[k]->dir, path, mounted[k]->dir_length))
+      a = mounted[k];
+  pthread_mutex_unlock (&mounted_lock);
+
+  if (a == NULL || strchr (path + a->dir_length, '/') != NULL
+      || (iter = member_iter (path + a->dir_length, &kind)) < 0)
+    return 0;
+
+  /* Les membres sont triés par genre et itération */
+  first = 0;
+  last  = a->entries_count;
+  while (first < last)
+    {
+      middle = (first + last) / 2;
+      if (a->entries[middle].kind < kind
+	  || (a->entries[middle].kind == kind
+	      && a->entries[middle].iter < iter))
+	first = middle + 1;
+      else
+	last = middle;
+    }
+
+  if (first == a->entries_count || a->entries[first].kind != kind
+      || a->entries[first].iter != iter)
+    return 0;
+
+  if (member != NULL)
+    {
+      entry = a->entries + first;
+      member->fd               = a->fd;
+      member->offset           = entry->offset;
+      member->size             = entry->size;
+      member->stamp.size       = entry->size;
+      member->stamp.mtime_sec  = entry->mtime;
+      member->stamp.mtime_nsec = 0;
+      member->stamp.inode      = a->stamp.inode;
+    }
+  return 1;
+}
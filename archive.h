@@ -0,0 +1,93 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Scénarios archivés: un fichier Results/S.tar (tar non compressé)
+ * remplace le répertoire Results/S/, sans extraction. Ses membres
+ * N_Output.gz (peu importe leur répertoire dans l'archive) sont lus sur
+ * place (de même que ses membres N_Summary.gz), par des lectures
+ * positionnées (pread) sur un seul descripteur partagé par tous les
+ * threads.
+ *
+ * La première fois, l'archive est parcourue d'un en-tête tar à l'autre
+ * (sans lire les membres), puis la position, la taille et la date de
+ * chaque membre sont enregistrées dans Analyse/Archives/S.tar.idx. Comme
+ * un index d'accès (gzindex.h), ce fichier garde l'empreinte de
+ * l'archive: il est refait dès que l'archive change.
+ *
+ * Une archive montée l'est jusqu'à la fin du programme, pour tous les
+ * projets: les lecteurs (inflate.h, prefetch.h) continuent d'ouvrir
+ * Results/S/N_Output.gz, et archive_find trouve le membre qui
+ * correspond à ce chemin.
+ */
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cache.h"
+
+#define ARCHIVE_MAGIC   "ANALTAR"  /* 8 octets avec le NUL */
+#define ARCHIVE_VERSION 1
+
+/* Fichiers de résultats d'une itération */
+enum archive_kinds {ARCHIVE_OUTPUT, ARCHIVE_SUMMARY};
+
+struct archive_entry
+{
+  uint64_t      offset;  /* Premier octet du membre dans l'archive */
+  uint64_t      size;
+  int64_t       mtime;
+  int32_t       iter;
+  uint32_t      kind;
+};
+
+struct archive_header
+{
+  char          magic [8];
+  uint32_t      version;
+  uint32_t      endian;
+  cache_stamp   source;       /* Empreinte de l'archive */
+  uint32_t      entries_count;
+  uint32_t      reserved;
+  uint64_t      header_hash;  /* En-tête, puis les membres */
+};
+
+struct archive
+{
+  char          *dir;       /* Répertoire remplacé (avec le '/' final) */
+  size_t        dir_length;
+  int           fd;
+  cache_stamp   stamp;
+  archive_entry *entries;   /* Par genre, puis par itération */
+  int           entries_count;
+};
+
+/* Un membre trouvé par archive_find */
+struct archive_member
+{
+  int           fd;         /* Celui de l'archive: ne pas le fermer */
+  uint64_t      offset;
+  uint64_t      size;
+  cache_stamp   stamp;
+};
+
+const archive *archive_mount (const char *results_path, const char *name,
+			      const char *index_path);
+
+int   archive_find  (const char *path, archive_member *member);
+
+#endif /* ARCHIVE_H */
@@ -0,0 +1,218 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <atomic>
+#include <algorithm>
+#include "bootstrap.h"
+
+#define BOOTSTRAP_BLOCK 65536  /* Tirages par tâche */
+
+/*
+ * Les tâches d'une vague de comparaisons, prises par les threads dans
+ * l'ordre d'un compteur partagé.
+ */
+struct bootstrap_wave
+{
+  bootstrap_pair *pairs;
+  double        *samples;  /* 'draws' échantillons par comparaison */
+  long          draws;
+  long          blocks;    /* Blocs de tirages par comparaison */
+  uint32_t      key [2];
+  int           first;     /* Rang de la première comparaison */
+  int           count;
+  int           select;    /* 0: tirages, 1: percentiles */
+  std::atomic<long> next;
+};
+
+/*
+ * Philox4x32-10: chiffre le compteur 'ctr' avec la clé 'key'.
+ */
+static void philox (uint32_t ctr [4], const uint32_t key [2])
+{
+  uint32_t k0 = key[0], k1 = key[1];
+  uint64_t p0, p1;
+
+  for (int r = 0; r < 10; ++r)
+    {
+      p0 = (uint64_t) 0xD2511F53 * ctr[0];
+      p1 = (uint64_t) 0xCD9E8D57 * ctr[2];
+
+      ctr[0] = (uint32_t) (p1 >> 32) ^ ctr[1] ^ k0;
+      ctr[1] = (uint32_t) p1;
+      ctr[2] = (uint32_t) (p0 >> 32) ^ ctr[3] ^ k1;
+      ctr[3] = (uint32_t) p0;
+
+      k0 += 0x9E3779B9;
+      k1 += 0xBB67AE85;
+    }
+}
+
+/*
+ * Les quatre réels uniformes [0, 1) du tirage 'draw' de la comparaison
+ * 'stream' (53 bits chacun).
+ */
+static void uniforms (const uint32_t key [2], uint32_t stream, long draw,
+		      double u [4])
+{
+  uint32_t ctr [4];
+
+  for (int h = 0; h < 2; ++h)
+    {
+      ctr[0] = (uint32_t) draw;
+      ctr[1] = (uint32_t) ((uint64_t) draw >> 32);
+      ctr[2] = stream;
+      ctr[3] = h;
+      philox (ctr, key);
+
+      u[2*h]   = ((((uint64_t) ctr[0] << 32) | ctr[1]) >> 11)
+	* (1. / 9007199254740992.);
+      u[2*h+1] = ((((uint64_t) ctr[2] << 32) | ctr[3]) >> 11)
+	* (1. / 9007199254740992.);
+    }
+}
+
+/*
+ * Un ICR tiré uniformément dans les intervalles de confiance des deux
+ * scénarios.
+ */
+static inline double sample (const bootstrap_pair *p, const double u [4])
+{
+  double denom = p->inv ?
+    ((u[0] * p->inter_p_var * 2) + (p->p_var - p->inter_p_var))
+    - ((u[1] * p->inter_c_var * 2) + (p->c_var - p->inter_c_var)) :
+    ((u[0] * p->inter_c_var * 2) + (p->c_var - p->inter_c_var))
+    - ((u[1] * p->inter_p_var * 2) + (p->p_var - p->inter_p_var));
+
+  return (((u[2] * p->inter_c_cmp * 2) + (p->c_cmp - p->inter_c_cmp))
+	  - ((u[3] * p->inter_p_cmp * 2) + (p->p_cmp - p->inter_p_cmp)))
+    / denom;
+}
+
+static void *bootstrap_worker (void *ptr)
+{
+  bootstrap_wave *wave = (bootstrap_wave*) ptr;
+  long jobs = wave->select ? wave->count : wave->count * wave->blocks;
+  long job, k, end;
+  double u [4];
+
+  while ((job = wave->next.fetch_add (1)) < jobs)
+    {
+      if (wave->select)
+	{
+	  /* IC basé sur les 2.5e et 97.5e percentiles */
+	  double *s  = wave->samples + job * wave->draws;
+	  double *e  = s + wave->draws;
+	  long   lo  = (long) floor ((double) wave->draws * 0.025);
+	  long   hi  = (long) ceil ((double) wave->draws * 0.975);
+
+	  if (hi > wave->draws - 1)
+	    hi = wave->draws - 1;
+
+	  std::nth_element (s, s + lo, e);
+	  if (hi > lo)
+	    std::nth_element (s + lo + 1, s + hi, e);
+
+	  wave->pairs[wave->first + job].low  = s[lo];
+	  wave->pairs[wave->first + job].high = s[hi];
+	  continue;
+	}
+
+      const bootstrap_pair *pair = wave->pairs + wave->first
+	+ job / wave->blocks;
+      double *s = wave->samples + job / wave->blocks * wave->draws;
+
+      k   = job % wave->blocks * BOOTSTRAP_BLOCK;
+      end = std::min (k + BOOTSTRAP_BLOCK, wave->draws);
+
+      for ( ; k < end; ++k)
+	{
+	  uniforms (wave->key, wave->first + job / wave->blocks, k, u);
+	  s[k] = sample (pair, u);
+	}
+    }
+
+  return NULL;
+}
+
+/*
+ * Lance 'threads_count' threads sur les tâches de la vague.
+ */
+static void run_wave (bootstrap_wave *wave, int threads_count)
+{
+  pthread_t *threads = (pthread_t*) malloc (sizeof(pthread_t)
+					    * threads_count);
+  int t;
+
+  wave->next = 0;
+  for (t = 0; t < threads_count; ++t)
+    pthread_create (threads + t, NULL, bootstrap_worker, (void*) wave);
+  for (t = 0; t < threads_count; ++t)
+    pthread_join (threads[t], NULL);
+
+  free (threads);
+}
+
+/*
+ * Calcule 'low' et 'high' de chaque comparaison avec 'draws' tirages.
+ * Les comparaisons sont traitées par vagues d'au plus 'threads_count',
+ * pour que la mémoire reste bornée: les tirages de toute la vague sont
+ * répartis entre les threads, puis la sélection de chaque comparaison.
+ */
+void bootstrap_run (bootstrap_pair *pairs, int pairs_count, long draws,
+		    unsigned long seed, int threads_count)
+{
+  bootstrap_wave wave;
+
+  if (threads_count < 1)
+    threads_count = 1;
+
+  int wave_size = pairs_count < threads_count ? pairs_count
+    : threads_count;
+
+  wave.pairs   = pairs;
+  wave.draws   = draws;
+  wave.blocks  = (draws + BOOTSTRAP_BLOCK - 1) / BOOTSTRAP_BLOCK;
+  wave.key[0]  = (uint32_t) seed;
+  wave.key[1]  = (uint32_t) ((uint64_t) seed >> 32);
+  wave.samples = (double*) malloc (sizeof(double) * draws * wave_size
+				   + 1);
+
+  if (wave.samples == NULL)
+    {
+      puts("Mémoire insuffisante.");
+      exit(1);
+    }
+
+  for (wave.first = 0; wave.first < pairs_count;
+       wave.first += wave_size)
+    {
+      wave.count = std::min (wave_size, pairs_count - wave.first);
+
+      wave.select = 0;
+      run_wave (&wave, std::min ((long) threads_count,
+				 wave.count * wave.blocks));
+
+      wave.select = 1;
+      run_wave (&wave, wave.count);
+    }
+
+  free (wave.samples);
+}
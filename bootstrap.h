@@ -0,0 +1,49 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Intervalles de confiance des ICER par bootstrap.
+ *
+ * Chaque comparaison de deux scénarios (pour une variable d'ICR) tire
+ * ses échantillons d'un flux aléatoire qui lui est propre: un générateur
+ * à compteur (Philox4x32-10), dont la valeur ne dépend que de la graine,
+ * du rang de la comparaison et du rang du tirage. Les tirages peuvent
+ * donc être faits en parallèle, par blocs, dans n'importe quel ordre: le
+ * résultat est le même pour une graine donnée, peu importe le nombre de
+ * threads.
+ *
+ * Les percentiles sont sélectionnés (nth_element) plutôt que triés.
+ */
+
+#ifndef BOOTSTRAP_H
+#define BOOTSTRAP_H
+
+struct bootstrap_pair
+{
+  /* Moyennes et demi-intervalles: c = courant, p = précédent */
+  double        c_cmp, inter_c_cmp, p_cmp, inter_p_cmp;
+  double        c_var, inter_c_var, p_var, inter_p_var;
+  int           inv;   /* Variable d'ICR inversée */
+
+  /* Résultat: les 2.5e et 97.5e percentiles */
+  double        low;
+  double        high;
+};
+
+void  bootstrap_run (bootstrap_pair *pairs, int pairs_count, long draws,
+		     unsigned long seed, int threads_count);
+
+#endif /* BOOTSTRAP_H */
@@ -0,0 +1,463 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cache.h"
+
+#define PRIME1 0x9E3779B185EBCA87ULL
+#define PRIME2 0xC2B2AE3D27D4EB4FULL
+#define PRIME3 0x165667B19E3779F9ULL
+#define PRIME4 0x85EBCA77C2B2AE63ULL
+#define PRIME5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t rotl (uint64_t x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64 (const unsigned char *p)
+{
+  uint64_t v;
+  memcpy (&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint64_t round64 (uint64_t acc, uint64_t input)
+{
+  acc += input * PRIME2;
+  return rotl (acc, 31) * PRIME1;
+}
+
+static inline uint64_t merge64 (uint64_t acc, uint64_t lane)
+{
+  acc ^= round64 (0, lane);
+  return acc * PRIME1 + PRIME4;
+}
+
+/*
+ * Hash de 64 bits dans l'esprit de xxHash64: quatre accumulateurs
+ * indépendants lisent 32 octets par tour, ce qui suffit à ne pas ralentir
+ * le chargement de gros tenseurs.
+ */
+uint64_t cache_hash (const void *data, size_t size, uint64_t seed)
+{
+  const unsigned char *p   = (const unsigned char*) data;
+  const unsigned char *end = p + size;
+  uint64_t h;
+
+  if (size >= 32)
+    {
+      uint64_t v1 = seed + PRIME1 + PRIME2;
+      uint64_t v2 = seed + PRIME2;
+      uint64_t v3 = seed;
+      uint64_t v4 = seed - PRIME1;
+
+      while (p + 32 <= end)
+	{
+	  v1 = round64 (v1, read64 (p));
+	  v2 = round64 (v2, read64 (p + 8));
+	  v3 = round64 (v3, read64 (p + 16));
+	  v4 = round64 (v4, read64 (p + 24));
+	  p += 32;
+	}
+
+      h = rotl (v1, 1) + rotl (v2, 7) + rotl (v3, 12) + rotl (v4, 18);
+      h = merge64 (h, v1);
+      h = merge64 (h, v2);
+      h = merge64 (h, v3);
+      h = merge64 (h, v4);
+    }
+  else
+    h = seed + PRIME5;
+
+  h += (uint64_t) size;
+
+  while (p + 8 <= end)
+    {
+      h ^= round64 (0, read64 (p));
+      h  = rotl (h, 27) * PRIME1 + PRIME4;
+      p += 8;
+    }
+
+  while (p < end)
+    {
+      h ^= (*p++) * PRIME5;
+      h  = rotl (h, 11) * PRIME1;
+    }
+
+  h ^= h >> 33;
+  h *= PRIME2;
+  h ^= h >> 29;
+  h *= PRIME3;
+  h ^= h >> 32;
+  return h;
+}
+
+void cache_buffer_init (cache_buffer *buf)
+{
+  buf->data     = NULL;
+  buf->size     = 0;
+  buf->capacity = 0;
+}
+
+void cache_buffer_add (cache_buffer *buf, const void *data, size_t size)
+{
+  if (buf->size + size > buf->capacity)
+    {
+      while (buf->size + size > buf->capacity)
+	buf->capacity = buf->capacity ? buf->capacity * 2 : 4096;
+      buf->data = (char*) realloc (buf->data, buf->capacity);
+    }
+
+  memcpy (buf->data + buf->size, data, size);
+  buf->size += size;
+}
+
+void cache_buffer_free (cache_buffer *buf)
+{
+  free (buf->data);
+  cache_buffer_init (buf);
+}
+
+static uint64_t header_hash (const cache_header *header)
+{
+  return cache_hash (header, offsetof(cache_header, header_hash), 0);
+}
+
+void cache_stamp_file (cache_stamp *stamp, const char *path)
+{
+  struct stat file_stat;
+
+  memset (stamp, 0, sizeof(cache_stamp));
+  if (stat (path, &file_stat))
+    return;
+
+  stamp->size       = file_stat.st_size;
+  stamp->mtime_sec  = file_stat.st_mtim.tv_sec;
+  stamp->mtime_nsec = file_stat.st_mtim.tv_nsec;
+  stamp->inode      = file_stat.st_ino;
+}
+
+/*
+ * Projette le fichier en mémoire et le valide. Un fichier absent, d'une
+ * autre version ou d'une autre disposition est simplement périmé
+ * (CACHE_STALE): le parsing doit être refait. Un fichier dont l'en-tête
+ * ou une section ne correspond pas à son hash est corrompu.
+ */
+int cache_open (cache_map *map, const char *path, uint32_t layout)
+{
+  struct stat file_stat;
+  int fd, i;
+
+  map->data = NULL;
+  map->size = 0;
+
+  fd = open (path, O_RDONLY);
+  if (fd < 0)
+    return CACHE_STALE;
+
+  if (fstat (fd, &file_stat) || file_stat.st_size < (off_t)
+      sizeof(cache_header))
+    {
+      close (fd);
+      return CACHE_STALE;
+    }
+
+  /* Privé: les pages ne sont jamais réécrites dans le fichier */
+  void *data = mmap (NULL, file_stat.st_size, PROT_READ | PROT_WRITE,
+		     MAP_PRIVATE, fd, 0);
+  close (fd);
+
+  if (data == MAP_FAILED)
+    return CACHE_STALE;
+
+  map->data = (char*) data;
+  map->size = file_stat.st_size;
+
+  const cache_header *header = (const cache_header*) data;
+
+  /* Ancien format, autre version ou autre machine */
+  if (memcmp (header->magic, CACHE_MAGIC, sizeof(header->magic))
+      || header->version != CACHE_VERSION
+      || header->endian != CACHE_ENDIAN)
+    {
+      cache_close (map);
+      return CACHE_STALE;
+    }
+
+  if (header->header_hash != header_hash (header)
+      || header->sections_count != CACHE_SECTIONS_COUNT
+      || header->file_size != map->size)
+    {
+      cache_close (map);
+      return CACHE_CORRUPT;
+    }
+
+  if (header->layout != layout)
+    {
+      cache_close (map);
+      return CACHE_STALE;
+    }
+
+  for (i = 0; i < CACHE_SECTIONS_COUNT; ++i)
+    {
+      const cache_section *section = header->sections + i;
+
+      if (section->offset % CACHE_ALIGN
+	  || section->offset > map->size
+	  || section->size > map->size - section->offset
+	  || cache_hash (map->data + section->offset, section->size, i)
+	  != section->hash)
+	{
+	  cache_close (map);
+	  return CACHE_CORRUPT;
+	}
+    }
+
+  return CACHE_VALID;
+}
+
+/*
+ * Lit la liste des segments et les clés des colonnes. Retourne 0 si elles
+ * ne correspondent pas aux autres sections.
+ */
+int cache_index_load (cache_index *index, const cache_map *map)
+{
+  cache_cursor cursor;
+  unsigned int scenarios_count = 0, iters_count, name_size;
+  const char  *name;
+  int ok, i;
+
+  cache_cursor_init (&cursor, map, CACHE_SCENARIOS);
+  ok = cache_cursor_read (&cursor, &scenarios_count, sizeof(unsigned int))
+    && scenarios_count <= cache_section_size (map, CACHE_SCENARIOS);
+  if (! ok)
+    scenarios_count = 0;
+
+  index->scenarios_count = scenarios_count;
+  index->names       = (const char**) malloc (sizeof(char*)
+					      * (scenarios_count + 1));
+  index->iters_count = (int*) malloc (sizeof(int) * (scenarios_count + 1));
+  index->first       = (int*) malloc (sizeof(int) * (scenarios_count + 1));
+  index->files_count = 0;
+
+  for (i = 0; i < (int) scenarios_count && ok; ++i)
+    {
+      name_size = 0;
+      ok = cache_cursor_read (&cursor, &iters_count, sizeof(unsigned int))
+	&& cache_cursor_read (&cursor, &name_size, sizeof(unsigned int))
+	&& name_size > 0
+	&& (name = cache_cursor_take (&cursor, name_size)) != NULL
+	&& name[name_size - 1] == '\0'
+	&& iters_count <= cache_section_size (map, CACHE_FILES);
+
+      if (ok)
+	{
+	  index->names[i]       = name;
+	  index->iters_count[i] = iters_count;
+	  index->first[i]       = index->files_count;
+	  index->files_count   += iters_count;
+	}
+    }
+
+  index->stamps = (const cache_stamp*) cache_section_data (map,
+							   CACHE_FILES);
+
+  ok = ok && cursor.pos == cursor.end
+    && cache_section_size (map, CACHE_FILES)
+    == sizeof(cache_stamp) * index->files_count;
+
+  /* Les clés de chaque groupe: leur nombre, puis les clés */
+  unsigned int columns_count;
+
+  cache_cursor_init (&cursor, map, CACHE_COLUMNS);
+  for (i = 0; i < CACHE_GROUPS; ++i)
+    {
+      columns_count = 0;
+      ok = ok && cache_cursor_read (&cursor, &columns_count,
+				    sizeof(unsigned int))
+	&& columns_count <= cache_section_size (map, CACHE_COLUMNS);
+      if (! ok)
+	columns_count = 0;
+
+      index->columns_count[i] = columns_count;
+      index->columns[i] = (uint64_t*) malloc (sizeof(uint64_t)
+					      * (columns_count + 1));
+      ok = ok && cache_cursor_read (&cursor, index->columns[i],
+				    sizeof(uint64_t) * columns_count);
+    }
+
+  return ok && cursor.pos == cursor.end;
+}
+
+/*
+ * Rang du segment du scénario 'name', ou -1.
+ */
+int cache_index_find (const cache_index *index, const char *name)
+{
+  for (int i = 0; i < index->scenarios_count; ++i)
+    if (! strcmp (index->names[i], name))
+      return i;
+  return -1;
+}
+
+/*
+ * Rang de la colonne 'key' dans le groupe 'group', ou -1.
+ */
+int cache_index_column (const cache_index *index, int group, uint64_t key)
+{
+  for (int i = 0; i < index->columns_count[group]; ++i)
+    if (index->columns[group][i] == key)
+      return i;
+  return -1;
+}
+
+void cache_index_free (cache_index *index)
+{
+  for (int i = 0; i < CACHE_GROUPS; ++i)
+    free (index->columns[i]);
+  free (index->names);
+  free (index->iters_count);
+  free (index->first);
+}
+
+void *cache_section_data (const cache_map *map, int section)
+{
+  return map->data + ((const cache_header*) map->data)
+    ->sections[section].offset;
+}
+
+size_t cache_section_size (const cache_map *map, int section)
+{
+  return ((const cache_header*) map->data)->sections[section].size;
+}
+
+void cache_cursor_init (cache_cursor *cur, const cache_map *map,
+			int section)
+{
+  cur->pos = (const char*) cache_section_data (map, section);
+  cur->end = cur->pos + cache_section_size (map, section);
+}
+
+/*
+ * Copie les prochains 'size' octets de la section, ou retourne 0 s'il en
+ * reste moins.
+ */
+int cache_cursor_read (cache_cursor *cur, void *dest, size_t size)
+{
+  if (size > (size_t) (cur->end - cur->pos))
+    return 0;
+
+  memcpy (dest, cur->pos, size);
+  cur->pos += size;
+  return 1;
+}
+
+/*
+ * Comme cache_cursor_read, mais sans copie: retourne un pointeur dans la
+ * section, ou NULL.
+ */
+const char *cache_cursor_take (cache_cursor *cur, size_t size)
+{
+  const char *data = cur->pos;
+
+  if (size > (size_t) (cur->end - cur->pos))
+    return NULL;
+
+  cur->pos += size;
+  return data;
+}
+
+void cache_close (cache_map *map)
+{
+  if (map->data != NULL)
+    munmap (map->data, map->size);
+  map->data = NULL;
+  map->size = 0;
+}
+
+/*
+ * Écrit l'en-tête puis chaque section (alignée) dans un fichier
+ * temporaire du même dossier, qui remplace ensuite l'ancien fichier.
+ * Retourne 0 si le fichier n'a pu être écrit.
+ */
+int cache_write (const char *path, uint32_t layout,
+		 const void **sections, const size_t *sizes)
+{
+  static const char padding [CACHE_ALIGN] = { 0 };
+  cache_header header;
+  uint64_t offset;
+  int i, ok;
+
+  memset (&header, 0, sizeof(header));
+  memcpy (header.magic, CACHE_MAGIC, sizeof(header.magic));
+  header.version        = CACHE_VERSION;
+  header.endian         = CACHE_ENDIAN;
+  header.layout         = layout;
+  header.sections_count = CACHE_SECTIONS_COUNT;
+
+  offset = sizeof(header);
+  for (i = 0; i < CACHE_SECTIONS_COUNT; ++i)
+    {
+      offset = (offset + CACHE_ALIGN - 1) / CACHE_ALIGN * CACHE_ALIGN;
+      header.sections[i].offset = offset;
+      header.sections[i].size   = sizes[i];
+      header.sections[i].hash   = cache_hash (sections[i], sizes[i], i);
+      offset += sizes[i];
+    }
+  header.file_size   = offset;
+  header.header_hash = header_hash (&header);
+
+  size_t tmp_size = strlen (path) + 32;
+  char  *tmp_path = (char*) malloc (tmp_size);
+  snprintf (tmp_path, tmp_size, "%s.tmp.%ld", path, (long) getpid ());
+
+  FILE *pBin = fopen (tmp_path, "wb");
+  if (pBin == NULL)
+    {
+      free (tmp_path);
+      return 0;
+    }
+
+  ok = fwrite (&header, sizeof(header), 1, pBin) == 1;
+  offset = sizeof(header);
+
+  for (i = 0; i < CACHE_SECTIONS_COUNT && ok; ++i)
+    {
+      ok = fwrite (padding, 1, header.sections[i].offset - offset, pBin)
+	== header.sections[i].offset - offset;
+      if (sizes[i])
+	ok = ok && fwrite (sections[i], sizes[i], 1, pBin) == 1;
+      offset = header.sections[i].offset + sizes[i];
+    }
+
+  /* Le contenu doit être sur disque avant que le nom ne change */
+  ok = ok && fflush (pBin) == 0 && fsync (fileno (pBin)) == 0;
+  ok = fclose (pBin) == 0 && ok;
+  ok = ok && rename (tmp_path, path) == 0;
+
+  if (! ok)
+    remove (tmp_path);
+
+  free (tmp_path);
+  return ok;
+}
@@ -0,0 +1,191 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Fichier '.aux' (version 4): les résultats du parsing, pour ne parser
+ * que les fichiers de résultats nouveaux ou modifiés, et n'évaluer que les
+ * expressions nouvelles ou modifiées.
+ *
+ * Le fichier commence par un en-tête de taille fixe: nombre magique,
+ * version, marqueur d'endianness, disposition des tenseurs, puis la
+ * position, la taille et le hash de chaque section. L'en-tête a lui aussi
+ * son hash.
+ *
+ * Les tenseurs sont rangés par segments: un par scénario, chacun avec son
+ * propre nombre d'itérations. L'empreinte de chaque fichier parsé (taille,
+ * date de modification, inode) est conservée: un fichier dont l'empreinte
+ * n'a pas changé est repris tel quel, les autres sont parsés à nouveau.
+ *
+ * Chaque colonne des tenseurs (variable, calcul, expression booléenne) a
+ * une clé: un hash de sa définition et des clés des colonnes dont elle
+ * dépend. Une colonne dont la clé est connue est reprise, peu importe son
+ * rang; seules les autres sont calculées.
+ *
+ * Les sections commencent toutes sur un multiple de CACHE_ALIGN octets:
+ * le fichier est projeté en mémoire (mmap) et les tenseurs de résultats
+ * sont utilisés sur place, sans copie.
+ *
+ * L'écriture se fait dans un fichier temporaire renommé une fois complet:
+ * un autre processus voit l'ancien fichier ou le nouveau, jamais un
+ * fichier à moitié écrit.
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CACHE_MAGIC   "ANALYSE"  /* 8 octets avec le NUL */
+#define CACHE_VERSION 4
+#define CACHE_ENDIAN  0x01020304
+#define CACHE_ALIGN   64
+
+/* Groupes de colonnes: les quatre tenseurs, puis les variables
+ * discrètes */
+#define CACHE_GROUPS 5
+
+/* Disposition des tenseurs de résultats */
+#define CACHE_LAYOUT_SCEN_ITER_VAR 1
+
+/* Les sections, dans l'ordre du fichier */
+enum cache_sections
+  {
+    CACHE_SCENARIOS, /* Nom et nombre d'itérations de chaque segment */
+    CACHE_FILES,     /* cache_stamp [scen][iter] */
+    CACHE_COLUMNS,   /* Clés des colonnes de chaque groupe */
+    CACHE_ACC,       /* double   [scen][iter][var] */
+    CACHE_BOOL,      /* unsigned [scen][iter][var] */
+    CACHE_LOC,       /* double   [scen][iter][calc] */
+    CACHE_C_BOOL,    /* unsigned [scen][iter][expr] */
+    CACHE_KEYS,      /* Clés des dictionnaires des variables discrètes */
+    CACHE_COUNTS,    /* Comptes des variables discrètes, par identifiant */
+    CACHE_SECTIONS_COUNT
+  };
+
+struct cache_section
+{
+  uint64_t      offset;
+  uint64_t      size;
+  uint64_t      hash;
+};
+
+struct cache_header
+{
+  char          magic [8];
+  uint32_t      version;
+  uint32_t      endian;
+  uint32_t      layout;
+  uint32_t      sections_count;
+  uint64_t      file_size;
+  cache_section sections [CACHE_SECTIONS_COUNT];
+  uint64_t      header_hash;
+};
+
+/* Empreinte d'un fichier de résultats (zéros s'il n'existe pas) */
+struct cache_stamp
+{
+  int64_t       size;
+  int64_t       mtime_sec;
+  int64_t       mtime_nsec;
+  int64_t       inode;
+};
+
+/* Fichier projeté en mémoire */
+struct cache_map
+{
+  char          *data;
+  size_t        size;
+};
+
+/* Résultats de cache_open */
+#define CACHE_CORRUPT -1
+#define CACHE_STALE    0
+#define CACHE_VALID    1
+
+/*
+ * Tampon qui grandit au besoin: sert à construire les empreintes et les
+ * sections qui ne sont pas déjà contiguës en mémoire.
+ */
+struct cache_buffer
+{
+  char          *data;
+  size_t        size;
+  size_t        capacity;
+};
+
+/* Les segments d'un fichier '.aux' */
+struct cache_index
+{
+  int           scenarios_count;
+  const char    **names;
+  int           *iters_count;
+  int           *first;       /* Rang du premier fichier du segment */
+  int           files_count;
+  const cache_stamp *stamps;  /* Dans le fichier projeté */
+
+  int           columns_count [CACHE_GROUPS];
+  uint64_t      *columns [CACHE_GROUPS];
+};
+
+/* Lecture bornée d'une section */
+struct cache_cursor
+{
+  const char    *pos;
+  const char    *end;
+};
+
+uint64_t  cache_hash          (const void *data, size_t size,
+			       uint64_t seed);
+
+void      cache_buffer_init   (cache_buffer *buf);
+
+void      cache_buffer_add    (cache_buffer *buf, const void *data,
+			       size_t size);
+
+void      cache_buffer_free   (cache_buffer *buf);
+
+void      cache_stamp_file    (cache_stamp *stamp, const char *path);
+
+int       cache_open          (cache_map *map, const char *path,
+			       uint32_t layout);
+
+int       cache_index_load    (cache_index *index, const cache_map *map);
+
+int       cache_index_find    (const cache_index *index, const char *name);
+
+int       cache_index_column  (const cache_index *index, int group,
+			       uint64_t key);
+
+void      cache_index_free    (cache_index *index);
+
+void      cache_cursor_init   (cache_cursor *cur, const cache_map *map,
+			       int section);
+
+int       cache_cursor_read   (cache_cursor *cur, void *dest, size_t size);
+
+const char *cache_cursor_take (cache_cursor *cur, size_t size);
+
+void     *cache_section_data  (const cache_map *map, int section);
+
+size_t    cache_section_size  (const cache_map *map, int section);
+
+void      cache_close         (cache_map *map);
+
+int       cache_write         (const char *path, uint32_t layout,
+			       const void **sections, const size_t *sizes);
+
+#endif /* CACHE_H */
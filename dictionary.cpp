@@ -0,0 +1,191 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <algorithm>
+#include "dictionary.h"
+#include "field.h"
+
+using namespace std;
+
+/*
+ * Trouve ou ajoute une valeur. Le verrou doit être détenu.
+ */
+static unsigned int intern_locked (dictionary *dict, const char *key,
+				   unsigned int length, double *num,
+				   const char **stored)
+{
+  string value (key, length);
+  unordered_map<string, unsigned int>::iterator it = dict->ids.find (value);
+  unsigned int id;
+
+  if (it != dict->ids.end ())
+    id = it->second;
+  else
+    {
+      if (dict->count == dict->capacity)
+	{
+	  dict->capacity = dict->capacity ? dict->capacity * 2 : 16;
+	  dict->keys = (char**) realloc (dict->keys, sizeof(char*)
+					 * dict->capacity);
+	  dict->nums = (double*) realloc (dict->nums, sizeof(double)
+					  * dict->capacity);
+	}
+
+      id = dict->count++;
+      dict->keys[id] = (char*) malloc (length + 1);
+      memcpy (dict->keys[id], key, length);
+      dict->keys[id][length] = '\0';
+      dict->nums[id] = parse_number (dict->keys[id]);
+      dict->ids[value] = id;
+    }
+
+  *num    = dict->nums[id];
+  *stored = dict->keys[id];
+  return id;
+}
+
+void dictionary_init (dictionary *dict)
+{
+  pthread_mutex_init (&dict->lock, NULL);
+  dict->keys     = NULL;
+  dict->nums     = NULL;
+  dict->count    = 0;
+  dict->capacity = 0;
+}
+
+void dictionary_free (dictionary *dict)
+{
+  for (unsigned int i = 0; i < dict->count; ++i)
+    free (dict->keys[i]);
+  free (dict->keys);
+  free (dict->nums);
+  dict->ids.clear ();
+  dict->keys     = NULL;
+  dict->nums     = NULL;
+  dict->count    = 0;
+  dict->capacity = 0;
+  pthread_mutex_destroy (&dict->lock);
+}
+
+/*
+ * Identifiant de la valeur 'key' (ajoutée au besoin).
+ */
+unsigned int dictionary_intern (dictionary *dict, const char *key,
+				unsigned int length, double *num)
+{
+  const char *stored;
+  unsigned int id;
+
+  pthread_mutex_lock (&dict->lock);
+  id = intern_locked (dict, key, length, num, &stored);
+  pthread_mutex_unlock (&dict->lock);
+
+  return id;
+}
+
+/*
+ * Copie des valeurs connues jusqu'ici (indexées par identifiant) et des
+ * identifiants triés selon l'ordre alphabétique des valeurs. Les deux
+ * tableaux sont à libérer par l'appelant. Retourne le nombre de valeurs.
+ */
+unsigned int dictionary_snapshot (dictionary *dict, const char ***keys,
+				  unsigned int **order)
+{
+  unsigned int count, i;
+
+  pthread_mutex_lock (&dict->lock);
+  count = dict->count;
+  *keys = (const char**) malloc (sizeof(char*) * (count + 1));
+  memcpy (*keys, dict->keys, sizeof(char*) * count);
+  pthread_mutex_unlock (&dict->lock);
+
+  *order = (unsigned int*) malloc (sizeof(unsigned int) * (count + 1));
+  for (i = 0; i < count; ++i)
+    (*order)[i] = i;
+
+  const char **sort_keys = *keys;
+  sort (*order, *order + count,
+	[sort_keys] (unsigned int a, unsigned int b)
+	{ return strcmp (sort_keys[a], sort_keys[b]) < 0; });
+
+  return count;
+}
+
+void dict_cache_init (dict_cache *cache, dictionary *dict)
+{
+  cache->dict    = dict;
+  cache->mask    = 63;
+  cache->count   = 0;
+  cache->entries = (dict_entry*) calloc (cache->mask + 1,
+					 sizeof(dict_entry));
+}
+
+void dict_cache_free (dict_cache *cache)
+{
+  free (cache->entries);
+}
+
+/*
+ * Valeur absente de la table du thread: la demander au dictionnaire
+ * partagé, puis l'ajouter à la table (agrandie au besoin).
+ */
+unsigned int dict_cache_insert (dict_cache *cache, const char *key,
+				unsigned int length, unsigned int hash,
+				double *num)
+{
+  dict_entry   entry;
+  dict_entry   *old_entries;
+  unsigned int old_size, i, v;
+
+  pthread_mutex_lock (&cache->dict->lock);
+  entry.id = intern_locked (cache->dict, key, length, &entry.num,
+			    &entry.key);
+  pthread_mutex_unlock (&cache->dict->lock);
+
+  entry.length = length;
+  entry.hash   = hash;
+
+  /* Garder la table à moitié vide au plus */
+  if (++cache->count * 2 > cache->mask + 1)
+    {
+      old_entries = cache->entries;
+      old_size    = cache->mask + 1;
+
+      cache->mask    = old_size * 2 - 1;
+      cache->entries = (dict_entry*) calloc (old_size * 2,
+					     sizeof(dict_entry));
+
+      for (i = 0; i < old_size; ++i)
+	{
+	  if (old_entries[i].key == NULL)
+	    continue;
+
+	  v = old_entries[i].hash & cache->mask;
+	  while (cache->entries[v].key != NULL)
+	    v = (v + 1) & cache->mask;
+	  cache->entries[v] = old_entries[i];
+	}
+      free (old_entries);
+    }
+
+  i = hash & cache->mask;
+  while (cache->entries[i].key != NULL)
+    i = (i + 1) & cache->mask;
+  cache->entries[i] = entry;
+
+  *num = entry.num;
+  return entry.id;
+}
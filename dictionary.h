@@ -0,0 +1,121 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Dictionnaires des variables discrètes: chaque valeur distincte d'une
+ * variable reçoit un petit identifiant entier, le même pour tous les
+ * threads. Les résultats peuvent ainsi être comptés dans de simples
+ * tableaux indexés par identifiant.
+ *
+ * Chaque thread garde aussi sa propre table des valeurs qu'il a déjà
+ * rencontrées (dict_cache), consultée sans verrou ni allocation. Le
+ * verrou du dictionnaire n'est pris que lorsqu'un thread voit une valeur
+ * pour la première fois.
+ */
+
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#include <pthread.h>
+#include <string.h>
+#include <unordered_map>
+#include <string>
+
+struct dictionary
+{
+  pthread_mutex_t lock;
+  std::unordered_map<std::string, unsigned int> ids;
+  char          **keys;     /* identifiant -> valeur */
+  double        *nums;      /* identifiant -> valeur numérique */
+  unsigned int  count;
+  unsigned int  capacity;
+};
+
+struct dict_entry
+{
+  const char    *key;       /* Pointe vers la valeur du dictionnaire */
+  unsigned int  length;
+  unsigned int  hash;
+  unsigned int  id;
+  double        num;
+};
+
+struct dict_cache
+{
+  dictionary    *dict;
+  dict_entry    *entries;
+  unsigned int  mask;
+  unsigned int  count;
+};
+
+void          dictionary_init     (dictionary *dict);
+
+void          dictionary_free     (dictionary *dict);
+
+unsigned int  dictionary_intern   (dictionary *dict, const char *key,
+				   unsigned int length, double *num);
+
+unsigned int  dictionary_snapshot (dictionary *dict, const char ***keys,
+				   unsigned int **order);
+
+void          dict_cache_init     (dict_cache *cache, dictionary *dict);
+
+void          dict_cache_free     (dict_cache *cache);
+
+unsigned int  dict_cache_insert   (dict_cache *cache, const char *key,
+				   unsigned int length, unsigned int hash,
+				   double *num);
+
+/*
+ * FNV-1a: suffisant pour quelques centaines de valeurs courtes.
+ */
+inline unsigned int dict_hash (const char *key, unsigned int length)
+{
+  unsigned int hash = 2166136261u;
+
+  while (length--)
+    {
+      hash ^= (unsigned char) *key++;
+      hash *= 16777619u;
+    }
+  return hash;
+}
+
+/*
+ * Identifiant de la valeur 'key' ('length' octets, sans NUL), et sa valeur
+ * numérique dans 'num'.
+ */
+inline unsigned int dict_cache_lookup (dict_cache *cache, const char *key,
+				       unsigned int length, double *num)
+{
+  unsigned int hash = dict_hash (key, length);
+  unsigned int i    = hash & cache->mask;
+  dict_entry   *entry;
+
+  while ((entry = cache->entries + i)->key != NULL)
+    {
+      if (entry->hash == hash && entry->length == length
+	  && ! memcmp (entry->key, key, length))
+	{
+	  *num = entry->num;
+	  return entry->id;
+	}
+      i = (i + 1) & cache->mask;
+    }
+
+  return dict_cache_insert (cache, key, length, hash, num);
+}
+
+#endif /* DICTIONARY_H */
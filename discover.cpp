@@ -0,0 +1,416 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <sched.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <atomic>
+#include "discover.h"
+#include "archive.h"
+
+#define PATH_SIZE 4096
+
+/*
+ * Ouvre le fichier 'name' du répertoire 'dir'. Un chemin trop long est
+ * traité comme un fichier absent (NULL).
+ */
+static FILE *open_in (const char *dir, const char *name)
+{
+  char path [PATH_SIZE];
+  int  length = snprintf (path, PATH_SIZE, "%s/%s", dir, name);
+
+  if (length < 0 || length >= PATH_SIZE)
+    return NULL;
+  return fopen (path, "r");
+}
+
+/*
+ * Quota de CPU (en processeurs) fixé dans le répertoire 'dir' d'un
+ * cgroup, ou 0 s'il n'y en a pas.
+ */
+static double cgroup_quota_dir (const char *dir, int v2)
+{
+  char   max [32];
+  double quota = 0, period = 0;
+  FILE   *f;
+
+  if (v2)
+    {
+      /* "max 100000" ou "quota période" */
+      if ((f = open_in (dir, "cpu.max")) == NULL)
+	return 0;
+      if (fscanf (f, "%31s %lf", max, &period) == 2
+	  && strcmp (max, "max"))
+	quota = atof (max);
+      fclose (f);
+    }
+  else
+    {
+      /* -1: pas de limite */
+      if ((f = open_in (dir, "cpu.cfs_quota_us")) == NULL)
+	return 0;
+      if (fscanf (f, "%lf", &quota) != 1)
+	quota = 0;
+      fclose (f);
+
+      if ((f = open_in (dir, "cpu.cfs_period_us")) == NULL)
+	return 0;
+      if (fscanf (f, "%lf", &period) != 1)
+	period = 0;
+      fclose (f);
+    }
+
+  return quota > 0 && period > 0 ? quota / period : 0;
+}
+
+/*
+ * Le plus petit quota du cgroup 'group' et de ses parents, sous le point
+ * de montage 'mount'.
+ */
+static double cgroup_quota_tree (const char *mount, const char *group,
+				 int v2)
+{
+  char   dir [PATH_SIZE];
+  char   *last;
+  double quota, min = 0;
+  size_t root = strlen (mount);
+
+  /* Chemin trop long: aucune limite */
+  int length = snprintf (dir, PATH_SIZE, "%s%s", mount, group);
+  if (length < 0 || length >= PATH_SIZE)
+    return 0;
+
+  for (;;)
+    {
+      quota = cgroup_quota_dir (dir, v2);
+      if (quota > 0 && (min == 0 || quota < min))
+	min = quota;
+
+      last = strrchr (dir, '/');
+      if (last == NULL || (size_t) (last - dir) < root)
+	break;
+      *last = '\0';
+    }
+
+  return min;
+}
+
+/*
+ * Quota de CPU du processus selon /proc/self/cgroup, ou 0 s'il n'y en a
+ * pas. Chaque ligne: "hiérarchie:contrôleurs:chemin" (v2: "0::chemin").
+ */
+static double cgroup_quota (void)
+{
+  FILE   *f = fopen ("/proc/self/cgroup", "r");
+  char   line [PATH_SIZE];
+  char   *controllers, *group, *token, *dump;
+  double quota, min = 0;
+  int    cpu;
+
+  if (f == NULL)
+    return 0;
+
+  while (fgets (line, PATH_SIZE, f) != NULL)
+    {
+      line[strcspn (line, "\n")] = '\0';
+      if ((controllers = strchr (line, ':')) == NULL
+	  || (group = strchr (++controllers, ':')) == NULL)
+	continue;
+      *group++ = '\0';
+      if (! strcmp (group, "/"))
+	group[0] = '\0';
+
+      if (! strncmp (line, "0:", 2) && ! *controllers)
+	quota = cgroup_quota_tree ("/sys/fs/cgroup", group, 1);
+      else
+	{
+	  for (cpu = 0, token = strtok_r (controllers, ",", &dump);
+	       token != NULL; token = strtok_r (NULL, ",", &dump))
+	    cpu = cpu || ! strcmp (token, "cpu");
+	  if (! cpu)
+	    continue;
+
+	  quota = cgroup_quota_tree ("/sys/fs/cgroup/cpu", group, 0);
+	  if (quota == 0)
+	    quota = cgroup_quota_tree ("/sys/fs/cgroup/cpu,cpuacct", group,
+				       0);
+	}
+
+      if (quota > 0 && (min == 0 || quota < min))
+	min = quota;
+    }
+
+  fclose (f);
+  return min;
+}
+
+int discover_threads (void)
+{
+  cpu_set_t set;
+  int count = 0;
+
+  if (! sched_getaffinity (0, sizeof(cpu_set_t), &set))
+    count = CPU_COUNT (&set);
+
+  /* Un quota de 1.5 processeur permet de garder 2 threads occupés */
+  double quota = cgroup_quota ();
+  if (quota > 0 && (count < 1 || ceil (quota) < count))
+    count = (int) ceil (quota);
+
+  return count < 1 ? 1 : count;
+}
+
+/*
+ * Mémoire disponible, en octets: ce qui peut être alloué sans que le
+ * système ne swappe (le cache des fichiers compte comme disponible).
+ */
+size_t discover_memory (void)
+{
+  char   line [256];
+  unsigned long long kb;
+  FILE   *f = fopen ("/proc/meminfo", "r");
+
+  if (f != NULL)
+    {
+      while (fgets (line, sizeof(line), f) != NULL)
+	if (sscanf (line, "MemAvailable: %llu kB", &kb) == 1)
+	  {
+	    fclose (f);
+	    return (size_t) kb * 1024;
+	  }
+      fclose (f);
+    }
+
+  /* Noyau trop ancien: la mémoire libre seulement */
+  return (size_t) sysconf (_SC_AVPHYS_PAGES) * sysconf (_SC_PAGESIZE);
+}
+
+/*
+ * La lecture des répertoires des scénarios, pris à tour de rôle par
+ * quelques threads.
+ */
+struct scan_args
+{
+  const char    *results_path;
+  const char    *index_path;
+  char          **names;
+  int           *iters;
+  int           scenarios_count;
+  std::atomic<int> next;
+};
+
+static int is_directory (const char *path, const struct dirent *entry)
+{
+  struct stat st;
+
+  if (entry->d_type == DT_DIR)
+    return 1;
+  if (entry->d_type != DT_UNKNOWN && entry->d_type != DT_LNK)
+    return 0;
+  return ! stat (path, &st) && S_ISDIR (st.st_mode);
+}
+
+static int compare_names (const void *elem1, const void *elem2)
+{
+  return strcmp (*(char* const*) elem1, *(char* const*) elem2);
+}
+
+/* Un fichier Results/S.tar: le scénario S archivé (archive.h) */
+static int is_archive (const char *path, const struct dirent *entry)
+{
+  size_t      length = strlen (entry->d_name);
+  struct stat st;
+
+  if (length <= 4 || strcmp (entry->d_name + length - 4, ".tar"))
+    return 0;
+  if (entry->d_type == DT_REG)
+    return 1;
+  if (entry->d_type != DT_UNKNOWN && entry->d_type != DT_LNK)
+    return 0;
+  return ! stat (path, &st) && S_ISREG (st.st_mode);
+}
+
+/* L'itération 'iter' est trouvée */
+static void found_iter (long iter, unsigned char **found, int *capacity,
+			int *count)
+{
+  int i = *capacity;
+
+  if (iter >= *capacity)
+    {
+      *capacity = iter + 1 > *capacity * 2 ? iter + 1 : *capacity * 2;
+      *found = (unsigned char*) realloc (*found, *capacity);
+      memset (*found + i, 0, *capacity - i);
+    }
+  (*found)[iter] = 1;
+  if (iter + 1 > *count)
+    *count = iter + 1;
+}
+
+/*
+ * Les itérations d'un scénario: les fichiers N_Output.gz (de son
+ * répertoire, sinon de son archive) doivent aller de 0 à la dernière
+ * sans trou, sinon le programme s'arrête.
+ */
+static int count_iters (const char *results_path, const char *index_path,
+			const char *name)
+{
+  char          path [PATH_SIZE];
+  char          *end;
+  unsigned char *found = NULL;
+  long          iter;
+  int           capacity = 0, count = 0, i;
+  struct dirent *entry;
+  DIR           *dir;
+  const archive *a;
+
+  snprintf (path, PATH_SIZE, "%s%s", results_path, name);
+  if ((dir = opendir (path)) != NULL)
+    {
+      while ((entry = readdir (dir)) != NULL)
+	{
+	  if (! isdigit ((unsigned char) entry->d_name[0]))
+	    continue;
+	  iter = strtol (entry->d_name, &end, 10);
+	  if (strcmp (end, "_Output.gz") || iter >= INT_MAX)
+	    continue;
+
+	  found_iter (iter, &found, &capacity, &count);
+	}
+      closedir (dir);
+    }
+  else if ((a = archive_mount (results_path, name, index_path)) != NULL)
+    {
+      for (i = 0; i < a->entries_count; ++i)
+	if (a->entries[i].kind == ARCHIVE_OUTPUT)
+	  found_iter (a->entries[i].iter, &found, &capacity, &count);
+    }
+  else
+    return 0;
+
+  for (i = 0; i < count; ++i)
+    if (! found[i])
+      {
+	printf("Fichier de résultats manquant: %s/%d_Output.gz\n", path,
+	       i);
+	exit(1);
+      }
+
+  free (found);
+  return count;
+}
+
+static void *scan_worker (void *ptr)
+{
+  scan_args *args = (scan_args*) ptr;
+  int s;
+
+  while ((s = args->next.fetch_add (1)) < args->scenarios_count)
+    args->iters[s] = count_iters (args->results_path, args->index_path,
+				  args->names[s]);
+
+  return NULL;
+}
+
+/*
+ * Les scénarios de 'results_path' (qui se termine par '/'), en ordre
+ * alphabétique, et leur nombre d'itérations. Un scénario archivé
+ * (S.tar) est monté, avec son index dans 'index_path'; s'il a aussi
+ * son répertoire, c'est le répertoire qui est lu. Retourne le nombre
+ * de scénarios.
+ */
+int discover_scenarios (const char *results_path, const char *index_path,
+			int threads_count, char ***names, int **iters)
+{
+  char          path [PATH_SIZE];
+  int           capacity = 16, t, s;
+  size_t        length;
+  struct dirent *entry;
+  DIR           *dir;
+  scan_args     args;
+
+  args.results_path    = results_path;
+  args.index_path      = index_path;
+  args.names           = (char**) malloc (sizeof(char*) * capacity);
+  args.scenarios_count = 0;
+  args.next            = 0;
+
+  if ((dir = opendir (results_path)) == NULL)
+    {
+      printf("Le répertoire de résultats est inexistant: %s\n",
+	     results_path);
+      exit(1);
+    }
+
+  while ((entry = readdir (dir)) != NULL)
+    {
+      if (entry->d_name[0] == '.')
+	continue;
+
+      snprintf (path, PATH_SIZE, "%s%s", results_path, entry->d_name);
+      length = strlen (entry->d_name);
+      if (is_archive (path, entry))
+	length -= 4;
+      else if (! is_directory (path, entry))
+	continue;
+
+      if (args.scenarios_count == capacity)
+	{
+	  capacity *= 2;
+	  args.names = (char**) realloc (args.names,
+					 sizeof(char*) * capacity);
+	}
+      args.names[args.scenarios_count++] = strndup (entry->d_name, length);
+    }
+  closedir (dir);
+
+  qsort (args.names, args.scenarios_count, sizeof(char*), compare_names);
+
+  /* Un scénario qui a son répertoire et son archive */
+  for (s = 0, t = 0; s < args.scenarios_count; ++s)
+    if (t && ! strcmp (args.names[t - 1], args.names[s]))
+      free (args.names[s]);
+    else
+      args.names[t++] = args.names[s];
+  args.scenarios_count = t;
+  args.iters = (int*) calloc (args.scenarios_count + 1, sizeof(int));
+
+  if (threads_count > args.scenarios_count)
+    threads_count = args.scenarios_count;
+  if (threads_count < 1)
+    threads_count = 1;
+
+  pthread_t *threads_array = (pthread_t*) malloc
+    (sizeof(pthread_t) * threads_count);
+
+  for (t = 0; t < threads_count; ++t)
+    pthread_create (threads_array + t, NULL, scan_worker, (void*) &args);
+  for (t = 0; t < threads_count; ++t)
+    pthread_join (threads_array[t], NULL);
+  free (threads_array);
+
+  *names = args.names;
+  *iters = args.iters;
+  return args.scenarios_count;
+}
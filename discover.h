@@ -0,0 +1,47 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Ce que le programme trouve lui-même, sans que le script de lancement
+ * ait à le lui passer en ligne de commande (et sans limite ARG_MAX):
+ *
+ * - les scénarios, sous-répertoires de Results/, et le nombre
+ *   d'itérations de chacun (fichiers N_Output.gz). Les répertoires des
+ *   scénarios sont lus en parallèle: sur un système de fichiers réseau,
+ *   c'est la latence de chaque lecture qui domine. Un scénario peut
+ *   aussi être une archive Results/S.tar (archive.h).
+ * - le nombre de threads par défaut: les processeurs permis au processus
+ *   (sched_getaffinity), limités par le quota de CPU de son cgroup
+ *   (v2: cpu.max, v1: cpu.cfs_quota_us / cpu.cfs_period_us). Un
+ *   conteneur ou une tâche de grappe ne voit souvent que quelques-uns
+ *   des processeurs de /proc/cpuinfo.
+ * - la mémoire disponible (MemAvailable de /proc/meminfo), pour choisir
+ *   comment décompresser les fichiers (inflate.h).
+ */
+
+#ifndef DISCOVER_H
+#define DISCOVER_H
+
+#include <stddef.h>
+
+int   discover_threads   (void);
+
+size_t discover_memory   (void);
+
+int   discover_scenarios (const char *results_path, const char *index_path,
+			  int threads_count, char ***names, int **iters);
+
+#endif /* DISCOVER_H */
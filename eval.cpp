@@ -252,3 +252,371 @@ void eval::strupr(char *s)
       s++;
     }
 }
+
+/*
+**  Compile an expression: same parsing as evaluate(), but the operations
+**  are recorded instead of being done, so that they can later be applied
+**  to any set of values with execute().
+*/
+
+int eval::compile(const char *line, eval_program *prog)
+{
+      size_t len = strlen(line);
+      char *str = (char *) malloc(len + 1), *ptr = str, *p;
+      char save;
+      double arg;
+      int ercode = SUCCESS, in_quotes = 0;
+      double sign;
+
+      /* Same as pack(), but names between quotes are left untouched */
+      for ( ; *line; ++line)
+      {
+            if ('"' == *line)
+                  in_quotes = !in_quotes;
+            else if (!in_quotes && isspace(*line))
+                  continue;
+            *ptr++ = in_quotes ? *line : toupper((unsigned char) *line);
+      }
+      *ptr = NUL;
+
+      prog->instrs = (eval_instr *) malloc(sizeof(eval_instr) * (len + 1));
+      prog->length = 0;
+      prog->vars_count = 0;
+      prog->depth = 0;
+
+      op_sptr = arg_sptr = parens = 0;
+      state = 0;
+      ptr = str;
+
+      while (*ptr && SUCCESS <= ercode)
+      {
+            if (op_sptr > 254 || arg_sptr > 254)
+            {
+                  ercode = ERROR;
+                  break;
+            }
+
+            switch (state)
+            {
+            case 0:
+                  sign = 1.0;
+                  if ('-' == *ptr && '"' == ptr[1])
+                  {
+                        sign = -1.0;
+                        ++ptr;
+                  }
+
+                  if ('"' == *ptr)
+                  {
+                        if (NULL == (p = strchr(ptr + 1, '"')))
+                        {
+                              ercode = ERROR;
+                              break;
+                        }
+                        emit(prog, PUSH_VAR, NUL, prog->vars_count++, sign);
+                        ++arg_sptr;
+                        ptr = p + 1;
+                        state = 1;
+                        break;
+                  }
+
+                  if ('(' == *ptr)
+                  {
+                        push_op(*ptr++);
+                        break;
+                  }
+
+                  if ('-' != *ptr && strchr(delims, *ptr))
+                  {
+                        ercode = ERROR;
+                        break;
+                  }
+
+                  for (p = ptr + 1; *p && '"' != *p; ++p)
+                  {
+                        if (strchr(delims, *p) && ('-' != *p || 'E' != p[-1]))
+                              break;
+                  }
+
+                  save = *p;
+                  *p = NUL;
+                  if (0.0 == (arg = strtod(ptr, NULL)) &&
+                        NULL == strchr(ptr, '0'))
+                  {
+                        ercode = ERROR;
+                        break;
+                  }
+                  *p = save;
+
+                  emit(prog, PUSH_CONST, NUL, 0, arg);
+                  ++arg_sptr;
+                  ptr = p;
+                  state = 1;
+                  break;
+
+            case 1:
+                  if (!strchr(delims, *ptr))
+                        ercode = ERROR;
+
+                  else if (')' == *ptr)
+                        ercode = compile_paren(prog);
+
+                  else
+                  {
+                        push_op(*ptr);
+                        state = 0;
+                  }
+                  ++ptr;
+                  break;
+            }
+      }
+
+      while (SUCCESS <= ercode && 1 < arg_sptr)
+            ercode = compile_op(prog);
+
+      if (SUCCESS <= ercode && (op_sptr || 1 != arg_sptr))
+            ercode = ERROR;
+
+      free(str);
+
+      if (SUCCESS > ercode)
+      {
+            free(prog->instrs);
+            prog->instrs = NULL;
+            prog->length = 0;
+            return ercode;
+      }
+
+      prog->instrs = (eval_instr *) realloc(prog->instrs,
+            sizeof(eval_instr) * prog->length);
+      return SUCCESS;
+}
+
+/*
+**  Record one stacked operation (see do_op)
+*/
+
+int eval::compile_op(eval_program *prog)
+{
+      int op;
+
+      if (ERROR == pop_op(&op))
+            return ERROR;
+
+      if ('(' != op)
+      {
+            if (NULL == strchr("+-*/^", op))
+                  return ERROR;
+
+            emit(prog, APPLY_OP, op, 0, 0.0);
+            --arg_sptr;
+      }
+
+      if (1 > arg_sptr)
+            return ERROR;
+      else  return op;
+}
+
+/*
+**  Record one level (see do_paren)
+*/
+
+int eval::compile_paren(eval_program *prog)
+{
+      int op;
+
+      if (1 > parens--)
+            return ERROR;
+      do
+      {
+            if (SUCCESS > (op = compile_op(prog)))
+                  break;
+      } while ('('!= op);
+      return op;
+}
+
+void eval::emit(eval_program *prog, char code, char op, int var,
+                double value)
+{
+      eval_instr *instr = prog->instrs + prog->length++;
+
+      instr->code  = code;
+      instr->op    = op;
+      instr->var   = var;
+      instr->value = value;
+
+      if (APPLY_OP != code && arg_sptr >= prog->depth)
+            prog->depth = arg_sptr + 1;
+}
+
+/*
+**  Apply a compiled expression to the values of its variables
+*/
+
+int eval::execute(const eval_program *prog, const double *vars, double *val)
+{
+      double stack[256], arg;
+      int sptr = 0;
+      const eval_instr *instr = prog->instrs,
+                       *end   = prog->instrs + prog->length;
+
+      for ( ; instr < end; ++instr)
+      {
+            switch (instr->code)
+            {
+            case PUSH_CONST:
+                  stack[sptr++] = instr->value;
+                  break;
+
+            case PUSH_VAR:
+                  stack[sptr++] = instr->value * vars[instr->var];
+                  break;
+
+            default:
+                  arg = stack[--sptr];
+
+                  switch (instr->op)
+                  {
+                  case '+':
+                        stack[sptr - 1] += arg;
+                        break;
+
+                  case '-':
+                        stack[sptr - 1] -= arg;
+                        break;
+
+                  case '*':
+                        stack[sptr - 1] *= arg;
+                        break;
+
+                  case '/':
+                        if (0.0 == arg)
+                              return R_ERROR;
+                        stack[sptr - 1] /= arg;
+                        break;
+
+                  case '^':
+                        if (0.0 > stack[sptr - 1])
+                              return R_ERROR;
+                        stack[sptr - 1] = pow(stack[sptr - 1], arg);
+                        break;
+                  }
+            }
+      }
+
+      *val = stack[0];
+      return SUCCESS;
+}
+
+/*
+**  Apply a compiled expression to whole columns of values: vars[n] holds
+**  the "count" values of the n-th variable. One pass is made per
+**  operation, so that every loop works on contiguous arrays. Range errors
+**  are flagged per element in "errors" (those values are meaningless).
+*/
+
+int eval::execute_columns(const eval_program *prog, const double * const *vars,
+                          int count, double *val, char *errors)
+{
+      const double **stack = (const double **)
+            malloc(sizeof(double *) * prog->depth);
+      double *scratch = (double *)
+            malloc(sizeof(double) * prog->depth * count);
+      const eval_instr *instr = prog->instrs,
+                       *end   = prog->instrs + prog->length;
+      const double *arg, *src;
+      double *dest, value;
+      int sptr = 0, i, status = SUCCESS;
+
+      memset(errors, 0, count);
+
+      for ( ; instr < end; ++instr)
+      {
+            dest = scratch + (size_t) sptr * count;
+
+            switch (instr->code)
+            {
+            case PUSH_CONST:
+                  value = instr->value;
+#pragma omp simd
+                  for (i = 0; i < count; ++i)
+                        dest[i] = value;
+                  stack[sptr++] = dest;
+                  break;
+
+            case PUSH_VAR:
+                  src = vars[instr->var];
+                  if (1.0 == instr->value)
+                        stack[sptr++] = src;
+                  else
+                  {
+                        value = instr->value;
+#pragma omp simd
+                        for (i = 0; i < count; ++i)
+                              dest[i] = value * src[i];
+                        stack[sptr++] = dest;
+                  }
+                  break;
+
+            default:
+                  arg  = stack[--sptr];
+                  src  = stack[sptr - 1];
+                  dest = scratch + (size_t) (sptr - 1) * count;
+
+                  switch (instr->op)
+                  {
+                  case '+':
+#pragma omp simd
+                        for (i = 0; i < count; ++i)
+                              dest[i] = src[i] + arg[i];
+                        break;
+
+                  case '-':
+#pragma omp simd
+                        for (i = 0; i < count; ++i)
+                              dest[i] = src[i] - arg[i];
+                        break;
+
+                  case '*':
+#pragma omp simd
+                        for (i = 0; i < count; ++i)
+                              dest[i] = src[i] * arg[i];
+                        break;
+
+                  case '/':
+#pragma omp simd
+                        for (i = 0; i < count; ++i)
+                              errors[i] |= (0.0 == arg[i]);
+#pragma omp simd
+                        for (i = 0; i < count; ++i)
+                              dest[i] = src[i] / arg[i];
+                        break;
+
+                  case '^':
+                        for (i = 0; i < count; ++i)
+                        {
+                              errors[i] |= (0.0 > src[i]);
+                              dest[i] = pow(src[i], arg[i]);
+                        }
+                        break;
+                  }
+                  stack[sptr - 1] = dest;
+            }
+      }
+
+      if (val != stack[0])
+            memcpy(val, stack[0], sizeof(double) * count);
+
+      for (i = 0; i < count; ++i)
+      {
+            if (errors[i])
+            {
+                  status = R_ERROR;
+                  break;
+            }
+      }
+
+      free(stack);
+      free(scratch);
+      return status;
+}
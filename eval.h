@@ -44,11 +44,44 @@ enum STATUS {R_ERROR = -2 /* range */, ERROR /* syntax */, SUCCESS};
 
 extern char delims[];   /* Tokens */
 
+/*
+ * Calculs compilés: l'expression est analysée une seule fois par
+ * eval::compile, qui simule les piles de l'évaluateur et produit la suite
+ * d'opérations qu'aurait effectuée eval::evaluate. Le résultat est donc
+ * le même (évaluation de droite à gauche, parenthèses, erreurs de champ),
+ * sans avoir à réécrire puis relire les valeurs sous forme de texte.
+ *
+ * Les variables sont délimitées par des guillemets anglais et numérotées
+ * selon leur ordre d'apparition dans l'expression.
+ */
+enum OPCODE {PUSH_CONST, PUSH_VAR, APPLY_OP};
+
+struct eval_instr
+{
+  char      code;   /* PUSH_CONST, PUSH_VAR ou APPLY_OP */
+  char      op;     /* Opérateur (APPLY_OP) */
+  int       var;    /* Numéro de la variable (PUSH_VAR) */
+  double    value;  /* Constante (PUSH_CONST) ou signe (PUSH_VAR) */
+};
+
+struct eval_program
+{
+  eval_instr *instrs;
+  int        length;
+  int        vars_count; /* Nombre de variables dans l'expression */
+  int        depth;      /* Profondeur maximale de la pile */
+};
+
 class eval
 {
  public:
   eval(): op_sptr(0), arg_sptr(0), parens(0) {}
   int evaluate(char *, double *);
+  int compile(const char *, eval_program *);
+
+  static int execute(const eval_program *, const double *, double *);
+  static int execute_columns(const eval_program *, const double * const *,
+                             int, double *, char *);
 
  private:
   void       strupr(char *s);
@@ -61,6 +94,9 @@ class eval
   char      *getexp(char *);
   char      *getop(char *);
   void       pack(char *);
+  int        compile_op(eval_program *);
+  int        compile_paren(eval_program *);
+  void       emit(eval_program *, char, char, int, double);
 
   char       op_stack[256];  /* Operator stack       */
   double     arg_stack[256]; /* Argument stack       */
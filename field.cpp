@@ -0,0 +1,39 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdlib.h>
+#include <locale.h>
+#include <pthread.h>
+#include "field.h"
+
+static locale_t       c_locale;
+static pthread_once_t c_locale_once = PTHREAD_ONCE_INIT;
+
+static void init_c_locale (void)
+{
+  c_locale = newlocale (LC_NUMERIC_MASK, "C", (locale_t) 0);
+}
+
+/*
+ * Tous les cas que parse_number ne traite pas lui-même (notation
+ * hexadécimale, inf/nan, espaces, beaucoup de chiffres, etc.), toujours
+ * dans la locale "C".
+ */
+double parse_number_slow (const char *field)
+{
+  pthread_once (&c_locale_once, init_c_locale);
+  return strtod_l (field, NULL, c_locale);
+}
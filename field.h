@@ -0,0 +1,138 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Décodage des champs des fichiers de résultats. Les nombres sont lus
+ * comme le ferait atof dans la locale "C", mais sans passer par la
+ * locale: les entiers et les décimaux courts (au plus 19 chiffres
+ * significatifs, exposant décimal d'au plus 22) sont convertis
+ * exactement avec une seule multiplication ou division, les autres cas
+ * sont confiés à strtod_l.
+ *
+ * Les champs doivent être terminés par un NUL, et au moins 4 octets
+ * doivent pouvoir être lus à partir du début du champ (voir reader.h).
+ */
+
+#ifndef FIELD_H
+#define FIELD_H
+
+#include <stdint.h>
+#include <string.h>
+
+double parse_number_slow (const char *field);
+
+/*
+ * Valeur numérique du champ, arrondie correctement.
+ */
+inline double parse_number (const char *field)
+{
+  static const double powers[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const char *p     = field;
+  uint64_t mantissa = 0;
+  int      digits   = 0; /* Chiffres significatifs */
+  int      seen     = 0; /* Au moins un chiffre */
+  int      exponent = 0;
+  int      negative = 0;
+  int      exp_value, exp_negative;
+  unsigned int d;
+  double   value;
+
+  if (*p == '-' || *p == '+')
+    negative = *p++ == '-';
+
+  for ( ; (d = (unsigned char) *p - '0') < 10; ++p, seen = 1)
+    {
+      if (mantissa || d)
+	{
+	  mantissa = mantissa * 10 + d;
+	  ++digits;
+	}
+    }
+
+  if (*p == '.')
+    {
+      for (++p; (d = (unsigned char) *p - '0') < 10; ++p, seen = 1)
+	{
+	  if (mantissa || d)
+	    {
+	      mantissa = mantissa * 10 + d;
+	      ++digits;
+	    }
+	  --exponent;
+	}
+    }
+
+  if (seen && (*p == 'e' || *p == 'E'))
+    {
+      ++p;
+      exp_negative = 0;
+      if (*p == '-' || *p == '+')
+	exp_negative = *p++ == '-';
+
+      if ((unsigned char) *p - '0' >= 10)
+	return parse_number_slow (field);
+
+      for (exp_value = 0; (d = (unsigned char) *p - '0') < 10; ++p)
+	if (exp_value < 10000)
+	  exp_value = exp_value * 10 + d;
+
+      exponent += exp_negative ? -exp_value : exp_value;
+    }
+
+  /* Hors du chemin rapide: autre chose qu'un nombre décimal simple,
+   * trop de chiffres, ou conversion qui ne serait pas exacte */
+  if (! seen || *p != '\0' || digits > 19
+      || mantissa > ((uint64_t) 1 << 53) || exponent < -22 || exponent > 22)
+    return parse_number_slow (field);
+
+  value = (double) mantissa;
+  if (exponent < 0)
+    value /= powers[-exponent];
+  else
+    value *= powers[exponent];
+
+  return negative ? -value : value;
+}
+
+/*
+ * Le champ commence par "true" (une seule lecture de 4 octets).
+ */
+inline int is_true (const char *field)
+{
+  uint32_t word, expected;
+
+  memcpy (&word, field, 4);
+  memcpy (&expected, "true", 4);
+  return word == expected;
+}
+
+/*
+ * Le champ commence par "false".
+ */
+inline int is_false (const char *field)
+{
+  uint32_t word, expected;
+
+  memcpy (&word, field, 4);
+  memcpy (&expected, "fals", 4);
+  return word == expected && field[4] == 'e';
+}
+
+#endif /* FIELD_H */
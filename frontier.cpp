@@ -0,0 +1,98 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdlib.h>
+#include <algorithm>
+#include "frontier.h"
+
+/*
+ * 'order': les rangs des scénarios, dans l'ordre de la frontière.
+ * 'status' et 'reference' sont donnés par position dans cet ordre:
+ * 'reference' est la position du scénario efficient qui précède (celui
+ * auquel le scénario est comparé), -1 pour le premier.
+ */
+void frontier_compute (const double *costs, const double *effects,
+		       int count, int *order, int *status, int *reference)
+{
+  int *hull = (int*) malloc (sizeof(int) * (count + 1));
+  int k, top, best, a, b;
+
+  for (k = 0; k < count; ++k)
+    order[k] = k;
+
+  std::sort (order, order + count, [costs, effects] (int x, int y)
+	     {
+	       if (costs[x] != costs[y])
+		 return costs[x] < costs[y];
+	       if (effects[x] != effects[y])
+		 return effects[x] > effects[y];
+	       return x < y;
+	     });
+
+  if (! count)
+    {
+      free (hull);
+      return;
+    }
+
+  /* Dominance forte: l'effet doit dépasser le meilleur effet des
+   * scénarios moins coûteux */
+  status[0] = FRONTIER_EFFICIENT;
+  for (k = 1, best = order[0]; k < count; ++k)
+    {
+      if (effects[order[k]] <= effects[best])
+	status[k] = FRONTIER_DOMINATED;
+      else
+	{
+	  status[k] = FRONTIER_EFFICIENT;
+	  best = order[k];
+	}
+    }
+
+  /* Dominance par extension: les ICER de la frontière doivent croître.
+   * Le sommet de la pile est retiré tant que son ICER dépasse celui du
+   * nouveau scénario (produits croisés: les effets sont croissants) */
+  hull[0] = 0;
+  for (k = 1, top = 0; k < count; ++k)
+    {
+      if (status[k] != FRONTIER_EFFICIENT)
+	continue;
+
+      while (top > 0)
+	{
+	  a = order[hull[top - 1]];
+	  b = order[hull[top]];
+
+	  if ((costs[b] - costs[a]) * (effects[order[k]] - effects[b])
+	      <= (costs[order[k]] - costs[b]) * (effects[b] - effects[a]))
+	    break;
+
+	  status[hull[top--]] = FRONTIER_EXTENDED;
+	}
+      hull[++top] = k;
+    }
+
+  /* Le scénario efficient qui précède chaque position */
+  reference[0] = -1;
+  for (k = 1, best = 0; k < count; ++k)
+    {
+      reference[k] = best;
+      if (status[k] == FRONTIER_EFFICIENT)
+	best = k;
+    }
+
+  free (hull);
+}
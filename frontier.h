@@ -0,0 +1,43 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Frontière d'efficience des ICER.
+ *
+ * Les scénarios sont ordonnés selon le comparateur (coût), puis selon
+ * l'effet décroissant et enfin selon leur rang: l'ordre est stable et
+ * deux scénarios de même coût ne sont jamais confondus. Un scénario est
+ * dominé (fortement) si un scénario qui le précède a un effet au moins
+ * aussi grand; il est dominé par extension si son ICER dépasse celui du
+ * scénario non dominé suivant. Tri, puis deux passes linéaires:
+ * O(S log S).
+ */
+
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+enum frontier_status
+  {
+    FRONTIER_EFFICIENT,  /* Sur la frontière */
+    FRONTIER_DOMINATED,  /* Dominance forte */
+    FRONTIER_EXTENDED    /* Dominance par extension */
+  };
+
+void  frontier_compute (const double *costs, const double *effects,
+			int count, int *order, int *status,
+			int *reference);
+
+#endif /* FRONTIER_H */
@@ -0,0 +1,546 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gzindex.h"
+
+static uint64_t header_hash (const gzindex_header *header,
+			     const gzindex_point *points)
+{
+  uint64_t hash = cache_hash (header, offsetof(gzindex_header,
+					       header_hash), 0);
+  return cache_hash (points, sizeof(gzindex_point) * header->points_count,
+		     hash);
+}
+
+/*
+ * Au moins 'count' octets compressés disponibles (sauf à la fin du
+ * fichier): le reste du tampon est ramené au début avant de lire.
+ */
+static int input_need (FILE *file, z_stream *strm, unsigned char *input,
+		       unsigned int count)
+{
+  size_t read;
+
+  if (strm->avail_in >= count)
+    return 1;
+
+  memmove (input, strm->next_in, strm->avail_in);
+  read = fread (input + strm->avail_in, 1, GZINDEX_INPUT - strm->avail_in,
+		file);
+  strm->next_in   = input;
+  strm->avail_in += read;
+  return strm->avail_in >= count;
+}
+
+/*
+ * Passe au membre gzip suivant (fichiers concaténés), s'il y en a un.
+ * Après un flux deflate brut, la fin du membre (CRC et taille) reste à
+ * sauter. Comme gzread, ce qui suit le dernier membre est ignoré.
+ */
+static int next_member (FILE *file, z_stream *strm, unsigned char *input,
+			int raw)
+{
+  if (raw)
+    {
+      if (! input_need (file, strm, input, 8))
+	return 0;
+      strm->next_in  += 8;
+      strm->avail_in -= 8;
+    }
+
+  if (! input_need (file, strm, input, 2) || strm->next_in[0] != 0x1f
+      || strm->next_in[1] != 0x8b)
+    return 0;
+
+  return inflateReset2 (strm, 31) == Z_OK;
+}
+
+/*
+ * Ouvre 'source' pour le décompresser en construisant son index, un
+ * point environ tous les 'span' octets de texte. Retourne 0 si le
+ * fichier ne peut être ouvert ou n'est pas un fichier gzip.
+ */
+int gzindex_begin (gzindex_builder *b, const char *source, uint64_t span)
+{
+  unsigned char magic [2];
+
+  b->file = fopen (source, "rb");
+  if (b->file == NULL)
+    return 0;
+
+  if (fread (magic, 1, 2, b->file) != 2 || magic[0] != 0x1f
+      || magic[1] != 0x8b)
+    {
+      fclose (b->file);
+      return 0;
+    }
+  rewind (b->file);
+
+  memset (&b->strm, 0, sizeof(z_stream));
+  if (inflateInit2 (&b->strm, 31) != Z_OK)
+    {
+      fclose (b->file);
+      return 0;
+    }
+
+  b->input        = (unsigned char*) malloc (GZINDEX_INPUT);
+  b->in           = 0;
+  b->out          = 0;
+  b->lines        = 0;
+  b->last         = 0;
+  b->span         = span;
+  b->points_count = 0;
+  b->unaligned    = -1;
+  b->previous     = '\n';
+  b->done         = 0;
+  b->error        = NULL;
+  cache_buffer_init (&b->points);
+  cache_buffer_init (&b->windows);
+
+  return 1;
+}
+
+/* Un point d'accès à la frontière de bloc deflate courante */
+static void add_point (gzindex_builder *b)
+{
+  unsigned char window [GZINDEX_WINDOW];
+  uInt          size = GZINDEX_WINDOW;
+  gzindex_point point;
+
+  if (inflateGetDictionary (&b->strm, window, &size) != Z_OK)
+    size = 0;
+
+  point.out           = b->out;
+  point.in            = b->in;
+  point.row           = b->previous == '\n' ? b->out : UINT64_MAX;
+  point.line          = b->lines;
+  point.window_offset = b->windows.size;
+  point.hash          = cache_hash (window, size, b->out);
+  point.window        = size;
+  point.bits          = b->strm.data_type & 7;
+
+  if (point.row == UINT64_MAX && b->unaligned < 0)
+    b->unaligned = b->points_count;
+
+  cache_buffer_add (&b->points, &point, sizeof(gzindex_point));
+  cache_buffer_add (&b->windows, window, size);
+  b->points_count++;
+  b->last = b->out;
+}
+
+/*
+ * Texte tout juste produit: les points qui attendaient le début d'une
+ * ligne le trouvent au premier saut de ligne (et en ont le numéro).
+ */
+static void track_output (gzindex_builder *b, const char *text,
+			  size_t length)
+{
+  const char    *newline;
+  gzindex_point *points = (gzindex_point*) b->points.data;
+  uint64_t      lines = 0;
+
+  if (! length)
+    return;
+
+  if (b->unaligned >= 0
+      && (newline = (const char*) memchr (text, '\n', length)) != NULL)
+    {
+      for (int k = b->unaligned; k < b->points_count; ++k)
+	{
+	  points[k].row  = b->out + (newline - text) + 1;
+	  points[k].line = b->lines + 1;
+	}
+      b->unaligned = -1;
+    }
+
+#pragma omp simd reduction(+:lines)
+  for (size_t k = 0; k < length; ++k)
+    lines += text[k] == '\n';
+
+  b->previous = text[length - 1];
+  b->out     += length;
+  b->lines   += lines;
+}
+
+/*
+ * Comme gzread: au plus 'size' octets de texte. Retourne le nombre
+ * d'octets produits, 0 à la fin du fichier ou -1 en cas d'erreur
+ * (b->error).
+ */
+long gzindex_inflate (gzindex_builder *b, char *buffer, size_t size)
+{
+  unsigned int before_in, before_out;
+  char         *start;
+  int          ret;
+
+  if (b->error != NULL)
+    return -1;
+
+  b->strm.next_out  = (Bytef*) buffer;
+  b->strm.avail_out = size;
+
+  while (b->strm.avail_out && ! b->done)
+    {
+      if (! b->strm.avail_in)
+	{
+	  b->strm.avail_in = fread (b->input, 1, GZINDEX_INPUT, b->file);
+	  b->strm.next_in  = b->input;
+	  if (! b->strm.avail_in)
+	    {
+	      b->error = ferror (b->file) ? "erreur de lecture"
+		: "fin de fichier inattendue";
+	      return -1;
+	    }
+	}
+
+      /* Z_BLOCK: rend la main à chaque frontière de bloc deflate */
+      before_in  = b->strm.avail_in;
+      before_out = b->strm.avail_out;
+      start      = (char*) b->strm.next_out;
+
+      ret = inflate (&b->strm, Z_BLOCK);
+
+      b->in += before_in - b->strm.avail_in;
+      track_output (b, start, before_out - b->strm.avail_out);
+
+      if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR
+	  || ret == Z_STREAM_ERROR)
+	{
+	  b->error = b->strm.msg != NULL ? b->strm.msg
+	    : "données corrompues";
+	  return -1;
+	}
+
+      if (ret == Z_STREAM_END)
+	{
+	  b->done = ! next_member (b->file, &b->strm, b->input, 0);
+	  continue;
+	}
+
+      /* Pas de point après le dernier bloc d'un membre: le suivant
+       * commence à un en-tête gzip */
+      if ((b->strm.data_type & 128) && ! (b->strm.data_type & 64)
+	  && (b->points_count == 0 || b->out - b->last >= b->span))
+	add_point (b);
+    }
+
+  return size - b->strm.avail_out;
+}
+
+/*
+ * Décompresse le reste du fichier (s'il n'a pas été lu jusqu'au bout),
+ * puis enregistre l'index dans 'path'. Retourne 0 en cas d'échec.
+ */
+int gzindex_save (gzindex_builder *b, const char *path,
+		  const cache_stamp *stamp)
+{
+  char           *scratch = (char*) malloc (GZINDEX_INPUT);
+  long           read;
+  gzindex_header header;
+  int            k, ok;
+
+  while ((read = gzindex_inflate (b, scratch, GZINDEX_INPUT)) > 0)
+    ;
+  free (scratch);
+
+  if (read < 0 || ! b->points_count)
+    return 0;
+
+  gzindex_point *points = (gzindex_point*) b->points.data;
+  uint64_t windows = (sizeof(header) + b->points.size + CACHE_ALIGN - 1)
+    / CACHE_ALIGN * CACHE_ALIGN;
+
+  for (k = 0; k < b->points_count; ++k)
+    {
+      if (points[k].row == UINT64_MAX)
+	{
+	  points[k].row  = b->out;
+	  points[k].line = b->lines;
+	}
+      points[k].window_offset += windows;
+    }
+
+  memset (&header, 0, sizeof(header));
+  memcpy (header.magic, GZINDEX_MAGIC, sizeof(header.magic));
+  header.version      = GZINDEX_VERSION;
+  header.endian       = CACHE_ENDIAN;
+  header.source       = *stamp;
+  header.text_size    = b->out;
+  header.span         = b->span;
+  header.points_count = b->points_count;
+  header.file_size    = windows + b->windows.size;
+  header.header_hash  = header_hash (&header, points);
+
+  /* Fichier temporaire renommé une fois complet. Pas de fsync: un index
+   * incomplet après une panne ne passe pas les hashs. */
+  static const char padding [CACHE_ALIGN] = { 0 };
+  size_t tmp_size = strlen (path) + 32;
+  char  *tmp_path = (char*) malloc (tmp_size);
+  snprintf (tmp_path, tmp_size, "%s.tmp.%ld", path, (long) getpid ());
+
+  FILE *pIndex = fopen (tmp_path, "wb");
+  ok = pIndex != NULL;
+
+  if (ok)
+    {
+      ok = fwrite (&header, sizeof(header), 1, pIndex) == 1
+	&& fwrite (points, b->points.size, 1, pIndex) == 1
+	&& fwrite (padding, 1, windows - sizeof(header) - b->points.size,
+		   pIndex) == windows - sizeof(header) - b->points.size
+	&& (! b->windows.size
+	    || fwrite (b->windows.data, b->windows.size, 1, pIndex) == 1);
+
+      ok = fclose (pIndex) == 0 && ok;
+      ok = ok && rename (tmp_path, path) == 0;
+      if (! ok)
+	remove (tmp_path);
+    }
+  free (tmp_path);
+
+  return ok;
+}
+
+void gzindex_end (gzindex_builder *b)
+{
+  inflateEnd (&b->strm);
+  fclose (b->file);
+  free (b->input);
+  cache_buffer_free (&b->points);
+  cache_buffer_free (&b->windows);
+}
+
+/*
+ * L'index 'path' existe et correspond encore au fichier d'origine (en-tête
+ * seulement: les hashs sont vérifiés par gzindex_open).
+ */
+int gzindex_current (const char *path, const cache_stamp *stamp)
+{
+  gzindex_header header;
+  struct stat file_stat;
+  int fd, ok;
+
+  fd = open (path, O_RDONLY);
+  if (fd < 0)
+    return 0;
+
+  ok = ! fstat (fd, &file_stat)
+    && pread (fd, &header, sizeof(header), 0) == sizeof(header)
+    && ! memcmp (header.magic, GZINDEX_MAGIC, sizeof(header.magic))
+    && header.version == GZINDEX_VERSION
+    && header.endian == CACHE_ENDIAN
+    && ! memcmp (&header.source, stamp, sizeof(cache_stamp))
+    && header.file_size == (uint64_t) file_stat.st_size;
+
+  close (fd);
+  return ok;
+}
+
+int gzindex_open (gzindex *ix, const char *path, const cache_stamp *stamp)
+{
+  struct stat file_stat;
+  int fd, ok;
+  uint32_t k;
+
+  ix->map.data = NULL;
+  ix->map.size = 0;
+
+  fd = open (path, O_RDONLY);
+  if (fd < 0)
+    return 0;
+
+  if (fstat (fd, &file_stat) || file_stat.st_size < (off_t)
+      sizeof(gzindex_header))
+    {
+      close (fd);
+      return 0;
+    }
+
+  void *data = mmap (NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd,
+		     0);
+  close (fd);
+
+  if (data == MAP_FAILED)
+    return 0;
+
+  ix->map.data = (char*) data;
+  ix->map.size = file_stat.st_size;
+  ix->header   = (const gzindex_header*) data;
+  ix->points   = (const gzindex_point*) (ix->header + 1);
+
+  const gzindex_header *header = ix->header;
+
+  ok = ! memcmp (header->magic, GZINDEX_MAGIC, sizeof(header->magic))
+    && header->version == GZINDEX_VERSION
+    && header->endian == CACHE_ENDIAN
+    && ! memcmp (&header->source, stamp, sizeof(cache_stamp))
+    && header->file_size == ix->map.size
+    && header->points_count > 0
+    && header->points_count <= (ix->map.size - sizeof(gzindex_header))
+    / sizeof(gzindex_point)
+    && header->header_hash == header_hash (header, ix->points);
+
+  /* Les points dans l'ordre du texte, et leurs dictionnaires dans le
+   * fichier (vérifiés par gzindex_seek) */
+  for (k = 0; k < header->points_count && ok; ++k)
+    {
+      const gzindex_point *point = ix->points + k;
+
+      ok = point->window <= GZINDEX_WINDOW && point->bits < 8
+	&& point->window_offset <= ix->map.size
+	&& point->window <= ix->map.size - point->window_offset
+	&& point->out <= point->row && point->row <= header->text_size
+	&& (k == 0 || (point->out > ix->points[k - 1].out
+		       && point->row >= ix->points[k - 1].row
+		       && point->line >= ix->points[k - 1].line));
+    }
+
+  if (! ok)
+    gzindex_close (ix);
+  return ok;
+}
+
+void gzindex_close (gzindex *ix)
+{
+  cache_close (&ix->map);
+}
+
+/*
+ * Prépare la lecture des lignes du point 'first' (à partir de sa première
+ * ligne) jusqu'à la première ligne du point 'last' (exclue), ou jusqu'à
+ * la fin du texte si 'last' est le nombre de points. Retourne 0 si la
+ * lecture ne peut commencer.
+ */
+int gzindex_seek (gzindex_cursor *cur, const gzindex *ix,
+		  const char *source, int first, int last)
+{
+  const gzindex_point *point = ix->points + first;
+  const unsigned char *window = (const unsigned char*) ix->map.data
+    + point->window_offset;
+  uint64_t end = last < (int) ix->header->points_count
+    ? ix->points[last].row : ix->header->text_size;
+  int byte;
+
+  if (cache_hash (window, point->window, point->out) != point->hash)
+    return 0;
+
+  cur->file = fopen (source, "rb");
+  if (cur->file == NULL)
+    return 0;
+
+  memset (&cur->strm, 0, sizeof(z_stream));
+  if (inflateInit2 (&cur->strm, -15) != Z_OK)
+    {
+      fclose (cur->file);
+      return 0;
+    }
+  cur->input = (unsigned char*) malloc (GZINDEX_INPUT);
+
+  /* Le bloc peut commencer au milieu d'un octet */
+  int ok = ! fseeko (cur->file, point->in - (point->bits ? 1 : 0),
+		     SEEK_SET);
+  if (ok && point->bits)
+    {
+      byte = getc (cur->file);
+      ok = byte != EOF && inflatePrime (&cur->strm, point->bits,
+					byte >> (8 - point->bits)) == Z_OK;
+    }
+  if (ok && point->window)
+    ok = inflateSetDictionary (&cur->strm, window, point->window) == Z_OK;
+
+  if (! ok)
+    {
+      gzindex_cursor_close (cur);
+      return 0;
+    }
+
+  cur->skip = point->row - point->out;
+  cur->left = end > point->row ? end - point->row : 0;
+  cur->raw  = 1;
+  cur->done = 0;
+  return 1;
+}
+
+/*
+ * Au plus 'size' octets de la tranche. Retourne le nombre d'octets
+ * produits, 0 à la fin de la tranche ou -1 en cas d'erreur.
+ */
+long gzindex_read (gzindex_cursor *cur, char *buffer, size_t size)
+{
+  size_t produced = 0, wanted, got, drop;
+  char   *start;
+  int    ret;
+
+  while (produced < size && cur->left && ! cur->done)
+    {
+      if (! cur->strm.avail_in)
+	{
+	  cur->strm.avail_in = fread (cur->input, 1, GZINDEX_INPUT,
+				      cur->file);
+	  cur->strm.next_in  = cur->input;
+	  if (! cur->strm.avail_in)
+	    return -1;
+	}
+
+      wanted = size - produced;
+      if (wanted > cur->skip + cur->left)
+	wanted = cur->skip + cur->left;
+
+      start = buffer + produced;
+      cur->strm.next_out  = (Bytef*) start;
+      cur->strm.avail_out = wanted;
+
+      ret = inflate (&cur->strm, Z_NO_FLUSH);
+      if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR
+	  || ret == Z_STREAM_ERROR)
+	return -1;
+
+      /* Le début de la première ligne */
+      got  = wanted - cur->strm.avail_out;
+      drop = got < cur->skip ? got : cur->skip;
+      if (drop)
+	{
+	  memmove (start, start + drop, got - drop);
+	  got       -= drop;
+	  cur->skip -= drop;
+	}
+
+      produced  += got;
+      cur->left -= got;
+
+      if (ret == Z_STREAM_END)
+	{
+	  cur->done = ! next_member (cur->file, &cur->strm, cur->input,
+				     cur->raw);
+	  cur->raw  = 0;
+	}
+    }
+
+  return produced;
+}
+
+void gzindex_cursor_close (gzindex_cursor *cur)
+{
+  inflateEnd (&cur->strm);
+  fclose (cur->file);
+  free (cur->input);
+}
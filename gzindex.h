@@ -0,0 +1,144 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Index d'accès aléatoire d'un fichier N_Output.gz (à la zran.c).
+ *
+ * Le gzip se décompresse d'un bout à l'autre: un gros fichier ne peut
+ * être lu que par un seul thread. L'index garde, environ tous les
+ * GZINDEX_SPAN octets de texte, un point d'accès: la position du bloc
+ * deflate dans le fichier compressé (à quelques bits près) et les 32 Ko
+ * de texte qui le précèdent (le dictionnaire). La décompression peut donc
+ * reprendre à n'importe quel point, indépendamment des autres. Chaque
+ * point a aussi le début de la première ligne complète qui le suit, et
+ * son numéro: les tranches entre deux points se découpent en lignes
+ * entières, dont on connaît les rangs sans les lire.
+ *
+ * L'index est construit pendant la lecture normale du fichier (un
+ * gzindex_builder remplace gzread), puis enregistré dans le répertoire
+ * Analyse/Index/ du projet. Comme un magasin de colonnes (store.h), son
+ * en-tête garde l'empreinte du fichier d'origine: un index dont
+ * l'empreinte ne correspond plus est ignoré puis refait.
+ */
+
+#ifndef GZINDEX_H
+#define GZINDEX_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <zlib.h>
+#include "cache.h"
+
+#define GZINDEX_MAGIC   "ANALIDX"  /* 8 octets avec le NUL */
+#define GZINDEX_VERSION 2
+#define GZINDEX_SPAN    (8 << 20)  /* Texte entre deux points (défaut) */
+#define GZINDEX_WINDOW  32768      /* Dictionnaire deflate */
+#define GZINDEX_INPUT   (128 * 1024)
+
+struct gzindex_point
+{
+  uint64_t      out;     /* Position dans le texte */
+  uint64_t      in;      /* Premier octet compressé entier du bloc */
+  uint64_t      row;     /* Début de la première ligne à partir de 'out'
+			  * (la taille du texte s'il n'y en a pas) */
+  uint64_t      line;    /* Sauts de ligne avant 'row' */
+  uint64_t      window_offset;
+  uint64_t      hash;    /* Du dictionnaire */
+  uint32_t      window;  /* Taille du dictionnaire */
+  uint32_t      bits;    /* Bits de l'octet qui précède 'in' encore à
+			  * décompresser (0 à 7) */
+};
+
+struct gzindex_header
+{
+  char          magic [8];
+  uint32_t      version;
+  uint32_t      endian;
+  cache_stamp   source;       /* Empreinte du fichier d'origine */
+  uint64_t      text_size;
+  uint64_t      span;
+  uint32_t      points_count;
+  uint32_t      reserved;
+  uint64_t      file_size;
+  uint64_t      header_hash;  /* En-tête, puis les points */
+};
+
+/* Index projeté en mémoire */
+struct gzindex
+{
+  cache_map     map;
+  const gzindex_header *header;
+  const gzindex_point  *points;
+};
+
+/* Décompression d'un fichier complet qui construit son index */
+struct gzindex_builder
+{
+  FILE          *file;
+  z_stream      strm;
+  unsigned char *input;
+  uint64_t      in;         /* Octets compressés consommés */
+  uint64_t      out;        /* Octets de texte produits */
+  uint64_t      lines;      /* Sauts de ligne produits */
+  uint64_t      last;       /* Position du dernier point */
+  uint64_t      span;
+  cache_buffer  points;
+  cache_buffer  windows;
+  int           points_count;
+  int           unaligned;  /* Premier point dont la ligne n'est pas
+			     * encore trouvée (-1: aucun) */
+  char          previous;   /* Dernier octet produit */
+  int           done;
+  const char    *error;
+};
+
+/* Décompression d'une tranche de lignes, à partir d'un point */
+struct gzindex_cursor
+{
+  FILE          *file;
+  z_stream      strm;
+  unsigned char *input;
+  uint64_t      skip;   /* Texte à sauter avant la première ligne */
+  uint64_t      left;   /* Texte de la tranche qui reste à produire */
+  int           raw;    /* Dans le membre gzip du point (sans en-tête) */
+  int           done;
+};
+
+int   gzindex_begin   (gzindex_builder *b, const char *source,
+		       uint64_t span);
+
+long  gzindex_inflate (gzindex_builder *b, char *buffer, size_t size);
+
+int   gzindex_save    (gzindex_builder *b, const char *path,
+		       const cache_stamp *stamp);
+
+void  gzindex_end     (gzindex_builder *b);
+
+int   gzindex_current (const char *path, const cache_stamp *stamp);
+
+int   gzindex_open    (gzindex *ix, const char *path,
+		       const cache_stamp *stamp);
+
+void  gzindex_close   (gzindex *ix);
+
+int   gzindex_seek    (gzindex_cursor *cur, const gzindex *ix,
+		       const char *source, int first, int last);
+
+long  gzindex_read    (gzindex_cursor *cur, char *buffer, size_t size);
+
+void  gzindex_cursor_close (gzindex_cursor *cur);
+
+#endif /* GZINDEX_H */
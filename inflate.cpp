@@ -0,0 +1,393 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef HAVE_LIBDEFLATE
+#include <sys/mman.h>
+#include <libdeflate.h>
+#endif
+#include "inflate.h"
+#include "discover.h"
+#include "archive.h"
+
+#define INFLATE_PIECE (1 << 30) /* Au plus par appel à gzread */
+#define INFLATE_INPUT (128 * 1024) /* Lectures d'un membre d'archive */
+
+/*
+ * La plus grande taille de texte à décompresser d'un coup, lorsque
+ * 'readers_count' fichiers sont lus en même temps: 0 pour toujours lire
+ * par blocs, INFLATE_ALWAYS pour toujours décompresser d'un coup.
+ */
+size_t inflate_limit (int backend, int readers_count)
+{
+  switch (backend)
+    {
+    case INFLATE_STREAM:
+      return 0;
+
+    case INFLATE_WHOLE:
+      return INFLATE_ALWAYS;
+    }
+
+#ifdef HAVE_LIBDEFLATE
+  /* La moitié de la mémoire disponible, partagée entre les lecteurs */
+  return discover_memory () / 2 / (readers_count > 0 ? readers_count : 1);
+#else
+  (void) readers_count;
+  return 0;
+#endif
+}
+
+#ifdef HAVE_LIBDEFLATE
+/*
+ * Décompresse d'un coup les membres gzip de 'data' dans f->text, de
+ * 'capacity' octets (doublé tant que le texte n'y tient pas). Comme
+ * gzread, ce qui suit le dernier membre est ignoré. Retourne 0, sans
+ * texte, si le tampon devait dépasser 'limit'.
+ */
+static int inflate_members (inflate_file *f, const unsigned char *data,
+			    size_t size, size_t capacity, size_t limit,
+			    size_t padding)
+{
+  libdeflate_decompressor *d = libdeflate_alloc_decompressor ();
+  libdeflate_result ret;
+  size_t in = 0, in_used, out_used;
+
+  f->text = (char*) malloc (capacity + padding);
+
+  if (d == NULL)
+    f->error = "mémoire insuffisante";
+
+  while (f->error == NULL)
+    {
+      ret = libdeflate_gzip_decompress_ex (d, data + in, size - in,
+					   f->text + f->length,
+					   capacity - f->length, &in_used,
+					   &out_used);
+
+      /* Le membre est repris au complet dans un tampon plus grand */
+      if (ret == LIBDEFLATE_INSUFFICIENT_SPACE)
+	{
+	  if (capacity > limit / 2)
+	    {
+	      free (f->text);
+	      f->text   = NULL;
+	      f->length = 0;
+	      break;
+	    }
+	  capacity *= 2;
+	  f->text = (char*) realloc (f->text, capacity + padding);
+	  continue;
+	}
+
+      if (ret != LIBDEFLATE_SUCCESS)
+	{
+	  f->error = "données corrompues";
+	  break;
+	}
+
+      in        += in_used;
+      f->length += out_used;
+
+      if (size - in < 2 || data[in] != 0x1f || data[in + 1] != 0x8b)
+	break;
+    }
+
+  if (d != NULL)
+    libdeflate_free_decompressor (d);
+  return f->text != NULL;
+}
+#endif
+
+/*
+ * Prépare la décompression continue de 'size' octets compressés, à
+ * partir de 'offset' dans 'fd' (lus par pread: le descripteur peut être
+ * partagé).
+ */
+static int range_begin (inflate_file *f, int fd, uint64_t offset,
+			uint64_t size)
+{
+  f->strm = (z_stream*) calloc (1, sizeof(z_stream));
+  if (inflateInit2 (f->strm, 31) != Z_OK)
+    {
+      free (f->strm);
+      f->strm = NULL;
+      return 0;
+    }
+
+  f->input = (unsigned char*) malloc (INFLATE_INPUT);
+  f->fd    = fd;
+  f->next  = offset;
+  f->end   = offset + size;
+  f->done  = 0;
+  return 1;
+}
+
+static void range_end (inflate_file *f)
+{
+  inflateEnd (f->strm);
+  free (f->strm);
+  free (f->input);
+  f->strm  = NULL;
+  f->input = NULL;
+}
+
+/*
+ * Au moins 'count' octets compressés disponibles (sauf à la fin de la
+ * plage): le reste du tampon est ramené au début avant de lire.
+ */
+static int range_need (inflate_file *f, unsigned int count)
+{
+  z_stream *strm = f->strm;
+  uint64_t wanted;
+  ssize_t  read = 0;
+
+  if (strm->avail_in >= count)
+    return 1;
+
+  if (strm->avail_in)
+    memmove (f->input, strm->next_in, strm->avail_in);
+
+  wanted = INFLATE_INPUT - strm->avail_in;
+  if (wanted > f->end - f->next)
+    wanted = f->end - f->next;
+  if (wanted)
+    read = pread (f->fd, f->input + strm->avail_in, wanted, f->next);
+
+  if (read > 0)
+    {
+      f->next        += read;
+      strm->avail_in += read;
+    }
+  strm->next_in = f->input;
+  return strm->avail_in >= count;
+}
+
+/*
+ * Comme gzread, pour une plage: les membres gzip se suivent, et ce qui
+ * suit le dernier est ignoré.
+ */
+static long range_read (inflate_file *f, char *buffer, size_t size)
+{
+  z_stream *strm = f->strm;
+  int      ret;
+
+  strm->next_out  = (Bytef*) buffer;
+  strm->avail_out = size;
+
+  while (strm->avail_out && ! f->done)
+    {
+      if (! strm->avail_in && ! range_need (f, 1))
+	{
+	  f->error = "fin de fichier inattendue";
+	  return -1;
+	}
+
+      ret = inflate (strm, Z_NO_FLUSH);
+      if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR
+	  || ret == Z_STREAM_ERROR)
+	{
+	  f->error = strm->msg != NULL ? strm->msg : "données corrompues";
+	  return -1;
+	}
+
+      if (ret == Z_STREAM_END)
+	f->done = ! range_need (f, 2) || strm->next_in[0] != 0x1f
+	  || strm->next_in[1] != 0x8b || inflateReset (strm) != Z_OK;
+    }
+
+  return size - strm->avail_out;
+}
+
+/*
+ * Décompresse d'un coup les 'size' octets à partir de 'offset' dans
+ * 'fd' (un fichier ou un membre d'archive), si c'est du gzip dont le
+ * texte ne dépasse pas 'limit'. La fin du fichier ne donne que la
+ * taille du dernier membre, modulo 2^32: le tampon grandit au besoin,
+ * et la lecture est abandonnée s'il devait dépasser 'limit'. Retourne 0
+ * si le fichier doit plutôt être lu par blocs. Une erreur de
+ * décompression est gardée dans f->error, pour inflate_read.
+ */
+static int open_whole (inflate_file *f, int fd, uint64_t offset,
+		       uint64_t size, size_t limit, size_t padding)
+{
+  unsigned char magic [2], trailer [4];
+  size_t        capacity;
+
+  /* Un fichier gzip a au moins un en-tête (10 octets) et une fin (8) */
+  if (size < 18 || pread (fd, magic, 2, offset) != 2 || magic[0] != 0x1f
+      || magic[1] != 0x8b
+      || pread (fd, trailer, 4, offset + size - 4) != 4)
+    return 0;
+
+  /* Taille du texte du dernier membre, modulo 2^32: au moins la taille
+   * du fichier compressé, sinon elle est estimée */
+  capacity = (size_t) trailer[0] | (size_t) trailer[1] << 8
+    | (size_t) trailer[2] << 16 | (size_t) trailer[3] << 24;
+  if (capacity < size)
+    capacity = size * 4;
+
+  if (capacity > limit)
+    return 0;
+
+#ifdef HAVE_LIBDEFLATE
+  /* La projection commence à une page */
+  uint64_t start = offset / sysconf (_SC_PAGESIZE) * sysconf (_SC_PAGESIZE);
+  void *data = mmap (NULL, size + offset - start, PROT_READ, MAP_PRIVATE,
+		     fd, start);
+
+  if (data == MAP_FAILED)
+    return 0;
+
+  madvise (data, size + offset - start, MADV_SEQUENTIAL);
+  int whole = inflate_members (f, (const unsigned char*) data
+			       + (offset - start), size, capacity, limit,
+			       padding);
+  munmap (data, size + offset - start);
+  if (! whole)
+    return 0;
+#else
+  long read;
+
+  if (! range_begin (f, fd, offset, size))
+    return 0;
+
+  f->text = (char*) malloc (capacity + padding);
+
+  do
+    {
+      if (f->length == capacity)
+	{
+	  if (capacity > limit / 2)
+	    {
+	      range_end (f);
+	      free (f->text);
+	      f->text   = NULL;
+	      f->length = 0;
+	      f->error  = NULL;
+	      return 0;
+	    }
+	  capacity *= 2;
+	  f->text = (char*) realloc (f->text, capacity + padding);
+	}
+
+      read = range_read (f, f->text + f->length,
+			 capacity - f->length < INFLATE_PIECE
+			 ? capacity - f->length : INFLATE_PIECE);
+      if (read > 0)
+	f->length += read;
+    }
+  while (read > 0);
+
+  range_end (f);
+#endif
+
+  /* Après le texte: le rembourrage demandé par le lecteur */
+  memset (f->text + f->length, 0, padding);
+  return 1;
+}
+
+/*
+ * Ouvre 'path' avec le moteur qui convient: d'un coup si son texte ne
+ * dépasse pas 'limit' (voir inflate_limit), sinon par blocs. Le texte
+ * décompressé d'un coup est suivi de 'padding' octets nuls. Un fichier
+ * d'un scénario archivé est lu dans l'archive. Retourne 0 si le fichier
+ * ne peut être ouvert.
+ */
+int inflate_open (inflate_file *f, const char *path, size_t limit,
+		  size_t padding)
+{
+  archive_member member;
+  struct stat    file_stat;
+  int            fd, ok;
+
+  f->file   = Z_NULL;
+  f->strm   = NULL;
+  f->input  = NULL;
+  f->text   = NULL;
+  f->length = 0;
+  f->taken  = 0;
+  f->error  = NULL;
+
+  if (archive_find (path, &member))
+    return (limit && open_whole (f, member.fd, member.offset, member.size,
+				 limit, padding))
+      || range_begin (f, member.fd, member.offset, member.size);
+
+  if (limit && (fd = open (path, O_RDONLY)) >= 0)
+    {
+      ok = ! fstat (fd, &file_stat)
+	&& open_whole (f, fd, 0, file_stat.st_size, limit, padding);
+      close (fd);
+      if (ok)
+	return 1;
+    }
+
+  f->file = gzopen (path, "rb");
+  if (f->file == Z_NULL)
+    return 0;
+
+  /* Tampon interne de zlib: les lectures du fichier compressé se font
+   * aussi par gros morceaux */
+  gzbuffer (f->file, 128 * 1024);
+  return 1;
+}
+
+/*
+ * Comme gzread: au plus 'size' octets de texte. Retourne le nombre
+ * d'octets produits, 0 à la fin du fichier ou -1 en cas d'erreur
+ * (f->error).
+ */
+long inflate_read (inflate_file *f, char *buffer, size_t size)
+{
+  long read;
+  int  errnum;
+
+  if (f->error != NULL)
+    return -1;
+
+  if (f->text != NULL)
+    {
+      read = size < f->length - f->taken ? size : f->length - f->taken;
+      memcpy (buffer, f->text + f->taken, read);
+      f->taken += read;
+      return read;
+    }
+
+  if (f->strm != NULL)
+    return range_read (f, buffer, size < INFLATE_PIECE ? size
+		       : INFLATE_PIECE);
+
+  read = gzread (f->file, buffer, size < INFLATE_PIECE ? size
+		 : INFLATE_PIECE);
+  if (read < 0)
+    f->error = gzerror (f->file, &errnum);
+  return read;
+}
+
+void inflate_close (inflate_file *f)
+{
+  if (f->text != NULL)
+    free (f->text);
+  else if (f->strm != NULL)
+    range_end (f);
+  else
+    gzclose (f->file);
+}
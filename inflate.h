@@ -0,0 +1,78 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Moteurs de décompression des fichiers de résultats (N_Output.gz,
+ * N_Summary.gz), derrière une même interface: inflate_open choisit le
+ * moteur de chaque fichier, inflate_read rend le texte par blocs comme
+ * gzread.
+ *
+ * - INFLATE_STREAM: zlib en continu (gzread), par blocs. La mémoire reste
+ *   bornée peu importe la taille du fichier.
+ * - INFLATE_WHOLE: le fichier compressé est projeté en mémoire puis
+ *   décompressé d'un coup dans un tampon de la taille du texte (donnée
+ *   par la fin du fichier gzip). Avec libdeflate (make LIBDEFLATE=1),
+ *   c'est 2 à 3 fois plus rapide que zlib; sans libdeflate, le texte est
+ *   lu par gzread dans ce même tampon. Un lecteur (reader.h) découpe
+ *   alors ses lignes directement dans le texte, sans copie.
+ *
+ * INFLATE_AUTO décompresse d'un coup les fichiers dont le texte tient
+ * dans la part de la mémoire disponible de chaque thread, et seulement
+ * avec libdeflate (zlib n'y gagne rien). Les fichiers qui ne sont pas en
+ * gzip sont toujours lus par gzread.
+ *
+ * Un membre d'une archive (archive.h) est lu de la même façon, mais par
+ * pread sur le descripteur de l'archive, partagé par tous les lecteurs:
+ * en continu avec inflate de zlib, ou d'un coup.
+ */
+
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zlib.h>
+
+enum inflate_backends {INFLATE_AUTO, INFLATE_STREAM, INFLATE_WHOLE};
+
+/* Limite de texte (inflate_open) qui force INFLATE_WHOLE */
+#define INFLATE_ALWAYS SIZE_MAX
+
+struct inflate_file
+{
+  gzFile        file;    /* INFLATE_STREAM */
+  z_stream      *strm;   /* INFLATE_STREAM, membre d'une archive */
+  unsigned char *input;
+  int           fd;
+  uint64_t      next;    /* Prochain octet compressé du membre */
+  uint64_t      end;
+  int           done;
+  char          *text;   /* INFLATE_WHOLE: tout le texte */
+  size_t        length;
+  size_t        taken;   /* Texte déjà rendu par inflate_read */
+  const char    *error;
+};
+
+size_t inflate_limit (int backend, int readers_count);
+
+int   inflate_open  (inflate_file *f, const char *path, size_t limit,
+		     size_t padding);
+
+long  inflate_read  (inflate_file *f, char *buffer, size_t size);
+
+void  inflate_close (inflate_file *f);
+
+#endif /* INFLATE_H */
@@ -1,8 +1,18 @@
 #!/bin/bash
 
+# Options passées telles quelles au programme C++ (--x=y)
+options=()
+while [[ $1 == --?* && $1 != "--help" ]]
+do
+    options+=("$1")
+    shift
+done
+
 if [ $# -lt 1 ]
 then
-    echo -e "\033[1mUsage:\033[0m `basename $0` répertoire-cible \
+    echo -e "\033[1mUsage:\033[0m `basename $0` \033[2m[--batch=N] \
+[--inflaters=N] [--inflate=auto|stream|whole] [--transcode] [--streaming] \
+[--readahead=K] [--prefetchers=N] [--bootstrap=N] [--seed=N] [--threads=N]\033[0m répertoire-cible \
 \033[2m[fichier-configuration]\033[0m"
     echo -e "\033[1mAide:\033[0m `basename $0` -? / -h / --help"
     exit 0
@@ -15,7 +25,6 @@ else
 fi
 
 main_dir=$1/
-dir_results=$1/Results/
 dir_analyse=$1/Analyse/
 
 if [ ! -d "${main_dir}" ]
@@ -47,71 +56,124 @@ fi
 
 recode dos..lat1 -q ${conf}
 
-uni=0
-for sub in "${main_dir}univariate"*
-do
-    if [ -d "${sub}" ]
-    then
-	$0 ${sub} ${conf}
-	uni=1
-    fi
-done
-
-if [ ! -d "${dir_results}" ]
-then
-    if (( uni )); then
-	exit 0
-    else
-	echo "Le répertoire de résulats est inexistant: ${dir_results}"
-	exit 1
-    fi
-fi
-
-mkdir -p ${dir_analyse} || exit 1
-
 resultats=$(basename ${conf})
 resultats=${resultats%"."*}.txt
 
-rm -f ${dir_analyse}${resultats} || exit 1
+# Prépare l'analyse du projet $1: répertoire Analyse et fichier de
+# résultats. Les scénarios, le nombre de simulations de chacun et le
+# nombre de threads sont trouvés par le programme C++.
+preparer()
+{
+    local projet=$1
 
-if (( $(find ${main_dir} -type f -name 'config-*.tar.gz' | wc -l) ))
-then
-    cd ${main_dir}
-    tarFile=$(ls -t config-*.tar.gz | head -1)
+    mkdir -p ${projet}Analyse || exit 1
+    rm -f ${projet}Analyse/${resultats} || exit 1
 
-    if [[ $(basename $(pwd)) = "univariate_"* ]]
+    if (( $(find ${projet} -type f -name 'config-*.tar.gz' | wc -l) ))
     then
-	nomUnivar=$(basename $(pwd))
-	nomUnivar=${nomUnivar:11:-3}
-	valUnivar=$(tar -zxOf ${tarFile} ./parameters_0.xml | pcregrep -M \
+	cd ${projet}
+	tarFile=$(ls -t config-*.tar.gz | head -1)
+
+	if [[ $(basename $(pwd)) = "univariate_"* ]]
+	then
+	    nomUnivar=$(basename $(pwd))
+	    nomUnivar=${nomUnivar:11:-3}
+	    valUnivar=$(tar -zxOf ${tarFile} ./parameters_0.xml | pcregrep -M \
 "${nomUnivar}.*\n.*value=\".*\"" | grep -oE "[0-9]+\.?[0-9]*")
 
-	echo -e "-!- Analyse univariée détectée -!-\nValeur actuelle de la \
+	    echo -e "-!- Analyse univariée détectée -!-\nValeur actuelle de la \
 variable '${nomUnivar}': ${valUnivar}\n" | tee Analyse/${resultats} || exit 1
-    else
-	tar -zxf ${tarFile} ./parameters.xml
-	mv -f parameters.xml Analyse
+	else
+	    tar -zxf ${tarFile} ./parameters.xml
+	    mv -f parameters.xml Analyse
+	fi
+	cd - > /dev/null
     fi
-    cd - > /dev/null
+}
+
+# Balayage univarié: tous les sous-projets (univariate*, et ceux qu'ils
+# contiennent) sont analysés par un seul programme C++ (--projects), dont
+# les threads se partagent les fichiers de tous les projets. Une ligne par
+# projet: répertoire et fichier de résultats.
+uni=0
+liste=$(mktemp)
+termines=$(mktemp)
+projets=()
+
+collecter()
+{
+    local sub
+
+    for sub in "$1univariate"*
+    do
+	if [ -d "${sub}" ]
+	then
+	    uni=1
+	    if [ -d "${sub}/Results/" ]
+	    then
+		preparer ${sub}/ > /dev/null
+		echo "${sub}/ ${sub}/Analyse/${resultats}" >> ${liste}
+		projets+=(${sub}/)
+	    elif ! compgen -G "${sub}/univariate*" > /dev/null
+	    then
+		echo "Le répertoire de résulats est inexistant: ${sub}/Results/"
+	    fi
+
+	    collecter ${sub}/
+	fi
+    done
+}
+
+# Les résultats d'un projet, dès qu'il est terminé
+afficher()
+{
+    cat $1Analyse/${resultats}
+    sed -i -e 's/$/\r/' $1Analyse/${resultats}
+    echo $1 >> ${termines}
+}
+
+collecter ${main_dir}
+
+if (( ${#projets[@]} ))
+then
+    Analyse "${options[@]}" --projects=${liste} ${conf} | while read -r ligne
+    do
+	case ${ligne} in
+	    "Projet terminé: "* | "Projet en erreur: "*)
+		afficher "${ligne#*: }" ;;
+	    *)
+		echo "${ligne}" ;;
+	esac
+    done
+
+    # Les projets que le programme n'a pas terminés
+    for projet in ${projets[@]}
+    do
+	if ! grep -qxF ${projet} ${termines}
+	then
+	    echo -e "Le programme C++ a été interrompu prématurément." \
+>> ${projet}Analyse/${resultats}
+	    afficher ${projet}
+	fi
+    done
 fi
+rm -f ${liste} ${termines}
 
-arrayScenarios=()
-for scenario in "${dir_results}"*
-do
-    if [ -d "${scenario}" ]
-    then
-	arrayScenarios+=(${scenario:${#dir_results}})
+if [ ! -d "${main_dir}Results/" ]
+then
+    if (( uni )); then
+	sed -i -e 's/$/\r/' ${conf}
+	exit 0
+    else
+	echo "Le répertoire de résulats est inexistant: ${main_dir}Results/"
+	exit 1
     fi
-done
-
-nbSims=$(find ${dir_results}${arrayScenarios[0]} -type f -name *_Output.gz \
-| wc -l)
+fi
 
-nbThreads=$(grep -c processor /proc/cpuinfo)
+preparer ${main_dir}
 
 {
-    Analyse ${main_dir} ${conf} ${nbSims} ${nbThreads} \
-${arrayScenarios[@]} || echo -e "Le programme C++ a été interrompu prématurément."
+    Analyse "${options[@]}" ${main_dir} ${conf} auto || echo -e "Le programme C++ a été interrompu prématurément."
 }   | tee -a ${dir_analyse}${resultats} || exit 1
 
 sed -i -e 's/$/\r/' ${dir_analyse}${resultats} ${conf}
@@ -122,4 +184,3 @@ then
 else
     exit 0
 fi
-
@@ -0,0 +1,316 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include <zlib.h>
+#include "pipeline.h"
+#include "reader.h"
+#include "inflate.h"
+#include "gzindex.h"
+
+/*
+ * Attente active courte, puis on cède le processeur, puis on dort: un
+ * thread qui attend longtemps (file pleine ou vide) ne doit pas voler le
+ * processeur à celui qu'il attend.
+ */
+void stream_wait (int *tries)
+{
+  static const struct timespec nap = {0, 50000};
+
+  if (++*tries < 64)
+    return;
+
+  if (*tries < 256)
+    sched_yield ();
+  else
+    nanosleep (&nap, NULL);
+}
+
+void stream_init (stream *st, int depth, size_t chunk_size)
+{
+  st->depth      = depth;
+  st->chunk_size = chunk_size;
+  st->slots      = (chunk*) malloc (sizeof(chunk) * depth);
+
+  for (int i = 0; i < depth; ++i)
+    {
+      st->slots[i].capacity = chunk_size;
+      st->slots[i].length   = 0;
+      st->slots[i].data     = (char*) calloc (chunk_size + 1
+					      + READER_PADDING, 1);
+    }
+
+  st->head  = 0;
+  st->tail  = 0;
+  st->state = STREAM_WAITING;
+  st->done  = 1;
+}
+
+/*
+ * Prépare le flux pour un nouveau fichier, et son index s'il doit être
+ * construit. Le fichier précédent doit avoir été entièrement produit
+ * (voir reader_close).
+ */
+void stream_reset (stream *st, const char *path, const char *index_path,
+		   const cache_stamp *stamp)
+{
+  st->path       = path;
+  st->index_path = index_path;
+  st->stamp      = stamp;
+  st->range      = NULL;
+  st->head.store (0, std::memory_order_relaxed);
+  st->tail.store (0, std::memory_order_relaxed);
+  st->state.store (STREAM_WAITING, std::memory_order_relaxed);
+  st->done.store (0, std::memory_order_release);
+}
+
+/*
+ * Comme stream_reset, pour ne lire que les lignes entre les points
+ * 'first' et 'last' de l'index 'ix'.
+ */
+void stream_reset_range (stream *st, const char *path, const gzindex *ix,
+			 int first, int last)
+{
+  stream_reset (st, path, NULL, NULL);
+  st->range = ix;
+  st->first = first;
+  st->last  = last;
+}
+
+void stream_free (stream *st)
+{
+  for (int i = 0; i < st->depth; ++i)
+    free (st->slots[i].data);
+  free (st->slots);
+}
+
+/*
+ * Décompresse un fichier dans son flux. La fin de chaque bloc qui ne
+ * forme pas une ligne complète est reportée au début du bloc suivant.
+ */
+static void inflate_stream (stream *st, size_t whole_limit)
+{
+  gzindex_builder index;
+  gzindex_cursor  range;
+  int          ranged = st->range != NULL
+    && gzindex_seek (&range, st->range, st->path, st->first, st->last);
+  int          indexing = st->index_path != NULL
+    && gzindex_begin (&index, st->path, GZINDEX_SPAN);
+  inflate_file input;
+  int          opened = ! indexing && st->range == NULL
+    && inflate_open (&input, st->path, whole_limit, 0);
+  char         *carry = NULL;
+  size_t       carry_length = 0, carry_capacity = 0, total;
+  unsigned long tail = 0;
+  chunk        *slot;
+  char         *last;
+  int          read, tries;
+
+  if (! indexing && ! ranged && ! opened)
+    {
+      st->state.store (STREAM_MISSING, std::memory_order_release);
+      st->done.store (1, std::memory_order_release);
+      return;
+    }
+
+  st->state.store (STREAM_OPEN, std::memory_order_release);
+
+  for (;;)
+    {
+      /* Contre-pression: attendre qu'un bloc soit libéré */
+      tries = 0;
+      while (tail - st->head.load (std::memory_order_acquire)
+	     >= (unsigned long) st->depth)
+	stream_wait (&tries);
+
+      slot = st->slots + tail % st->depth;
+
+      if (slot->capacity < carry_length + st->chunk_size)
+	{
+	  slot->capacity = carry_length + st->chunk_size;
+	  slot->data = (char*) realloc (slot->data, slot->capacity + 1
+					+ READER_PADDING);
+	}
+
+      memcpy (slot->data, carry, carry_length);
+      if (indexing)
+	{
+	  read = gzindex_inflate (&index, slot->data + carry_length,
+				  st->chunk_size);
+	  if (read < 0)
+	    {
+	      printf("Erreur de décompression (%s): %s\n", index.error,
+		     st->path);
+	      exit(1);
+	    }
+	}
+      else if (ranged)
+	{
+	  read = gzindex_read (&range, slot->data + carry_length,
+			       st->chunk_size);
+	  if (read < 0)
+	    {
+	      printf("Erreur de décompression (données corrompues): %s\n",
+		     st->path);
+	      exit(1);
+	    }
+	}
+      else
+	{
+	  read = inflate_read (&input, slot->data + carry_length,
+			       st->chunk_size);
+	  if (read < 0)
+	    {
+	      printf("Erreur de décompression (%s): %s\n", input.error,
+		     st->path);
+	      exit(1);
+	    }
+	}
+
+      total = carry_length + read;
+
+      /* Fin du fichier: la dernière ligne peut ne pas avoir de saut de
+       * ligne */
+      if (! read)
+	{
+	  if (total)
+	    {
+	      slot->length = total;
+	      st->tail.store (++tail, std::memory_order_release);
+	    }
+	  break;
+	}
+
+      last = (char*) memrchr (slot->data, '\n', total);
+
+      /* Une seule ligne plus longue que le bloc: continuer à la lire */
+      carry_length = last == NULL ? total : slot->data + total - last - 1;
+
+      if (carry_capacity < carry_length)
+	{
+	  carry_capacity = carry_length * 2;
+	  carry = (char*) realloc (carry, carry_capacity);
+	}
+      memcpy (carry, slot->data + total - carry_length, carry_length);
+
+      if (last != NULL)
+	{
+	  slot->length = total - carry_length;
+	  st->tail.store (++tail, std::memory_order_release);
+	}
+    }
+
+  /* Avant la fin du flux: les chemins appartiennent au consommateur */
+  if (indexing)
+    {
+      gzindex_save (&index, st->index_path, st->stamp);
+      gzindex_end (&index);
+    }
+  else if (ranged)
+    gzindex_cursor_close (&range);
+  else
+    inflate_close (&input);
+  free (carry);
+
+  /* Le consommateur peut réutiliser le flux dès ce moment */
+  st->done.store (1, std::memory_order_release);
+}
+
+/*
+ * Boucle d'un inflater: prendre le prochain fichier soumis.
+ */
+static void *inflater (void *ptr)
+{
+  pipeline *pl = (pipeline*) ptr;
+  stream   *st;
+
+  for (;;)
+    {
+      pthread_mutex_lock (&pl->lock);
+      while (! pl->count && ! pl->stop)
+	pthread_cond_wait (&pl->ready, &pl->lock);
+
+      if (! pl->count)
+	{
+	  pthread_mutex_unlock (&pl->lock);
+	  return NULL;
+	}
+
+      st = pl->queue[pl->first];
+      pl->first = (pl->first + 1) % pl->capacity;
+      pl->count--;
+      pthread_mutex_unlock (&pl->lock);
+
+      inflate_stream (st, pl->whole_limit);
+    }
+}
+
+/*
+ * Chaque évaluateur n'a qu'un fichier en cours à la fois: la file des
+ * fichiers en attente ne peut en contenir plus que le nombre
+ * d'évaluateurs.
+ */
+void pipeline_start (pipeline *pl, int inflaters_count,
+		     int evaluators_count, size_t whole_limit)
+{
+  pthread_mutex_init (&pl->lock, NULL);
+  pthread_cond_init (&pl->ready, NULL);
+
+  pl->capacity = evaluators_count;
+  pl->queue    = (stream**) malloc (sizeof(stream*) * evaluators_count);
+  pl->first    = 0;
+  pl->count    = 0;
+  pl->stop     = 0;
+
+  pl->whole_limit     = whole_limit;
+
+  pl->inflaters_count = inflaters_count;
+  pl->threads = (pthread_t*) malloc (sizeof(pthread_t) * inflaters_count);
+
+  for (int i = 0; i < inflaters_count; ++i)
+    pthread_create (pl->threads + i, NULL, inflater, (void*) pl);
+}
+
+void pipeline_submit (pipeline *pl, stream *st)
+{
+  pthread_mutex_lock (&pl->lock);
+  pl->queue[(pl->first + pl->count++) % pl->capacity] = st;
+  pthread_cond_signal (&pl->ready);
+  pthread_mutex_unlock (&pl->lock);
+}
+
+/*
+ * Termine les inflaters, une fois tous les fichiers soumis traités.
+ */
+void pipeline_stop (pipeline *pl)
+{
+  pthread_mutex_lock (&pl->lock);
+  pl->stop = 1;
+  pthread_cond_broadcast (&pl->ready);
+  pthread_mutex_unlock (&pl->lock);
+
+  for (int i = 0; i < pl->inflaters_count; ++i)
+    pthread_join (pl->threads[i], NULL);
+
+  free (pl->threads);
+  free (pl->queue);
+  pthread_mutex_destroy (&pl->lock);
+  pthread_cond_destroy (&pl->ready);
+}
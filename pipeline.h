@@ -0,0 +1,112 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Décompression en pipeline: des threads « inflaters » décompressent les
+ * fichiers pendant que les threads de parsing (évaluateurs) traitent les
+ * blocs déjà prêts.
+ *
+ * Chaque évaluateur possède un flux (stream) qu'il réutilise d'un fichier
+ * à l'autre: une file circulaire bornée de blocs décompressés, avec un
+ * seul producteur (l'inflater qui a pris le fichier) et un seul
+ * consommateur (l'évaluateur). La file n'utilise aucun verrou: deux
+ * compteurs atomiques (blocs produits, blocs consommés) suffisent, et un
+ * inflater attend lorsque la file est pleine (contre-pression). Les blocs
+ * se terminent toujours par une ligne complète.
+ *
+ * Seule la distribution des fichiers aux inflaters passe par un verrou,
+ * une fois par fichier. Un inflater peut aussi construire l'index d'accès
+ * du fichier (gzindex.h) pendant qu'il le décompresse, ou ne décompresser
+ * qu'une tranche du fichier à partir de cet index.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include <atomic>
+
+#define PIPELINE_DEPTH 4 /* Blocs décompressés en attente par flux */
+
+/* États d'un flux */
+enum {STREAM_WAITING, STREAM_OPEN, STREAM_MISSING};
+
+struct chunk
+{
+  char          *data;
+  size_t        length;
+  size_t        capacity;
+};
+
+struct cache_stamp;
+struct gzindex;
+
+struct stream
+{
+  const char    *path;
+  const char    *index_path; /* Index à construire (NULL: aucun) */
+  const cache_stamp *stamp;
+  const gzindex *range;      /* Index de la tranche à lire (NULL: tout
+			      * le fichier) */
+  int           first;       /* Points de la tranche (gzindex_seek) */
+  int           last;
+  chunk         *slots;
+  int           depth;
+  size_t        chunk_size;
+
+  std::atomic<unsigned long> head;  /* Blocs consommés */
+  std::atomic<unsigned long> tail;  /* Blocs produits */
+  std::atomic<int>           state;
+  std::atomic<int>           done;  /* Plus aucun bloc ne sera produit */
+};
+
+struct pipeline
+{
+  pthread_mutex_t lock;
+  pthread_cond_t  ready;
+  stream          **queue;     /* Fichiers en attente d'un inflater */
+  int             capacity;
+  int             first;
+  int             count;
+  int             stop;
+
+  pthread_t       *threads;
+  int             inflaters_count;
+  size_t          whole_limit;  /* Fichiers décompressés d'un coup
+				 * (inflate.h) */
+};
+
+void  pipeline_start  (pipeline *pl, int inflaters_count,
+		       int evaluators_count, size_t whole_limit);
+
+void  pipeline_submit (pipeline *pl, stream *st);
+
+void  pipeline_stop   (pipeline *pl);
+
+void  stream_init     (stream *st, int depth, size_t chunk_size);
+
+void  stream_reset    (stream *st, const char *path,
+		       const char *index_path, const cache_stamp *stamp);
+
+void  stream_reset_range (stream *st, const char *path,
+			  const gzindex *ix, int first, int last);
+
+void  stream_free     (stream *st);
+
+void  stream_wait     (int *tries);
+
+#endif /* PIPELINE_H */
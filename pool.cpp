@@ -0,0 +1,132 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdlib.h>
+#include "pool.h"
+
+static void *pool_loop (void *ptr)
+{
+  pool_worker *worker = (pool_worker*) ptr;
+  pool        *p      = worker->owner;
+  pool_job    *job, **link;
+
+  pthread_mutex_lock (&p->lock);
+  for (;;)
+    {
+      /* Le plus ancien travail que ce thread n'a pas encore fait */
+      for (job = p->jobs; job != NULL && job->taken[worker->id];
+	   job = job->next);
+
+      if (job == NULL)
+	{
+	  if (p->stop)
+	    break;
+	  pthread_cond_wait (&p->changed, &p->lock);
+	  continue;
+	}
+
+      job->taken[worker->id] = 1;
+      pthread_mutex_unlock (&p->lock);
+
+      job->run (job->args + worker->id * job->args_size);
+
+      pthread_mutex_lock (&p->lock);
+      if (++job->done == p->workers_count)
+	{
+	  for (link = &p->jobs; *link != job; link = &(*link)->next);
+	  *link = job->next;
+	  pthread_cond_broadcast (&p->changed);
+	}
+    }
+  pthread_mutex_unlock (&p->lock);
+
+  return NULL;
+}
+
+void pool_start (pool *p, int workers_count)
+{
+  p->workers_count = workers_count < 1 ? 1 : workers_count;
+  p->threads = (pthread_t*) malloc (sizeof(pthread_t) * p->workers_count);
+  p->workers = (pool_worker*) malloc (sizeof(pool_worker)
+				      * p->workers_count);
+  p->jobs    = NULL;
+  p->stop    = 0;
+
+  pthread_mutex_init (&p->lock, NULL);
+  pthread_cond_init (&p->changed, NULL);
+
+  for (int w = 0; w < p->workers_count; ++w)
+    {
+      p->workers[w].owner = p;
+      p->workers[w].id    = w;
+      pthread_create (p->threads + w, NULL, pool_loop,
+		      (void*) (p->workers + w));
+    }
+}
+
+/*
+ * 'args' contient les arguments des 'workers_count' threads, chacun de
+ * taille 'args_size'.
+ */
+void pool_submit (pool *p, pool_job *job, void *(*run) (void *),
+		  void *args, size_t args_size)
+{
+  pool_job **link;
+
+  job->run       = run;
+  job->args      = (char*) args;
+  job->args_size = args_size;
+  job->taken     = (char*) calloc (p->workers_count, 1);
+  job->done      = 0;
+  job->next      = NULL;
+
+  pthread_mutex_lock (&p->lock);
+  for (link = &p->jobs; *link != NULL; link = &(*link)->next);
+  *link = job;
+  pthread_cond_broadcast (&p->changed);
+  pthread_mutex_unlock (&p->lock);
+}
+
+/*
+ * Attend que tous les threads aient terminé le travail.
+ */
+void pool_wait (pool *p, pool_job *job)
+{
+  pthread_mutex_lock (&p->lock);
+  while (job->done < p->workers_count)
+    pthread_cond_wait (&p->changed, &p->lock);
+  pthread_mutex_unlock (&p->lock);
+
+  free (job->taken);
+}
+
+void pool_stop (pool *p)
+{
+  int w;
+
+  pthread_mutex_lock (&p->lock);
+  p->stop = 1;
+  pthread_cond_broadcast (&p->changed);
+  pthread_mutex_unlock (&p->lock);
+
+  for (w = 0; w < p->workers_count; ++w)
+    pthread_join (p->threads[w], NULL);
+
+  pthread_mutex_destroy (&p->lock);
+  pthread_cond_destroy (&p->changed);
+  free (p->threads);
+  free (p->workers);
+}
@@ -0,0 +1,73 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Threads de parsing partagés par plusieurs projets (--projects).
+ *
+ * Un travail soumis au pool est exécuté une fois par chaque thread, avec
+ * les arguments propres à ce thread: c'est la boucle de parsing d'un
+ * projet, qui prend ses tâches dans le scheduler du projet jusqu'à ce
+ * qu'il soit vide. Les travaux sont pris dans l'ordre de soumission: un
+ * thread qui ne trouve plus de fichiers dans un projet passe au projet
+ * suivant, pendant que les autres terminent le premier.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+struct pool_job
+{
+  void          *(*run) (void *);
+  char          *args;       /* Arguments de chaque thread, contigus */
+  size_t        args_size;
+  char          *taken;      /* Threads qui l'ont commencé */
+  int           done;        /* Threads qui l'ont terminé */
+  pool_job      *next;
+};
+
+struct pool;
+
+struct pool_worker
+{
+  pool          *owner;
+  int           id;
+};
+
+struct pool
+{
+  pthread_t     *threads;
+  pool_worker   *workers;
+  int           workers_count;
+
+  pthread_mutex_t lock;
+  pthread_cond_t  changed;
+  pool_job      *jobs;       /* Du plus ancien au plus récent */
+  int           stop;
+};
+
+void  pool_start  (pool *p, int workers_count);
+
+void  pool_submit (pool *p, pool_job *job, void *(*run) (void *),
+		   void *args, size_t args_size);
+
+void  pool_wait   (pool *p, pool_job *job);
+
+void  pool_stop   (pool *p);
+
+#endif /* POOL_H */
@@ -0,0 +1,153 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "prefetch.h"
+#include "store.h"
+#include "archive.h"
+
+/*
+ * Demande au noyau de charger une partie du fichier 'path' (tout le
+ * fichier si 'length' est 0), sans attendre la lecture. Un fichier d'un
+ * scénario archivé est chargé de son archive.
+ */
+static void advise (const char *path, long offset, long length)
+{
+  archive_member member;
+
+  if (archive_find (path, &member))
+    {
+      posix_fadvise (member.fd, member.offset + offset,
+		     length ? length : member.size - offset,
+		     POSIX_FADV_WILLNEED);
+      return;
+    }
+
+  int fd = open (path, O_RDONLY);
+
+  if (fd < 0)
+    return;
+
+  posix_fadvise (fd, offset, length, POSIX_FADV_WILLNEED);
+  close (fd);
+}
+
+/*
+ * Boucle d'un prefetcher: le magasin de colonnes s'il est à jour (c'est
+ * lui que le parsing lira), sinon le fichier texte.
+ */
+static void *prefetch_worker (void *ptr)
+{
+  prefetcher       *pf = (prefetcher*) ptr;
+  prefetch_request request;
+
+  for (;;)
+    {
+      pthread_mutex_lock (&pf->lock);
+      while (! pf->count && ! pf->stop)
+	pthread_cond_wait (&pf->ready, &pf->lock);
+
+      if (pf->stop)
+	{
+	  pthread_mutex_unlock (&pf->lock);
+	  return NULL;
+	}
+
+      request = pf->queue[pf->first];
+      pf->first = (pf->first + 1) % pf->capacity;
+      pf->count--;
+      pthread_mutex_unlock (&pf->lock);
+
+      if (request.store != NULL
+	  && store_current (request.store, request.stamp))
+	advise (request.store, 0, 0);
+      else
+	advise (request.path, request.offset, request.length);
+
+      free (request.path);
+      free (request.store);
+    }
+}
+
+void prefetch_start (prefetcher *pf, int threads_count, int capacity)
+{
+  pthread_mutex_init (&pf->lock, NULL);
+  pthread_cond_init (&pf->ready, NULL);
+
+  pf->capacity = capacity > 0 ? capacity : 1;
+  pf->queue    = (prefetch_request*) malloc (sizeof(prefetch_request)
+					     * pf->capacity);
+  pf->first    = 0;
+  pf->count    = 0;
+  pf->stop     = 0;
+
+  pf->threads_count = threads_count;
+  pf->threads = (pthread_t*) malloc (sizeof(pthread_t) * threads_count);
+
+  for (int i = 0; i < threads_count; ++i)
+    pthread_create (pf->threads + i, NULL, prefetch_worker, (void*) pf);
+}
+
+void prefetch_submit (prefetcher *pf, const char *path, const char *store,
+		      const cache_stamp *stamp, long offset, long length)
+{
+  prefetch_request *request;
+
+  pthread_mutex_lock (&pf->lock);
+
+  /* File pleine: les prefetchers sont déjà en retard, la demande est
+   * abandonnée */
+  if (pf->count < pf->capacity)
+    {
+      request = pf->queue + (pf->first + pf->count++) % pf->capacity;
+      request->path   = strdup (path);
+      request->store  = store != NULL ? strdup (store) : NULL;
+      request->stamp  = stamp;
+      request->offset = offset;
+      request->length = length;
+      pthread_cond_signal (&pf->ready);
+    }
+
+  pthread_mutex_unlock (&pf->lock);
+}
+
+/*
+ * Termine les prefetchers. Les demandes en attente sont abandonnées: le
+ * parsing est terminé.
+ */
+void prefetch_stop (prefetcher *pf)
+{
+  pthread_mutex_lock (&pf->lock);
+  pf->stop = 1;
+  pthread_cond_broadcast (&pf->ready);
+  pthread_mutex_unlock (&pf->lock);
+
+  for (int i = 0; i < pf->threads_count; ++i)
+    pthread_join (pf->threads[i], NULL);
+
+  for (int i = 0; i < pf->count; ++i)
+    {
+      free (pf->queue[(pf->first + i) % pf->capacity].path);
+      free (pf->queue[(pf->first + i) % pf->capacity].store);
+    }
+
+  free (pf->threads);
+  free (pf->queue);
+  pthread_mutex_destroy (&pf->lock);
+  pthread_cond_destroy (&pf->ready);
+}
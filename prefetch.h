@@ -0,0 +1,68 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Lecture anticipée des fichiers de résultats (--readahead), pour les
+ * systèmes de fichiers lents (NFS, Lustre): chaque thread de parsing
+ * signale les prochains fichiers de sa file (scheduler.h), et quelques
+ * threads « prefetchers » les ouvrent et demandent au noyau de les
+ * charger (posix_fadvise WILLNEED). La latence de l'ouverture et de la
+ * première lecture de chaque fichier est donc payée pendant le parsing
+ * des fichiers précédents.
+ *
+ * Le nombre de prefetchers est le nombre de requêtes d'entrée-sortie en
+ * cours, indépendamment du nombre de threads de parsing. Une demande
+ * n'est qu'un conseil: si la file est pleine, elle est abandonnée.
+ */
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <pthread.h>
+
+struct cache_stamp;
+
+struct prefetch_request
+{
+  char          *path;
+  char          *store;   /* Lu à la place de 'path' s'il est à jour
+			   * (NULL: aucun) */
+  const cache_stamp *stamp;
+  long          offset;   /* Partie de 'path' à lire (length 0: tout) */
+  long          length;
+};
+
+struct prefetcher
+{
+  pthread_mutex_t lock;
+  pthread_cond_t  ready;
+  prefetch_request *queue;
+  int             capacity;
+  int             first;
+  int             count;
+  int             stop;
+
+  pthread_t       *threads;
+  int             threads_count;
+};
+
+void  prefetch_start  (prefetcher *pf, int threads_count, int capacity);
+
+void  prefetch_submit (prefetcher *pf, const char *path, const char *store,
+		       const cache_stamp *stamp, long offset, long length);
+
+void  prefetch_stop   (prefetcher *pf);
+
+#endif /* PREFETCH_H */
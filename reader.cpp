@@ -0,0 +1,311 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "reader.h"
+#include "pipeline.h"
+#include "gzindex.h"
+
+/*
+ * Ouvre 'path', décompressé d'un coup si son texte ne dépasse pas
+ * 'whole_limit' (voir inflate_limit). Retourne 0 si le fichier ne peut
+ * être ouvert.
+ */
+int reader_open (reader *rd, const char *path, size_t block_size,
+		 size_t whole_limit)
+{
+  if (! inflate_open (&rd->input, path, whole_limit, 1 + READER_PADDING))
+    return 0;
+
+  rd->source   = NULL;
+  rd->index    = NULL;
+  rd->range    = NULL;
+  rd->path     = path;
+  rd->capacity = block_size;
+  rd->start    = 0;
+  rd->scanned  = 0;
+  rd->end      = 0;
+  rd->eof      = 0;
+
+  /* Tout le texte est déjà là: les lignes y sont prises sans copie */
+  if (rd->input.text != NULL && rd->input.error == NULL)
+    {
+      rd->buffer   = rd->input.text;
+      rd->capacity = rd->input.length;
+      rd->end      = rd->input.length;
+      rd->eof      = 1;
+    }
+  else
+    rd->buffer = (char*) calloc (block_size + 1 + READER_PADDING, 1);
+
+  return 1;
+}
+
+/*
+ * Comme reader_open, mais la décompression construit en même temps
+ * l'index d'accès du fichier: 'index' est enregistré (gzindex_save) puis
+ * libéré par l'appelant. Un fichier qui n'est pas en gzip est lu par
+ * blocs, sans index.
+ */
+int reader_open_index (reader *rd, const char *path, size_t block_size,
+		       gzindex_builder *index)
+{
+  if (! gzindex_begin (index, path, GZINDEX_SPAN))
+    return reader_open (rd, path, block_size, 0);
+
+  rd->input.text = NULL;
+  rd->source   = NULL;
+  rd->index    = index;
+  rd->range    = NULL;
+  rd->path     = path;
+  rd->capacity = block_size;
+  rd->buffer   = (char*) calloc (block_size + 1 + READER_PADDING, 1);
+  rd->start    = 0;
+  rd->scanned  = 0;
+  rd->end      = 0;
+  rd->eof      = 0;
+
+  return 1;
+}
+
+/*
+ * Comme reader_open, mais ne lit que les lignes entre les points 'first'
+ * et 'last' de l'index 'ix' (voir gzindex_seek), décompressées dans
+ * 'range'. Retourne 0 si la lecture ne peut commencer.
+ */
+int reader_open_range (reader *rd, const char *path, size_t block_size,
+		       gzindex_cursor *range, const gzindex *ix, int first,
+		       int last)
+{
+  if (! gzindex_seek (range, ix, path, first, last))
+    return 0;
+
+  rd->input.text = NULL;
+  rd->source   = NULL;
+  rd->index    = NULL;
+  rd->range    = range;
+  rd->path     = path;
+  rd->capacity = block_size;
+  rd->buffer   = (char*) calloc (block_size + 1 + READER_PADDING, 1);
+  rd->start    = 0;
+  rd->scanned  = 0;
+  rd->end      = 0;
+  rd->eof      = 0;
+  return 1;
+}
+
+/*
+ * Lit le fichier qu'un inflater décompresse dans 'source' (déjà soumis).
+ * Retourne 0 si le fichier ne peut être ouvert.
+ */
+int reader_attach (reader *rd, stream *source)
+{
+  int state, tries = 0;
+
+  while ((state = source->state.load (std::memory_order_acquire))
+	 == STREAM_WAITING)
+    stream_wait (&tries);
+
+  rd->source  = source;
+  rd->index   = NULL;
+  rd->range   = NULL;
+  rd->path    = source->path;
+  rd->taken   = 0;
+  rd->buffer  = NULL;
+  rd->start   = 0;
+  rd->scanned = 0;
+  rd->end     = 0;
+  rd->eof     = 0;
+
+  if (state == STREAM_MISSING)
+    {
+      /* Le flux est libre dès que l'inflater a terminé */
+      while (! source->done.load (std::memory_order_acquire))
+	stream_wait (&tries);
+      return 0;
+    }
+  return 1;
+}
+
+/*
+ * Passe au bloc suivant du flux, en libérant le bloc en cours. Retourne 0
+ * s'il n'y en a plus.
+ */
+static int next_chunk (reader *rd)
+{
+  stream *source = rd->source;
+  chunk  *slot;
+  int    tries = 0;
+
+  if (rd->buffer != NULL)
+    {
+      source->head.store (rd->taken, std::memory_order_release);
+      rd->buffer = NULL;
+    }
+
+  while (source->tail.load (std::memory_order_acquire) == rd->taken)
+    {
+      /* Le dernier bloc a pu être publié juste avant la fin */
+      if (source->done.load (std::memory_order_acquire)
+	  && source->tail.load (std::memory_order_acquire) == rd->taken)
+	return 0;
+      stream_wait (&tries);
+    }
+
+  slot = source->slots + rd->taken++ % source->depth;
+
+  rd->buffer  = slot->data;
+  rd->start   = 0;
+  rd->scanned = 0;
+  rd->end     = slot->length;
+  return 1;
+}
+
+/*
+ * La prochaine ligne (sans son saut de ligne), terminée par un NUL, et sa
+ * longueur. Retourne NULL à la fin du fichier.
+ */
+char *reader_next (reader *rd, size_t *length)
+{
+  char *row, *newline;
+  int  read;
+
+  for (;;)
+    {
+      newline = rd->scanned < rd->end ?
+	(char*) memchr (rd->buffer + rd->scanned, '\n',
+			rd->end - rd->scanned) : NULL;
+      if (newline != NULL)
+	{
+	  row      = rd->buffer + rd->start;
+	  *length  = newline - row;
+	  *newline = '\0';
+
+	  rd->start = rd->scanned = newline + 1 - rd->buffer;
+	  return row;
+	}
+
+      rd->scanned = rd->end;
+
+      /* Les blocs d'un flux finissent par une ligne complète, sauf
+       * peut-être le dernier */
+      if (rd->source != NULL)
+	{
+	  if (rd->start < rd->end)
+	    {
+	      row     = rd->buffer + rd->start;
+	      *length = rd->end - rd->start;
+	      row[*length] = '\0';
+
+	      rd->start = rd->end;
+	      return row;
+	    }
+
+	  if (! next_chunk (rd))
+	    return NULL;
+	  continue;
+	}
+
+      if (rd->eof)
+	{
+	  /* Dernière ligne sans saut de ligne */
+	  if (rd->start == rd->end)
+	    return NULL;
+
+	  row     = rd->buffer + rd->start;
+	  *length = rd->end - rd->start;
+	  row[*length] = '\0';
+
+	  rd->start = rd->end;
+	  return row;
+	}
+
+      /* Ligne incomplète: la ramener au début du tampon, ou agrandir le
+       * tampon si elle l'occupe déjà en entier */
+      if (rd->start > 0)
+	{
+	  memmove (rd->buffer, rd->buffer + rd->start, rd->end - rd->start);
+	  rd->end     -= rd->start;
+	  rd->scanned -= rd->start;
+	  rd->start    = 0;
+	}
+
+      if (rd->end == rd->capacity)
+	{
+	  rd->capacity *= 2;
+	  rd->buffer = (char*) realloc (rd->buffer, rd->capacity + 1
+					+ READER_PADDING);
+	}
+
+      if (rd->index != NULL)
+	{
+	  read = gzindex_inflate (rd->index, rd->buffer + rd->end,
+				  rd->capacity - rd->end);
+	  if (read < 0)
+	    {
+	      printf("Erreur de décompression (%s): %s\n",
+		     rd->index->error, rd->path);
+	      exit(1);
+	    }
+	}
+      else if (rd->range != NULL)
+	{
+	  read = gzindex_read (rd->range, rd->buffer + rd->end,
+			       rd->capacity - rd->end);
+	  if (read < 0)
+	    {
+	      printf("Erreur de décompression (données corrompues): %s\n",
+		     rd->path);
+	      exit(1);
+	    }
+	}
+      else
+	{
+	  read = inflate_read (&rd->input, rd->buffer + rd->end,
+			       rd->capacity - rd->end);
+	  if (read < 0)
+	    {
+	      printf("Erreur de décompression (%s): %s\n",
+		     rd->input.error, rd->path);
+	      exit(1);
+	    }
+	}
+
+      rd->eof  = ! read;
+      rd->end += read;
+    }
+}
+
+void reader_close (reader *rd)
+{
+  if (rd->source == NULL)
+    {
+      if (rd->buffer != rd->input.text)
+	free (rd->buffer);
+      if (rd->range != NULL)
+	gzindex_cursor_close (rd->range);
+      else if (rd->index == NULL)
+	inflate_close (&rd->input);
+      return;
+    }
+
+  /* Ignorer le reste du fichier: l'inflater doit pouvoir finir avant que
+   * le flux ne soit réutilisé */
+  while (next_chunk (rd))
+    ;
+}
@@ -0,0 +1,91 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Lecture des fichiers compressés par gros blocs: le moteur de
+ * décompression (inflate.h) produit le texte directement dans un tampon
+ * réutilisé, et les lignes sont trouvées avec memchr. Un fichier
+ * décompressé d'un coup sert lui-même de tampon. Chaque ligne est rendue
+ * sous la forme (pointeur, longueur) dans le tampon lui-même, sans copie:
+ * le saut de ligne est remplacé par un NUL. Une ligne n'est valide que
+ * jusqu'au prochain appel à reader_next.
+ *
+ * Une ligne à cheval sur deux blocs est ramenée au début du tampon avant
+ * la lecture suivante; le tampon grandit si une ligne ne tient pas dans
+ * un bloc. Il n'y a donc aucune limite à la longueur d'une ligne.
+ *
+ * Un lecteur peut aussi lire les blocs qu'un inflater produit dans un
+ * flux (voir pipeline.h) plutôt que décompresser lui-même: reader_attach
+ * remplace alors reader_open. Avec reader_open_index, le lecteur
+ * décompresse en construisant l'index d'accès du fichier (gzindex.h);
+ * avec reader_open_range, il ne lit que les lignes entre deux points de
+ * cet index.
+ */
+
+#ifndef READER_H
+#define READER_H
+
+#include <stddef.h>
+#include "inflate.h"
+
+#ifndef READER_BLOCK
+#define READER_BLOCK (1 << 20) /* Taille d'un bloc décompressé (défaut) */
+#endif
+
+#define READER_PADDING 4 /* Octets lisibles après le NUL final du tampon:
+			  * un champ peut être lu par mots de 4 octets */
+
+struct stream;
+struct gzindex_builder;
+struct gzindex_cursor;
+struct gzindex;
+
+struct reader
+{
+  inflate_file input;
+  stream      *source;  /* Flux lu, ou NULL si le lecteur décompresse */
+  gzindex_builder *index; /* Décompression qui construit l'index (NULL:
+			   * 'input') */
+  gzindex_cursor *range; /* Tranche lue à partir de l'index (NULL: tout
+			  * le fichier) */
+  unsigned long taken;  /* Blocs du flux déjà pris */
+  const char  *path;
+  char        *buffer;
+  size_t      capacity; /* Taille du tampon (sans le NUL final et le
+			 * rembourrage) */
+  size_t      start;    /* Début de la prochaine ligne */
+  size_t      scanned;  /* Fin de la zone déjà parcourue par memchr */
+  size_t      end;      /* Fin des données décompressées */
+  int         eof;
+};
+
+int   reader_open  (reader *rd, const char *path, size_t block_size,
+		    size_t whole_limit);
+
+int   reader_open_index (reader *rd, const char *path, size_t block_size,
+			 gzindex_builder *index);
+
+int   reader_open_range (reader *rd, const char *path, size_t block_size,
+			 gzindex_cursor *range, const gzindex *ix, int first,
+			 int last);
+
+int   reader_attach (reader *rd, stream *source);
+
+char  *reader_next (reader *rd, size_t *length);
+
+void  reader_close (reader *rd);
+
+#endif /* READER_H */
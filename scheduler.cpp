@@ -0,0 +1,190 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdlib.h>
+#include "scheduler.h"
+
+/*
+ * Plus gros fichier d'abord; ordre des scénarios et itérations ensuite,
+ * pour une distribution qui ne dépend que des fichiers.
+ */
+static int compare_tasks (const void *elem1, const void *elem2)
+{
+  const task *t1 = (const task*) elem1;
+  const task *t2 = (const task*) elem2;
+
+  if (t1->size != t2->size)
+    return t1->size < t2->size ? 1 : -1;
+  if (t1->scen != t2->scen)
+    return t1->scen - t2->scen;
+  if (t1->iter != t2->iter)
+    return t1->iter - t2->iter;
+  return t1->chunk - t2->chunk;
+}
+
+/*
+ * Par inode, puis les tranches d'un même fichier dans l'ordre.
+ */
+static int compare_inodes (const void *elem1, const void *elem2)
+{
+  const task *t1 = (const task*) elem1;
+  const task *t2 = (const task*) elem2;
+
+  if (t1->inode != t2->inode)
+    return t1->inode < t2->inode ? -1 : 1;
+  if (t1->scen != t2->scen)
+    return t1->scen - t2->scen;
+  if (t1->iter != t2->iter)
+    return t1->iter - t2->iter;
+  return t1->chunk - t2->chunk;
+}
+
+void scheduler_init (scheduler *sc, int workers_count, task *tasks,
+		     int tasks_count, int scenarios_count, int order)
+{
+  int i, w;
+
+  qsort (tasks, tasks_count, sizeof(task),
+	 order == SCHEDULE_INODE ? compare_inodes : compare_tasks);
+
+  sc->workers_count = workers_count;
+  sc->deques = (task_deque*) malloc (sizeof(task_deque) * workers_count);
+
+  for (w = 0; w < workers_count; ++w)
+    {
+      pthread_mutex_init (&sc->deques[w].lock, NULL);
+      sc->deques[w].tasks = (task*) malloc
+	(sizeof(task) * (tasks_count / workers_count + 1));
+      sc->deques[w].head = 0;
+      sc->deques[w].tail = 0;
+    }
+
+  /* À tour de rôle: chaque file reste triée */
+  for (i = 0; i < tasks_count; ++i)
+    {
+      w = i % workers_count;
+      sc->deques[w].tasks[sc->deques[w].tail++] = tasks[i];
+    }
+
+  pthread_mutex_init (&sc->lock, NULL);
+  pthread_cond_init (&sc->finished, NULL);
+  sc->pending         = (int*) calloc (scenarios_count + 1, sizeof(int));
+  sc->scenarios_count = scenarios_count;
+  sc->printed         = 0;
+
+  /* Les itérations sans tâche (reprises de la cache) sont déjà faites:
+   * le nombre d'itérations peut varier d'un scénario à l'autre */
+  for (i = 0; i < tasks_count; ++i)
+    sc->pending[tasks[i].scen]++;
+}
+
+/*
+ * Prochaine tâche du thread 'worker'. Retourne 0 s'il n'en reste aucune.
+ */
+int scheduler_next (scheduler *sc, int worker, task *next)
+{
+  task_deque *deque = sc->deques + worker;
+  int found = 0, w;
+
+  pthread_mutex_lock (&deque->lock);
+  if (deque->head < deque->tail)
+    {
+      *next = deque->tasks[deque->head++];
+      found = 1;
+    }
+  pthread_mutex_unlock (&deque->lock);
+
+  /* Voler chez les autres, en commençant par le suivant */
+  for (w = 1; ! found && w < sc->workers_count; ++w)
+    {
+      deque = sc->deques + (worker + w) % sc->workers_count;
+
+      pthread_mutex_lock (&deque->lock);
+      if (deque->head < deque->tail)
+	{
+	  *next = deque->tasks[--deque->tail];
+	  found = 1;
+	}
+      pthread_mutex_unlock (&deque->lock);
+    }
+
+  return found;
+}
+
+/*
+ * La tâche qui suit de 'distance' la prochaine tâche de la file du
+ * thread 'worker' (0: la prochaine), sans la prendre. Retourne 0 si la
+ * file est plus courte.
+ */
+int scheduler_ahead (scheduler *sc, int worker, int distance, task *ahead)
+{
+  task_deque *deque = sc->deques + worker;
+  int found;
+
+  pthread_mutex_lock (&deque->lock);
+  found = deque->head + distance < deque->tail;
+  if (found)
+    *ahead = deque->tasks[deque->head + distance];
+  pthread_mutex_unlock (&deque->lock);
+
+  return found;
+}
+
+/*
+ * Une itération du scénario 'scen' est terminée.
+ */
+void scheduler_done (scheduler *sc, int scen)
+{
+  pthread_mutex_lock (&sc->lock);
+  if (--sc->pending[scen] == 0)
+    pthread_cond_signal (&sc->finished);
+  pthread_mutex_unlock (&sc->lock);
+}
+
+/*
+ * Attend que le prochain scénario (dans l'ordre) soit terminé et retourne
+ * son rang, ou -1 lorsque tous les scénarios ont déjà été retournés. Les
+ * résultats sont donc toujours affichés dans le même ordre.
+ */
+int scheduler_wait (scheduler *sc)
+{
+  int scen;
+
+  if (sc->printed == sc->scenarios_count)
+    return -1;
+
+  pthread_mutex_lock (&sc->lock);
+  scen = sc->printed;
+  while (sc->pending[scen] > 0)
+    pthread_cond_wait (&sc->finished, &sc->lock);
+  pthread_mutex_unlock (&sc->lock);
+
+  sc->printed++;
+  return scen;
+}
+
+void scheduler_free (scheduler *sc)
+{
+  for (int w = 0; w < sc->workers_count; ++w)
+    {
+      pthread_mutex_destroy (&sc->deques[w].lock);
+      free (sc->deques[w].tasks);
+    }
+  free (sc->deques);
+  free (sc->pending);
+  pthread_mutex_destroy (&sc->lock);
+  pthread_cond_destroy (&sc->finished);
+}
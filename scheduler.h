@@ -0,0 +1,90 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Répartition du parsing: une tâche par fichier (scénario, itération),
+ * ou par tranche d'un gros fichier, prises par un nombre fixe de threads.
+ *
+ * Les tâches sont triées de la plus grosse à la plus petite (taille du
+ * fichier compressé) puis distribuées à tour de rôle dans une file par
+ * thread. Un thread prend d'abord la plus grosse tâche de sa propre
+ * file; lorsqu'elle est vide, il vole la plus petite tâche de la file
+ * d'un autre thread. Les grosses tâches sont donc commencées tôt, et les
+ * petites servent à équilibrer la fin.
+ *
+ * Sur un système de fichiers lent (--readahead), les tâches sont plutôt
+ * triées par inode: les fichiers voisins sur le disque (ou le serveur)
+ * sont lus ensemble, et les prochaines tâches de chaque file peuvent
+ * être lues d'avance (scheduler_ahead, prefetch.h).
+ *
+ * Le scheduler compte aussi les tâches terminées de chaque scénario, pour
+ * que ses résultats puissent être affichés dès qu'il est complet. Une
+ * itération sans tâche (déjà chargée) compte comme terminée.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <pthread.h>
+
+struct task
+{
+  int           scen;
+  int           iter;
+  int           chunk;  /* Tranche du fichier (-1: le fichier entier) */
+  long          size;
+  long          inode;
+};
+
+/* Ordre des tâches */
+enum schedule_orders {SCHEDULE_SIZE, SCHEDULE_INODE};
+
+struct task_deque
+{
+  pthread_mutex_t lock;
+  task          *tasks;
+  int           head;   /* Prochaine tâche du propriétaire (plus grosse) */
+  int           tail;   /* Après la tâche à voler (plus petite) */
+};
+
+struct scheduler
+{
+  task_deque    *deques;
+  int           workers_count;
+
+  /* Scénarios terminés */
+  pthread_mutex_t lock;
+  pthread_cond_t  finished;
+  int           *pending;       /* Tâches restantes de chaque scénario */
+  int           scenarios_count;
+  int           printed;
+};
+
+void  scheduler_init (scheduler *sc, int workers_count, task *tasks,
+		      int tasks_count, int scenarios_count, int order);
+
+int   scheduler_next (scheduler *sc, int worker, task *next);
+
+int   scheduler_ahead (scheduler *sc, int worker, int distance,
+		       task *ahead);
+
+void  scheduler_done (scheduler *sc, int scen);
+
+int   scheduler_wait (scheduler *sc);
+
+void  scheduler_free (scheduler *sc);
+
+#endif /* SCHEDULER_H */
@@ -0,0 +1,202 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdlib.h>
+#include <math.h>
+#include "stats.h"
+
+#define LANES 4  /* Sommes indépendantes d'une seule colonne */
+
+/*
+ * Ajoute 'value' à la somme compensée (Neumaier) 'sum' + 'comp'.
+ */
+static inline void neumaier (double *sum, double *comp, double value)
+{
+  double total = *sum + value;
+
+  *comp += fabs (*sum) >= fabs (value) ? (*sum - total) + value
+    : (value - total) + *sum;
+  *sum   = total;
+}
+
+/*
+ * La somme compensée. Une somme infinie rend la compensation NaN
+ * (inf - inf): elle est alors ignorée, comme dans une somme naïve.
+ */
+static inline double compensated (double sum, double comp)
+{
+  return isfinite (sum) ? sum + comp : sum;
+}
+
+void sums_init (column_sums *s, int columns_count)
+{
+  s->sums  = (double*) calloc (columns_count + 1, sizeof(double));
+  s->comps = (double*) calloc (columns_count + 1, sizeof(double));
+  s->m2    = (double*) calloc (columns_count + 1, sizeof(double));
+  s->columns_count = columns_count;
+  s->rows  = 0;
+}
+
+void sums_free (column_sums *s)
+{
+  free (s->sums);
+  free (s->comps);
+  free (s->m2);
+}
+
+/*
+ * Première passe: ajoute une ligne aux sommes. Les colonnes après
+ * 'count' (absentes de la ligne) valent 0.
+ */
+template <typename T>
+static void add_row (column_sums *s, const T *row, int count)
+{
+  double *sums  = s->sums;
+  double *comps = s->comps;
+
+#pragma omp simd
+  for (int c = 0; c < count; ++c)
+    neumaier (sums + c, comps + c, row[c]);
+  s->rows++;
+}
+
+/*
+ * Deuxième passe (une fois les moyennes connues): ajoute les carrés des
+ * écarts d'une ligne.
+ */
+template <typename T>
+static void dev_row (column_sums *s, const T *row, int count,
+		     const double *means)
+{
+  double *m2 = s->m2;
+  int c;
+
+#pragma omp simd
+  for (c = 0; c < count; ++c)
+    {
+      double delta = row[c] - means[c];
+      m2[c] += delta * delta;
+    }
+
+  for (c = count; c < s->columns_count; ++c)
+    m2[c] += means[c] * means[c];
+}
+
+void sums_add_f64 (column_sums *s, const double *row, int count)
+{
+  add_row (s, row, count);
+}
+
+void sums_add_u32 (column_sums *s, const unsigned int *row, int count)
+{
+  add_row (s, row, count);
+}
+
+void sums_means (const column_sums *s, double *means)
+{
+  for (int c = 0; c < s->columns_count; ++c)
+    means[c] = compensated (s->sums[c], s->comps[c]) / s->rows;
+}
+
+void sums_dev_f64 (column_sums *s, const double *row, int count,
+		   const double *means)
+{
+  dev_row (s, row, count, means);
+}
+
+void sums_dev_u32 (column_sums *s, const unsigned int *row, int count,
+		   const double *means)
+{
+  dev_row (s, row, count, means);
+}
+
+/*
+ * Écarts types (échantillon: n - 1).
+ */
+void sums_stds (const column_sums *s, double *stds)
+{
+  for (int c = 0; c < s->columns_count; ++c)
+    stds[c] = sqrt (s->m2[c] / (s->rows - 1));
+}
+
+/*
+ * Moyenne et écart type d'une seule colonne contiguë: quelques sommes
+ * indépendantes, réunies à la fin.
+ */
+void column_stats (const double *values, int count, double *mean,
+		   double *std)
+{
+  double sums [LANES] = { 0 }, comps [LANES] = { 0 }, m2 [LANES] = { 0 };
+  double sum = 0, comp = 0, delta;
+  int i, l;
+
+  for (i = 0; i + LANES <= count; i += LANES)
+    for (l = 0; l < LANES; ++l)
+      neumaier (sums + l, comps + l, values[i + l]);
+  for ( ; i < count; ++i)
+    neumaier (sums, comps, values[i]);
+
+  for (l = 0; l < LANES; ++l)
+    {
+      neumaier (&sum, &comp, sums[l]);
+      comp += comps[l];
+    }
+  *mean = compensated (sum, comp) / count;
+
+  for (i = 0; i + LANES <= count; i += LANES)
+    for (l = 0; l < LANES; ++l)
+      {
+	delta  = values[i + l] - *mean;
+	m2[l] += delta * delta;
+      }
+  for ( ; i < count; ++i)
+    {
+      delta  = values[i] - *mean;
+      m2[0] += delta * delta;
+    }
+
+  for (l = 1; l < LANES; ++l)
+    m2[0] += m2[l];
+  *std = sqrt (m2[0] / (count - 1));
+}
+
+/*
+ * Ajoute les valeurs de 'from' à 'into'.
+ */
+void welford_merge (welford *into, const welford *from)
+{
+  double count, delta;
+
+  if (! from->count)
+    return;
+
+  count = into->count + from->count;
+  delta = from->mean - into->mean;
+
+  into->mean += delta * (from->count / count);
+  into->m2   += from->m2 + delta * delta * (into->count * from->count
+						/ count);
+  into->count = count;
+}
+
+/*
+ * Moyenne et écart type (échantillon: n - 1).
+ */
+void welford_result (const welford *w, double *mean, double *std)
+{
+  *mean = w->mean;
+  *std  = sqrt (w->m2 / (w->count - 1));
+}
@@ -0,0 +1,87 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Moyennes et écarts types des résultats.
+ *
+ * Sur des itérations gardées en mémoire: deux passes (sommes, puis carrés
+ * des écarts à la moyenne) sur des lignes d'une valeur par colonne.
+ * Chaque passe parcourt les lignes de façon contiguë et traite toutes les
+ * colonnes à la fois (boucles vectorisées). Les sommes sont compensées
+ * (Neumaier): l'erreur d'arrondi ne croît pas avec le nombre
+ * d'itérations.
+ *
+ * En continu (Welford): le nombre de valeurs, leur moyenne et la somme
+ * des carrés des écarts à la moyenne, mis à jour une valeur à la fois.
+ * Deux accumulateurs se fusionnent exactement (Chan et al.): chaque
+ * thread peut garder les siens, qui sont réunis à la fin.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+/* Sommes de chaque colonne d'une suite de lignes */
+struct column_sums
+{
+  double        *sums;
+  double        *comps;  /* Compensation de chaque somme */
+  double        *m2;     /* Somme des carrés des écarts */
+  int           columns_count;
+  int           rows;
+};
+
+struct welford
+{
+  double        count;
+  double        mean;
+  double        m2;   /* Somme des carrés des écarts */
+};
+
+inline void welford_add (welford *w, double value)
+{
+  double delta = value - w->mean;
+
+  w->count += 1;
+  w->mean  += delta / w->count;
+  w->m2    += delta * (value - w->mean);
+}
+
+void  sums_init      (column_sums *s, int columns_count);
+
+void  sums_free      (column_sums *s);
+
+void  sums_add_f64   (column_sums *s, const double *row, int count);
+
+void  sums_add_u32   (column_sums *s, const unsigned int *row, int count);
+
+void  sums_means     (const column_sums *s, double *means);
+
+void  sums_dev_f64   (column_sums *s, const double *row, int count,
+		      const double *means);
+
+void  sums_dev_u32   (column_sums *s, const unsigned int *row, int count,
+		      const double *means);
+
+void  sums_stds      (const column_sums *s, double *stds);
+
+void  column_stats   (const double *values, int count, double *mean,
+		      double *std);
+
+void  welford_merge  (welford *into, const welford *from);
+
+void  welford_result (const welford *w, double *mean, double *std);
+
+#endif /* STATS_H */
@@ -0,0 +1,544 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "store.h"
+#include "reader.h"
+#include "field.h"
+#include "dictionary.h"
+
+/* Taille des valeurs d'une colonne selon son encodage */
+static uint64_t values_size (uint32_t encoding, uint64_t rows)
+{
+  switch (encoding)
+    {
+    case STORE_BITS:   return (rows + 63) / 64 * sizeof(uint64_t);
+    case STORE_CONST:  return rows ? sizeof(double) : 0;
+    case STORE_I32:    return rows * sizeof(int32_t);
+    case STORE_F64:    return rows * sizeof(double);
+    case STORE_DICT8:  return rows;
+    case STORE_DICT16: return rows * sizeof(uint16_t);
+    case STORE_DICT32: return rows * sizeof(uint32_t);
+    }
+  return UINT64_MAX;
+}
+
+static uint64_t header_hash (const store_header *header,
+			     const store_column *columns)
+{
+  uint64_t hash = cache_hash (header, offsetof(store_header, header_hash),
+			      0);
+  return cache_hash (columns, sizeof(store_column) * header->columns_count,
+		     hash);
+}
+
+static uint64_t column_hash (const char *data, const store_column *column,
+			     int rank)
+{
+  uint64_t hash = cache_hash (data + column->offset, column->size, rank);
+  return cache_hash (data + column->keys_offset, column->keys_size, hash);
+}
+
+/* Une valeur entière qui tient dans 32 bits (et n'est pas -0) */
+static inline int is_int32 (double value)
+{
+  return value >= INT32_MIN && value <= INT32_MAX
+    && value == (double) (int32_t) value
+    && ! (value == 0 && signbit (value));
+}
+
+/*
+ * Lit le fichier 'source' au complet (d'un coup si son texte ne dépasse
+ * pas 'whole_limit', voir inflate.h) et écrit son magasin de colonnes
+ * 'path'. Les colonnes 'bits' sont booléennes. Les lignes sont découpées
+ * comme lors du parsing: une ligne incomplète (et ce qui la suit) n'est
+ * pas transcodée, et sera signalée si le parsing en a besoin. Retourne 0
+ * si le fichier n'a pu être lu ou écrit.
+ */
+int store_transcode (const char *source, const char *path,
+		     const cache_stamp *stamp, const unsigned char *bits,
+		     int columns_count, size_t whole_limit)
+{
+  reader   rd;
+  char     *row, *field, *dump;
+  size_t   row_length;
+  uint32_t rows = 0;
+  double   value;
+  unsigned int id;
+  int      k, ok;
+
+  if (! reader_open (&rd, source, READER_BLOCK, whole_limit))
+    return 0;
+
+  /* Les valeurs de chaque colonne, et les identifiants tant que la
+   * colonne a peu de valeurs distinctes */
+  cache_buffer *values = (cache_buffer*) malloc (sizeof(cache_buffer)
+						 * (columns_count + 1));
+  cache_buffer *locals = (cache_buffer*) malloc (sizeof(cache_buffer)
+						 * (columns_count + 1));
+  dictionary   *dicts  = new dictionary [columns_count + 1];
+  dict_cache   *caches = (dict_cache*) malloc (sizeof(dict_cache)
+					       * (columns_count + 1));
+  unsigned char *encoded = (unsigned char*) malloc (columns_count + 1);
+
+  for (k = 0; k < columns_count; ++k)
+    {
+      cache_buffer_init (values + k);
+      cache_buffer_init (locals + k);
+      dictionary_init (dicts + k);
+      dict_cache_init (caches + k, dicts + k);
+      encoded[k] = ! bits[k];
+    }
+
+  /* L'en-tête */
+  reader_next (&rd, &row_length);
+
+  while ((row = reader_next (&rd, &row_length)) != NULL)
+    {
+      strtok_r (row, ",", &dump);
+
+      for (k = 0; k < columns_count; ++k)
+	{
+	  field = strtok_r (NULL, ",", &dump);
+	  if (field == NULL)
+	    break;
+
+	  if (bits[k])
+	    {
+	      unsigned char bit = is_true (field);
+	      cache_buffer_add (values + k, &bit, 1);
+	      continue;
+	    }
+
+	  if (encoded[k])
+	    {
+	      id = dict_cache_lookup (caches + k, field, strlen (field),
+				      &value);
+	      cache_buffer_add (locals + k, &id, sizeof(unsigned int));
+
+	      /* Trop de valeurs distinctes: valeurs numériques seulement */
+	      if (dicts[k].count > STORE_DICT_MAX)
+		{
+		  encoded[k] = 0;
+		  cache_buffer_free (locals + k);
+		}
+	    }
+	  else
+	    value = parse_number (field);
+
+	  cache_buffer_add (values + k, &value, sizeof(double));
+	}
+
+      /* Ligne incomplète: s'arrêter à la précédente */
+      if (k < columns_count)
+	{
+	  for (k = 0; k < columns_count; ++k)
+	    {
+	      values[k].size = bits[k] ? rows : rows * sizeof(double);
+	      if (encoded[k])
+		locals[k].size = rows * sizeof(unsigned int);
+	    }
+	  break;
+	}
+      rows++;
+    }
+  reader_close (&rd);
+
+  /* Encodage de chaque colonne */
+  store_header header;
+  store_column *columns = (store_column*) calloc (columns_count + 1,
+						  sizeof(store_column));
+  cache_buffer *blobs = (cache_buffer*) malloc (sizeof(cache_buffer)
+						* (columns_count + 1));
+  cache_buffer *keys  = (cache_buffer*) malloc (sizeof(cache_buffer)
+						* (columns_count + 1));
+  uint64_t offset;
+  uint32_t r, key_size;
+
+  for (k = 0; k < columns_count; ++k)
+    {
+      cache_buffer_init (blobs + k);
+      cache_buffer_init (keys + k);
+
+      const double       *nums = (const double*) values[k].data;
+      const unsigned int *ids  = (const unsigned int*) locals[k].data;
+
+      if (bits[k])
+	{
+	  uint64_t word = 0;
+
+	  columns[k].encoding = STORE_BITS;
+	  for (r = 0; r < rows; ++r)
+	    {
+	      word |= (uint64_t) (values[k].data[r] != 0) << (r & 63);
+	      if ((r & 63) == 63 || r == rows - 1)
+		{
+		  cache_buffer_add (blobs + k, &word, sizeof(uint64_t));
+		  word = 0;
+		}
+	    }
+	}
+      else if (encoded[k])
+	{
+	  columns[k].keys_count = dicts[k].count;
+	  columns[k].encoding   = dicts[k].count <= 256 ? STORE_DICT8
+	    : dicts[k].count <= 65536 ? STORE_DICT16 : STORE_DICT32;
+
+	  for (r = 0; r < rows; ++r)
+	    {
+	      uint8_t  id8  = ids[r];
+	      uint16_t id16 = ids[r];
+
+	      if (columns[k].encoding == STORE_DICT8)
+		cache_buffer_add (blobs + k, &id8, sizeof(id8));
+	      else if (columns[k].encoding == STORE_DICT16)
+		cache_buffer_add (blobs + k, &id16, sizeof(id16));
+	      else
+		cache_buffer_add (blobs + k, ids + r, sizeof(uint32_t));
+	    }
+
+	  for (id = 0; id < dicts[k].count; ++id)
+	    {
+	      key_size = strlen (dicts[k].keys[id]) + 1;
+	      cache_buffer_add (keys + k, &key_size, sizeof(uint32_t));
+	      cache_buffer_add (keys + k, dicts[k].keys[id], key_size);
+	    }
+	}
+      else
+	{
+	  int same = rows > 0, ints = 1;
+
+	  for (r = 0; r < rows; ++r)
+	    {
+	      same = same && ! memcmp (nums + r, nums, sizeof(double));
+	      ints = ints && is_int32 (nums[r]);
+	    }
+
+	  if (same)
+	    {
+	      columns[k].encoding = STORE_CONST;
+	      cache_buffer_add (blobs + k, nums, sizeof(double));
+	    }
+	  else if (ints)
+	    {
+	      columns[k].encoding = STORE_I32;
+	      for (r = 0; r < rows; ++r)
+		{
+		  int32_t num = (int32_t) nums[r];
+		  cache_buffer_add (blobs + k, &num, sizeof(int32_t));
+		}
+	    }
+	  else
+	    {
+	      columns[k].encoding = STORE_F64;
+	      cache_buffer_add (blobs + k, nums, sizeof(double) * rows);
+	    }
+	}
+    }
+
+  /* Position de chaque colonne, alignée */
+  memset (&header, 0, sizeof(header));
+  memcpy (header.magic, STORE_MAGIC, sizeof(header.magic));
+  header.version       = STORE_VERSION;
+  header.endian        = CACHE_ENDIAN;
+  header.source        = *stamp;
+  header.rows          = rows;
+  header.columns_count = columns_count;
+
+  offset = sizeof(header) + sizeof(store_column) * columns_count;
+  for (k = 0; k < columns_count; ++k)
+    {
+      offset = (offset + CACHE_ALIGN - 1) / CACHE_ALIGN * CACHE_ALIGN;
+      columns[k].offset      = offset;
+      columns[k].size        = blobs[k].size;
+      columns[k].keys_offset = offset + blobs[k].size;
+      columns[k].keys_size   = keys[k].size;
+      offset += blobs[k].size + keys[k].size;
+
+      columns[k].hash = cache_hash (keys[k].data, keys[k].size,
+				    cache_hash (blobs[k].data, blobs[k].size,
+						k));
+    }
+  header.file_size   = offset;
+  header.header_hash = header_hash (&header, columns);
+
+  /* Fichier temporaire renommé une fois complet. Pas de fsync: un
+   * magasin incomplet après une panne ne passe pas les hashs. */
+  static const char padding [CACHE_ALIGN] = { 0 };
+  size_t tmp_size = strlen (path) + 32;
+  char  *tmp_path = (char*) malloc (tmp_size);
+  snprintf (tmp_path, tmp_size, "%s.tmp.%ld", path, (long) getpid ());
+
+  FILE *pStore = fopen (tmp_path, "wb");
+  ok = pStore != NULL;
+
+  if (ok)
+    {
+      ok = fwrite (&header, sizeof(header), 1, pStore) == 1
+	&& fwrite (columns, sizeof(store_column), columns_count, pStore)
+	== (size_t) columns_count;
+      offset = sizeof(header) + sizeof(store_column) * columns_count;
+
+      for (k = 0; k < columns_count && ok; ++k)
+	{
+	  ok = fwrite (padding, 1, columns[k].offset - offset, pStore)
+	    == columns[k].offset - offset;
+	  if (blobs[k].size)
+	    ok = ok && fwrite (blobs[k].data, blobs[k].size, 1, pStore) == 1;
+	  if (keys[k].size)
+	    ok = ok && fwrite (keys[k].data, keys[k].size, 1, pStore) == 1;
+	  offset = columns[k].keys_offset + keys[k].size;
+	}
+
+      ok = fclose (pStore) == 0 && ok;
+      ok = ok && rename (tmp_path, path) == 0;
+      if (! ok)
+	remove (tmp_path);
+    }
+  free (tmp_path);
+
+  for (k = 0; k < columns_count; ++k)
+    {
+      cache_buffer_free (values + k);
+      cache_buffer_free (locals + k);
+      cache_buffer_free (blobs + k);
+      cache_buffer_free (keys + k);
+      dict_cache_free (caches + k);
+      dictionary_free (dicts + k);
+    }
+  free (values);
+  free (locals);
+  free (blobs);
+  free (keys);
+  free (caches);
+  free (encoded);
+  free (columns);
+  delete [] dicts;
+
+  return ok;
+}
+
+/*
+ * Le magasin 'path' existe et correspond encore au fichier d'origine
+ * (en-tête seulement: les hashs sont vérifiés par store_open).
+ */
+int store_current (const char *path, const cache_stamp *stamp)
+{
+  store_header header;
+  struct stat file_stat;
+  int fd, ok;
+
+  fd = open (path, O_RDONLY);
+  if (fd < 0)
+    return 0;
+
+  ok = ! fstat (fd, &file_stat)
+    && pread (fd, &header, sizeof(header), 0) == sizeof(header)
+    && ! memcmp (header.magic, STORE_MAGIC, sizeof(header.magic))
+    && header.version == STORE_VERSION
+    && header.endian == CACHE_ENDIAN
+    && ! memcmp (&header.source, stamp, sizeof(cache_stamp))
+    && header.file_size == (uint64_t) file_stat.st_size;
+
+  close (fd);
+  return ok;
+}
+
+/*
+ * Projette le magasin 'path' s'il correspond au fichier d'origine
+ * ('stamp') et a le bon nombre de colonnes. Le hash des colonnes 'used'
+ * (toutes si NULL) est vérifié. Retourne 0 si le magasin est inutilisable.
+ */
+int store_open (store *st, const char *path, const cache_stamp *stamp,
+		int columns_count, const unsigned char *used)
+{
+  struct stat file_stat;
+  int fd, k, ok;
+
+  st->map.data = NULL;
+  st->map.size = 0;
+
+  fd = open (path, O_RDONLY);
+  if (fd < 0)
+    return 0;
+
+  if (fstat (fd, &file_stat) || file_stat.st_size < (off_t)
+      sizeof(store_header))
+    {
+      close (fd);
+      return 0;
+    }
+
+  void *data = mmap (NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd,
+		     0);
+  close (fd);
+
+  if (data == MAP_FAILED)
+    return 0;
+
+  st->map.data = (char*) data;
+  st->map.size = file_stat.st_size;
+  st->header   = (const store_header*) data;
+  st->columns  = (const store_column*) (st->header + 1);
+
+  const store_header *header = st->header;
+
+  ok = ! memcmp (header->magic, STORE_MAGIC, sizeof(header->magic))
+    && header->version == STORE_VERSION
+    && header->endian == CACHE_ENDIAN
+    && ! memcmp (&header->source, stamp, sizeof(cache_stamp))
+    && header->columns_count == (uint32_t) columns_count
+    && header->file_size == st->map.size
+    && sizeof(store_header) + sizeof(store_column) * columns_count
+    <= st->map.size
+    && header->header_hash == header_hash (header, st->columns);
+
+  for (k = 0; k < columns_count && ok; ++k)
+    {
+      const store_column *column = st->columns + k;
+
+      ok = column->offset % CACHE_ALIGN == 0
+	&& column->size == values_size (column->encoding, header->rows)
+	&& column->offset <= st->map.size
+	&& column->size <= st->map.size - column->offset
+	&& column->keys_offset == column->offset + column->size
+	&& column->keys_size <= st->map.size - column->keys_offset;
+
+      if (! ok || (used != NULL && ! used[k]))
+	continue;
+
+      ok = column_hash (st->map.data, column, k) == column->hash;
+
+      /* Le dictionnaire doit avoir exactement ses valeurs */
+      if (ok && column->encoding >= STORE_DICT8)
+	{
+	  const char *keys = st->map.data + column->keys_offset;
+	  const char *end  = keys + column->keys_size;
+	  uint32_t key_size, i;
+
+	  for (i = 0; i < column->keys_count && ok; ++i)
+	    {
+	      ok = end - keys >= (long) sizeof(uint32_t);
+	      if (! ok)
+		break;
+	      memcpy (&key_size, keys, sizeof(uint32_t));
+	      keys += sizeof(uint32_t);
+	      ok = key_size > 0 && key_size <= (uint64_t) (end - keys)
+		&& keys[key_size - 1] == '\0';
+	      keys += ok ? key_size : 0;
+	    }
+	  ok = ok && keys == end;
+	}
+      else if (ok)
+	ok = column->keys_size == 0;
+    }
+
+  if (! ok)
+    store_close (st);
+  return ok;
+}
+
+int store_is_dict (const store *st, int column)
+{
+  return st->columns[column].encoding >= STORE_DICT8;
+}
+
+/*
+ * Valeurs du dictionnaire d'une colonne, dans l'ordre des identifiants.
+ * Retourne leur nombre.
+ */
+unsigned int store_keys (const store *st, int column, const char **keys)
+{
+  const store_column *col = st->columns + column;
+  const char *pos = st->map.data + col->keys_offset;
+  uint32_t key_size;
+
+  for (unsigned int i = 0; i < col->keys_count; ++i)
+    {
+      memcpy (&key_size, pos, sizeof(uint32_t));
+      keys[i] = pos + sizeof(uint32_t);
+      pos    += sizeof(uint32_t) + key_size;
+    }
+  return col->keys_count;
+}
+
+/*
+ * Valeurs des individus [first, first + rows) d'une colonne. Pour un
+ * dictionnaire, 'nums' donne la valeur numérique de chaque identifiant;
+ * les identifiants (propres au magasin) vont dans 'ids' s'il n'est pas
+ * NULL.
+ */
+void store_decode (const store *st, int column, int first, int rows,
+		   const double *nums, double *values, unsigned int *ids)
+{
+  const store_column *col = st->columns + column;
+  const char *data = st->map.data + col->offset;
+  unsigned int id;
+  int r, i;
+
+  switch (col->encoding)
+    {
+    case STORE_BITS:
+      for (r = 0; r < rows; ++r)
+	{
+	  i = first + r;
+	  values[r] = (((const uint64_t*) data)[i >> 6] >> (i & 63)) & 1;
+	}
+      break;
+
+    case STORE_CONST:
+      for (r = 0; r < rows; ++r)
+	values[r] = *(const double*) data;
+      break;
+
+    case STORE_I32:
+      for (r = 0; r < rows; ++r)
+	values[r] = ((const int32_t*) data)[first + r];
+      break;
+
+    case STORE_F64:
+      memcpy (values, (const double*) data + first, sizeof(double) * rows);
+      break;
+
+    default:
+      for (r = 0; r < rows; ++r)
+	{
+	  if (col->encoding == STORE_DICT8)
+	    id = ((const uint8_t*) data)[first + r];
+	  else if (col->encoding == STORE_DICT16)
+	    id = ((const uint16_t*) data)[first + r];
+	  else
+	    id = ((const uint32_t*) data)[first + r];
+
+	  values[r] = nums[id];
+	  if (ids != NULL)
+	    ids[r] = id;
+	}
+      break;
+    }
+}
+
+void store_close (store *st)
+{
+  cache_close (&st->map);
+}
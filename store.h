@@ -0,0 +1,116 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Magasin de colonnes: chaque fichier N_Output.gz peut être transcodé une
+ * fois pour toutes en un fichier binaire, une colonne par variable. Les
+ * analyses suivantes (peu importe la configuration) projettent ce fichier
+ * en mémoire et ne lisent que les colonnes dont elles ont besoin, sans
+ * décompression ni conversion de texte.
+ *
+ * Chaque colonne a son propre encodage:
+ *   - variables booléennes: un bit par individu;
+ *   - autres variables, si elles ont peu de valeurs distinctes: un
+ *     dictionnaire des valeurs (texte) et un identifiant de 1, 2 ou 4
+ *     octets par individu. Une telle colonne peut servir de variable
+ *     discrète ou accumulatrice;
+ *   - sinon, les valeurs numériques: une seule si elles sont toutes
+ *     égales, des entiers de 32 bits si elles sont toutes entières, des
+ *     doubles autrement. Une telle colonne ne peut servir de variable
+ *     discrète: le fichier est alors relu en texte.
+ *
+ * L'en-tête garde l'empreinte (cache.h) du fichier d'origine: un magasin
+ * dont l'empreinte ne correspond plus est ignoré, puis refait au prochain
+ * transcodage. Chaque colonne a son hash, vérifié seulement si la colonne
+ * est utilisée.
+ */
+
+#ifndef STORE_H
+#define STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cache.h"
+
+#define STORE_MAGIC    "ANALCOL"  /* 8 octets avec le NUL */
+#define STORE_VERSION  1
+#define STORE_DICT_MAX 4096       /* Valeurs distinctes d'un dictionnaire */
+
+enum store_encodings
+  {
+    STORE_BITS,
+    STORE_CONST,
+    STORE_I32,
+    STORE_F64,
+    STORE_DICT8,
+    STORE_DICT16,
+    STORE_DICT32
+  };
+
+struct store_column
+{
+  uint32_t      encoding;
+  uint32_t      keys_count;   /* Dictionnaire: nombre de valeurs */
+  uint64_t      offset;       /* Valeurs (ou identifiants) */
+  uint64_t      size;
+  uint64_t      keys_offset;  /* Dictionnaire: taille (NUL compris), puis
+			       * texte de chaque valeur */
+  uint64_t      keys_size;
+  uint64_t      hash;         /* Valeurs et dictionnaire */
+};
+
+struct store_header
+{
+  char          magic [8];
+  uint32_t      version;
+  uint32_t      endian;
+  cache_stamp   source;       /* Empreinte du fichier d'origine */
+  uint32_t      rows;
+  uint32_t      columns_count;
+  uint64_t      file_size;
+  uint64_t      header_hash;  /* En-tête, puis répertoire des colonnes */
+};
+
+/* Magasin projeté en mémoire */
+struct store
+{
+  cache_map     map;
+  const store_header *header;
+  const store_column *columns;
+};
+
+int       store_transcode (const char *source, const char *path,
+			   const cache_stamp *stamp,
+			   const unsigned char *bits, int columns_count,
+			   size_t whole_limit);
+
+int       store_current   (const char *path, const cache_stamp *stamp);
+
+int       store_open      (store *st, const char *path,
+			   const cache_stamp *stamp, int columns_count,
+			   const unsigned char *used);
+
+int       store_is_dict   (const store *st, int column);
+
+unsigned int store_keys   (const store *st, int column, const char **keys);
+
+void      store_decode    (const store *st, int column, int first,
+			   int rows, const double *nums, double *values,
+			   unsigned int *ids);
+
+void      store_close     (store *st);
+
+#endif /* STORE_H */
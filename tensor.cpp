@@ -0,0 +1,95 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "tensor.h"
+#include "stats.h"
+
+void tensor_init (tensor *t, int type, void *data, const int *first_files,
+		  int columns_count)
+{
+  t->data          = (char*) data;
+  t->type          = type;
+  t->first_files   = first_files;
+  t->columns_count = columns_count;
+}
+
+/*
+ * Alloué sur le monceau pour ne pas risquer de faire exploser la pile
+ * dans les grosses simulations (plusieurs scénarios, plusieurs
+ * variables, etc.)
+ */
+void tensor_alloc (tensor *t, int type, int files_count,
+		   const int *first_files, int columns_count)
+{
+  tensor_init (t, type, NULL, first_files, columns_count);
+  t->data = (char*) malloc (tensor_size (t, files_count) + 1);
+
+  if (t->data == NULL)
+    {
+      puts("Mémoire insuffisante.");
+      exit(1);
+    }
+}
+
+/*
+ * Moyenne et écart type de chaque colonne sur les itérations du scénario
+ * 'scen': deux passes sur ses lignes, toutes les colonnes à la fois.
+ */
+void tensor_stats (const tensor *t, int scen, double *means, double *stds)
+{
+  column_sums sums;
+  int first = tensor_file (t, scen, 0);
+  int last  = first + tensor_iters (t, scen);
+  int v;
+
+  sums_init (&sums, t->columns_count);
+
+  for (v = first; v < last; ++v)
+    if (t->type == TENSOR_F64)
+      sums_add_f64 (&sums, tensor_f64 (t, v), t->columns_count);
+    else
+      sums_add_u32 (&sums, tensor_u32 (t, v), t->columns_count);
+
+  sums_means (&sums, means);
+
+  for (v = first; v < last; ++v)
+    if (t->type == TENSOR_F64)
+      sums_dev_f64 (&sums, tensor_f64 (t, v), t->columns_count, means);
+    else
+      sums_dev_u32 (&sums, tensor_u32 (t, v), t->columns_count, means);
+
+  sums_stds (&sums, stds);
+  sums_free (&sums);
+}
+
+/*
+ * Recopie (en double) une colonne de 'rows' lignes consécutives à partir
+ * du fichier 'first', pour les calculs globaux.
+ */
+void tensor_column (const tensor *t, int first, int column, int rows,
+		    double *values)
+{
+  int v;
+
+  if (t->type == TENSOR_F64)
+    for (v = 0; v < rows; ++v)
+      values[v] = tensor_f64 (t, first + v)[column];
+  else
+    for (v = 0; v < rows; ++v)
+      values[v] = tensor_u32 (t, first + v)[column];
+}
@@ -0,0 +1,110 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Tenseurs de résultats: une valeur par fichier (scénario, itération) et
+ * par colonne (variable, calcul ou expression). Les valeurs d'un fichier
+ * forment une ligne contiguë, et les lignes d'un scénario se suivent:
+ * [scénario][itération][colonne] (CACHE_LAYOUT_SCEN_ITER_VAR). C'est la
+ * disposition du fichier binaire, qui peut donc servir de tenseur sur
+ * place. Le nombre d'itérations peut varier d'un scénario à l'autre.
+ *
+ * Les statistiques d'un scénario sont calculées pour toutes ses colonnes
+ * à la fois, ligne par ligne (stats.h): les accès restent contigus sans
+ * transposition.
+ */
+
+#ifndef TENSOR_H
+#define TENSOR_H
+
+#include <stddef.h>
+
+enum tensor_types
+  {
+    TENSOR_F64,  /* double */
+    TENSOR_U32   /* unsigned int */
+  };
+
+struct tensor
+{
+  char          *data;
+  int           type;
+  int           columns_count;
+  const int     *first_files; /* Rang du premier fichier de chaque
+			       * scénario, puis le nombre de fichiers
+			       * (NULL: les lignes ne sont accessibles que
+			       * par leur rang de fichier) */
+};
+
+void  tensor_init  (tensor *t, int type, void *data,
+		    const int *first_files, int columns_count);
+
+void  tensor_alloc (tensor *t, int type, int files_count,
+		    const int *first_files, int columns_count);
+
+void  tensor_stats (const tensor *t, int scen, double *means,
+		    double *stds);
+
+void  tensor_column (const tensor *t, int first, int column, int rows,
+		     double *values);
+
+inline size_t tensor_elem_size (const tensor *t)
+{
+  return t->type == TENSOR_F64 ? sizeof(double) : sizeof(unsigned int);
+}
+
+/* Taille (octets) des lignes de 'files_count' fichiers */
+inline size_t tensor_size (const tensor *t, int files_count)
+{
+  return tensor_elem_size (t) * files_count * t->columns_count;
+}
+
+/* Rang de fichier d'une itération d'un scénario */
+inline int tensor_file (const tensor *t, int scen, int iter)
+{
+  return t->first_files[scen] + iter;
+}
+
+/* Nombre d'itérations d'un scénario */
+inline int tensor_iters (const tensor *t, int scen)
+{
+  return t->first_files[scen + 1] - t->first_files[scen];
+}
+
+/* La ligne d'un fichier */
+inline void *tensor_row (const tensor *t, int file)
+{
+  return t->data + tensor_size (t, file);
+}
+
+inline double *tensor_f64 (const tensor *t, int file)
+{
+  return (double*) tensor_row (t, file);
+}
+
+inline unsigned int *tensor_u32 (const tensor *t, int file)
+{
+  return (unsigned int*) tensor_row (t, file);
+}
+
+/* Une valeur, peu importe le type */
+inline double tensor_get (const tensor *t, int file, int column)
+{
+  return t->type == TENSOR_F64 ? tensor_f64 (t, file)[column]
+    : tensor_u32 (t, file)[column];
+}
+
+#endif /* TENSOR_H */
@@ -0,0 +1,83 @@
+#!/bin/bash
+
+# Test de "make check": un gros fichier de résultats doit donner les mêmes
+# totaux quelle que soit la façon dont il est lu: d'un bout à l'autre à la
+# première analyse (qui construit son index d'accès), en tranches aux
+# points de cet index ensuite, d'un seul bloc (--inflate=whole), au fil de
+# l'eau (--streaming), ou à partir de son magasin de colonnes
+# (--transcode).
+#
+# Le fichier (environ 36 Mo de texte, quatre points d'index au moins)
+# commence par 1e16 et finit par -1e16, avec des 0.5 entre les deux: le
+# total dépend de l'endroit où se ferment les sommes partielles. Toutes
+# les lectures doivent donc les fermer aux mêmes individus.
+#
+# Usage: test_index.sh [programme Analyse]
+
+analyse=${1:-./Analyse}
+population=3000000
+
+projet=$(mktemp -d) || exit 1
+trap 'rm -rf "$projet"' EXIT
+
+mkdir -p "$projet/Results/S0" "$projet/Analyse"
+
+awk -v n=$population 'BEGIN {
+    print "Id,X"
+    print "0,10000000000000000"
+    for (i = 1; i < n - 1; ++i)
+        print i ",0.5"
+    print n - 1 ",-10000000000000000"
+}' | gzip -1 > "$projet/Results/S0/0_Output.gz"
+
+printf '<?xml version="1.0"?>\n<Population size="%d">\n' $population \
+    > "$projet/summary"
+printf '  <Variable label="X" type="x"/>\n</Population>\n' >> "$projet/summary"
+gzip -c "$projet/summary" > "$projet/Results/S0/0_Summary.gz"
+
+printf '[calculs (global)]\ntotal = "X" * 1\n' > "$projet/test.conf"
+
+# Une analyse, sans le cache des résultats, comparée à la première
+echec=0
+lancer ()
+{
+    rm -f "$projet/Analyse/test.aux"
+    "$analyse" "$@" "$projet/" "$projet/test.conf" 1 2 S0 \
+        > "$projet/sortie.txt" || exit 1
+
+    if [ -f "$projet/reference.txt" ]
+    then
+        if ! diff "$projet/reference.txt" "$projet/sortie.txt"
+        then
+            echo "Résultats différents (options: $*)"
+            echec=1
+        fi
+    else
+        mv "$projet/sortie.txt" "$projet/reference.txt"
+    fi
+}
+
+# Première analyse: l'index est construit
+lancer
+
+if [ ! -f "$projet/Analyse/Index/S0/0_Output.idx" ]
+then
+    echo "Index non construit"
+    exit 1
+fi
+
+# Analyses suivantes: le fichier est découpé, ou lu d'un seul bloc
+lancer
+lancer --inflaters=2
+lancer --batch=3
+lancer --inflate=whole
+lancer --streaming
+lancer --prefetchers=2
+
+# Le magasin de colonnes est écrit, puis lu
+lancer --transcode
+lancer
+lancer --batch=3
+
+[ $echec -eq 0 ] && echo "Lectures: résultats identiques"
+exit $echec